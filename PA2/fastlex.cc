@@ -0,0 +1,640 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  fastlex.cc
+//
+//  The hand-written scanner declared in fastlex.h.  Each rule of
+//  cool.flex is noted where it is implemented; where the flex rules
+//  behave oddly (an escape that is not length-checked, a backslash
+//  before a newline) this scanner does the same thing on purpose, so
+//  that the two can be compared token for token.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cool-parse.h"
+#include "stringtab.h"
+#include "utilities.h"
+#include "fastlex.h"
+#include "keywords.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+extern int curr_lineno;
+extern YYSTYPE cool_yylval;
+
+#define MAX_STR_CONST 1025
+
+static char *buf;           // the input, followed by PAD zero bytes
+static char *pos;           // next unscanned character
+static char *end;           // end of the input
+static char *tok;           // start of the last token returned
+static size_t map_size;     // bytes mapped at buf, or 0 if buf is malloc'd
+static char string_buf[MAX_STR_CONST];
+static char unmatched[2];   // the text of an unmatched character
+static int resume_level;    // comment nesting to pick up at pos, if any
+
+void (*fast_lex_comment_line)(const LexPoint& p);
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  Vector primitives
+//
+//  A vector holds VLEN bytes; the mask functions return one bit per
+//  byte, bit i for p[i].  VLEN is a macro, not an enum constant, because
+//  the scanning loops choose their code with #if VLEN > 1.  Loads may read up to VLEN - 1 bytes past the
+//  end of the input, which is why the buffer is padded.  Byte ranges
+//  are tested with signed compares, which is enough because every range
+//  we test lies within ASCII and non-ASCII bytes compare as negative.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#if defined(__AVX2__)
+
+typedef __m256i vec;
+#define VLEN 32
+static inline vec vload(const char *p)      { return _mm256_loadu_si256((const __m256i *) p); }
+static inline vec vset(char c)              { return _mm256_set1_epi8(c); }
+static inline vec veq(vec a, vec b)         { return _mm256_cmpeq_epi8(a, b); }
+static inline vec vgt(vec a, vec b)         { return _mm256_cmpgt_epi8(a, b); }
+static inline vec vor(vec a, vec b)         { return _mm256_or_si256(a, b); }
+static inline vec vand(vec a, vec b)        { return _mm256_and_si256(a, b); }
+static inline unsigned vmask(vec a)         { return (unsigned) _mm256_movemask_epi8(a); }
+
+#elif defined(__SSE2__)
+
+typedef __m128i vec;
+#define VLEN 16
+static inline vec vload(const char *p)      { return _mm_loadu_si128((const __m128i *) p); }
+static inline vec vset(char c)              { return _mm_set1_epi8(c); }
+static inline vec veq(vec a, vec b)         { return _mm_cmpeq_epi8(a, b); }
+static inline vec vgt(vec a, vec b)         { return _mm_cmpgt_epi8(a, b); }
+static inline vec vor(vec a, vec b)         { return _mm_or_si128(a, b); }
+static inline vec vand(vec a, vec b)        { return _mm_and_si128(a, b); }
+static inline unsigned vmask(vec a)         { return (unsigned) _mm_movemask_epi8(a); }
+
+#else
+
+#define VLEN 1
+
+#endif
+
+enum { PAD = 32 };
+
+#if defined(__AVX2__) || defined(__SSE2__)
+
+static const unsigned ALL = (VLEN == 32) ? 0xffffffffu : 0xffffu;
+
+// lo <= c <= hi, for ASCII lo and hi
+static inline vec vin(vec c, char lo, char hi)
+{
+  return vand(vgt(c, vset(lo - 1)), vgt(vset(hi + 1), c));
+}
+
+// [ \t\n\v\f\r]
+static inline unsigned space_mask(const char *p)
+{
+  vec c = vload(p);
+  return vmask(vor(veq(c, vset(' ')), vin(c, '\t', '\r')));
+}
+
+// [a-zA-Z0-9_]
+static inline unsigned alnum_mask(const char *p)
+{
+  vec c = vload(p);
+  vec lower = vor(c, vset(0x20));
+  return vmask(vor(vor(vin(lower, 'a', 'z'), vin(c, '0', '9')),
+		   veq(c, vset('_'))));
+}
+
+static inline unsigned digit_mask(const char *p)
+{
+  return vmask(vin(vload(p), '0', '9'));
+}
+
+// the characters that end a run inside a comment: ( * \n
+static inline unsigned comment_stop_mask(const char *p)
+{
+  vec c = vload(p);
+  return vmask(vor(vor(veq(c, vset('(')), veq(c, vset('*'))),
+		   veq(c, vset('\n'))));
+}
+
+// the characters that end a run inside a string: " \ \n \0
+static inline unsigned string_stop_mask(const char *p)
+{
+  vec c = vload(p);
+  return vmask(vor(vor(veq(c, vset('"')), veq(c, vset('\\'))),
+		   vor(veq(c, vset('\n')), veq(c, vset('\0')))));
+}
+
+#endif
+
+static inline bool is_space(char c)
+{
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline bool is_alnum(char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+static inline bool is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+//
+// [ \f\r\t\v]+ and \n: skip whitespace from p, counting newlines.  The
+// zero byte at end stops the scan.
+//
+static char *skip_space(char *p)
+{
+#if VLEN > 1
+  for (;;) {
+    unsigned sp = space_mask(p);
+    unsigned nl = vmask(veq(vload(p), vset('\n')));
+    if (sp == ALL) {
+      curr_lineno += __builtin_popcount(nl);
+      p += VLEN;
+      continue;
+    }
+    int n = __builtin_ctz(~sp);
+    curr_lineno += __builtin_popcount(nl & ((1u << n) - 1));
+    return p + n;
+  }
+#else
+  for (; is_space(*p); p++)
+    if (*p == '\n')
+      curr_lineno++;
+  return p;
+#endif
+}
+
+//
+// The end of the identifier characters starting at p.  The padding
+// zeros stop the scan at end.
+//
+static char *skip_alnum(char *p)
+{
+#if VLEN > 1
+  for (;;) {
+    unsigned m = alnum_mask(p);
+    if (m != ALL)
+      return p + __builtin_ctz(~m);
+    p += VLEN;
+  }
+#else
+  while (is_alnum(*p))
+    p++;
+  return p;
+#endif
+}
+
+static char *skip_digits(char *p)
+{
+#if VLEN > 1
+  for (;;) {
+    unsigned m = digit_mask(p);
+    if (m != ALL)
+      return p + __builtin_ctz(~m);
+    p += VLEN;
+  }
+#else
+  while (is_digit(*p))
+    p++;
+  return p;
+#endif
+}
+
+//
+// The first character at or after p that matters inside a comment, or
+// end.
+//
+static char *find_comment_stop(char *p)
+{
+#if VLEN > 1
+  for (; p < end; p += VLEN) {
+    unsigned m = comment_stop_mask(p);
+    if (m) {
+      p += __builtin_ctz(m);
+      return p < end ? p : end;
+    }
+  }
+  return end;
+#else
+  while (p < end && *p != '(' && *p != '*' && *p != '\n')
+    p++;
+  return p;
+#endif
+}
+
+//
+// The first character at or after p that matters inside a string, or
+// end.  A zero byte is only a stop if it is part of the input.
+//
+static char *find_string_stop(char *p)
+{
+#if VLEN > 1
+  for (; p < end; p += VLEN) {
+    unsigned m = string_stop_mask(p);
+    if (m) {
+      p += __builtin_ctz(m);
+      return p < end ? p : end;
+    }
+  }
+  return end;
+#else
+  while (p < end && *p != '"' && *p != '\\' && *p != '\n' && *p != '\0')
+    p++;
+  return p;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  Comments and strings
+//
+/////////////////////////////////////////////////////////////////////////
+
+//
+// <COMMENT> rules: pos is inside a comment, level deep, which began at
+// tok; at first just after the opening "(*".  Returns 0 when the
+// comment is closed, or ERROR at end of input.
+//
+static int scan_comment(int level)
+{
+  char *p = pos;
+
+  for (;;) {
+    p = find_comment_stop(p);
+    if (p == end) {
+      pos = end;
+      cool_yylval.error_msg = "EOF in comment";
+      return ERROR;
+    }
+    if (*p == '\n') {
+      curr_lineno++;
+      p++;
+      if (fast_lex_comment_line) {
+	LexPoint lp = { (int) (p - buf), curr_lineno, level, (int) (tok - buf) };
+	fast_lex_comment_line(lp);
+      }
+    } else if (p[0] == '(' && p[1] == '*') {
+      level++;
+      p += 2;
+    } else if (p[0] == '*' && p[1] == ')') {
+      p += 2;
+      if (--level == 0) {
+	pos = p;
+	return 0;
+      }
+    } else
+      p++;
+  }
+}
+
+//
+// <STRING> rules: pos is just after the opening quote.  Ordinary
+// characters are length checked one at a time by flex; here whole runs
+// are checked at once, and only the run that crosses the limit is
+// split.  Escapes are not length checked, as in cool.flex, though they
+// are never written past the buffer.  After an error the scanner is
+// back in INITIAL just after the offending character.
+//
+// Until the first escape the string's text is the input itself, so a
+// string without escapes is interned straight from the input and
+// string_buf is only filled once an escape needs it.
+//
+static int scan_string()
+{
+  int len = 0;
+  char *p = pos;
+  bool copied = false;      // does string_buf hold the text so far?
+
+  for (;;) {
+    char *stop = find_string_stop(p);
+
+    // <STRING>. for each character of the run
+    int run = stop - p;
+    if (run > 0) {
+      int room = MAX_STR_CONST - 1 - len;
+      if (room < 0)
+	room = 0;
+      if (run > room) {
+	pos = p + room + 1;
+	cool_yylval.error_msg = "String constant too long";
+	return ERROR;
+      }
+      if (copied)
+	memcpy(string_buf + len, p, run);
+      len += run;
+    }
+    p = stop;
+
+    if (p == end) {
+      // <STRING><<EOF>>
+      pos = end;
+      cool_yylval.error_msg = "EOF in string constant";
+      return ERROR;
+    }
+
+    switch (*p) {
+    case '"':
+      // <STRING>\"
+      pos = p + 1;
+      if (len >= MAX_STR_CONST - 1) {
+	cool_yylval.error_msg = "String constant too long";
+	return ERROR;
+      }
+      if (!copied) {
+	cool_yylval.symbol = stringtable.add_string(pos - 1 - len, len);
+	return STR_CONST;
+      }
+      string_buf[len] = '\0';
+      cool_yylval.symbol = stringtable.add_string(string_buf);
+      return STR_CONST;
+
+    case '\n':
+      // <STRING>\n
+      curr_lineno++;
+      pos = p + 1;
+      cool_yylval.error_msg = "Unterminated string constant";
+      return ERROR;
+
+    case '\0':
+      // <STRING>. on a null character
+      pos = p + 1;
+      cool_yylval.error_msg = "String contains null character.";
+      return ERROR;
+
+    case '\\':
+      if (!copied) {
+	memcpy(string_buf, p - len, len);
+	copied = true;
+      }
+      if (p + 1 == end || p[1] == '\n') {
+	// \\. cannot match, so the backslash is an ordinary character
+	if (len >= MAX_STR_CONST - 1) {
+	  pos = p + 1;
+	  cool_yylval.error_msg = "String constant too long";
+	  return ERROR;
+	}
+	string_buf[len++] = '\\';
+	p++;
+	break;
+      }
+      {
+	char c = p[1];
+	switch (c) {
+	case 'n': c = '\n'; break;
+	case 't': c = '\t'; break;
+	case 'b': c = '\b'; break;
+	case 'f': c = '\f'; break;
+	}
+	if (len < MAX_STR_CONST - 1)
+	  string_buf[len] = c;
+	len++;
+	p += 2;
+      }
+      break;
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  The scanner
+//
+/////////////////////////////////////////////////////////////////////////
+
+//
+// Map a regular file, or read anything else (a pipe, say) into memory.
+// The scanner reads up to PAD bytes past the end of the input, which
+// must be zeros.  A mapping is followed by zero-filled anonymous pages
+// for that: the whole range is reserved first and the file is then
+// mapped over the front of it.
+//
+static bool map_input(int fd, size_t n)
+{
+  long page = sysconf(_SC_PAGESIZE);
+  size_t size = (n + PAD + page - 1) / page * page;
+  void *area = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (area == MAP_FAILED)
+    return false;
+  if (mmap(area, n, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+    munmap(area, size);
+    return false;
+  }
+  madvise(area, n, MADV_SEQUENTIAL);
+  buf = (char *) area;
+  map_size = size;
+  end = buf + n;
+  return true;
+}
+
+static bool read_input(FILE *f)
+{
+  size_t cap = 1 << 16, n = 0;
+  buf = (char *) malloc(cap + PAD);
+  for (;;) {
+    n += fread(buf + n, 1, cap - n, f);
+    if (n < cap)
+      break;
+    cap *= 2;
+    buf = (char *) realloc(buf, cap + PAD);
+  }
+  if (ferror(f))
+    return false;
+  memset(buf + n, 0, PAD);
+  end = buf + n;
+  return true;
+}
+
+bool fast_lex_open(FILE *f)
+{
+  fast_lex_close();
+
+  struct stat st;
+  int fd = fileno(f);
+  bool ok;
+  if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0
+      && map_input(fd, st.st_size))
+    ok = true;
+  else
+    ok = read_input(f);
+  if (!ok) {
+    fast_lex_close();
+    return false;
+  }
+  pos = tok = buf;
+  return true;
+}
+
+bool fast_lex_open_text(const char *text, int len)
+{
+  fast_lex_close();
+  buf = (char *) malloc(len + PAD);
+  memcpy(buf, text, len);
+  memset(buf + len, 0, PAD);
+  end = buf + len;
+  pos = tok = buf;
+  return true;
+}
+
+void fast_lex_seek(const LexPoint& p)
+{
+  pos = buf + p.offset;
+  curr_lineno = p.lineno;
+  resume_level = p.comment_level;
+  tok = resume_level ? buf + p.comment_start : pos;
+}
+
+void fast_lex_close()
+{
+  if (map_size)
+    munmap(buf, map_size);
+  else
+    free(buf);
+  buf = pos = end = tok = NULL;
+  map_size = 0;
+  resume_level = 0;
+}
+
+const char *fast_lex_input()
+{
+  return buf;
+}
+
+const char *fast_lex_vectors()
+{
+#if defined(__AVX2__)
+  return "avx2";
+#elif defined(__SSE2__)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+TokenSpan fast_lex_span()
+{
+  TokenSpan span = { (int) (tok - buf), (int) (pos - tok) };
+  return span;
+}
+
+int fast_lex()
+{
+  if (resume_level) {
+    int level = resume_level;
+    resume_level = 0;
+    int token = scan_comment(level);
+    if (token)
+      return token;
+  }
+
+  for (;;) {
+    pos = skip_space(pos);
+    if (pos >= end) {
+      pos = end;
+      return 0;
+    }
+
+    char *s = pos;
+    char c = *s;
+    tok = s;
+
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+      // keywords, {UPPER}({ALNUM})* and {LOWER}({ALNUM})*
+      char *e = skip_alnum(s + 1);
+      pos = e;
+      int token = keyword_token(s, e - s, cool_yylval);
+      if (token)
+	return token;
+      cool_yylval.symbol = idtable.add_string(s, e - s);
+      return (c <= 'Z') ? TYPEID : OBJECTID;
+    }
+
+    if (is_digit(c)) {
+      // {DIGIT}+
+      char *e = skip_digits(s + 1);
+      pos = e;
+      cool_yylval.symbol = inttable.add_string(s, e - s);
+      return INT_CONST;
+    }
+
+    pos = s + 1;
+    switch (c) {
+    case '"':
+      return scan_string();
+
+    case '(':
+      if (s[1] == '*') {
+	pos = s + 2;
+	int token = scan_comment(1);
+	if (token)
+	  return token;
+	continue;
+      }
+      return '(';
+
+    case '*':
+      if (s[1] == ')') {
+	pos = s + 2;
+	cool_yylval.error_msg = "Unmatched *)";
+	return ERROR;
+      }
+      return '*';
+
+    case '-':
+      if (s[1] == '-') {
+	// "--".*
+	char *nl = (char *) memchr(s, '\n', end - s);
+	pos = nl ? nl : end;
+	continue;
+      }
+      return '-';
+
+    case '=':
+      if (s[1] == '>') {
+	pos = s + 2;
+	return DARROW;
+      }
+      return '=';
+
+    case '<':
+      if (s[1] == '-') {
+	pos = s + 2;
+	return ASSIGN;
+      }
+      if (s[1] == '=') {
+	pos = s + 2;
+	return LE;
+      }
+      return '<';
+
+    case '+': case '/': case '~': case '.': case '@': case ',':
+    case ':': case ';': case ')': case '{': case '}':
+      return c;
+
+    default:
+      unmatched[0] = c;
+      unmatched[1] = '\0';
+      cool_yylval.error_msg = unmatched;
+      return ERROR;
+    }
+  }
+}
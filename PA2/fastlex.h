@@ -0,0 +1,82 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _FASTLEX_H_
+#define _FASTLEX_H_
+
+#include <stdio.h>
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  fastlex.h
+//
+//  A hand-written scanner that returns exactly the tokens, semantic values,
+//  line numbers and error messages of the flex scanner in cool.flex,
+//  including its quirks.  It is selected with the -f flag (see
+//  handle_flags.cc).
+//
+//  A regular file is mapped into memory rather than read, and identifiers,
+//  integers and strings without escapes are interned straight from the
+//  mapping; the only copy of a token's text is the one its table keeps.
+//  Whitespace, identifier and digit runs, comment bodies and string
+//  bodies are scanned 16 (SSE2) or 32 (AVX2, when the compiler targets
+//  it) bytes at a time.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+// Start scanning the contents of f from the beginning.  Fails only if f
+// cannot be read.
+extern bool fast_lex_open(FILE *f);
+
+// The next token, like cool_yylex: 0 at the end of input, with
+// cool_yylval and curr_lineno set as the flex scanner sets them.
+extern int fast_lex();
+
+// Release the input.  The last token's value stays valid until then.
+extern void fast_lex_close();
+
+// How runs are scanned, as this file was compiled: "avx2", "sse2" or
+// "scalar".
+extern const char *fast_lex_vectors();
+
+// Where the last token came from: length bytes starting offset bytes
+// into the input, which fast_lex_input returns.  The input stays in
+// place until fast_lex_close, so a token's text can be read there
+// without being copied.
+struct TokenSpan {
+  int offset;
+  int length;
+};
+extern TokenSpan fast_lex_span();
+extern const char *fast_lex_input();
+
+//
+// Restarting the scanner part way through its input, as relex.cc does.
+//
+// A LexPoint is what the scanner carries from one place in the input to
+// the next, taken where it matters: at a line start.  A string never
+// runs on past its line, so only a comment can be open there.
+//
+struct LexPoint {
+  int offset;                   // the line's first character
+  int lineno;
+  int comment_level;            // 0 outside comments
+  int comment_start;            // if in one, where the outermost began
+};
+
+// Start scanning a copy of the len bytes at text.
+extern bool fast_lex_open_text(const char *text, int len);
+
+// Carry on scanning the input from p, taken from an earlier scan of the
+// same text up to p.
+extern void fast_lex_seek(const LexPoint& p);
+
+// If set, called at each line start the scanner passes inside a comment.
+// (Outside comments a line start needs no call: it is just the offset
+// and line number, with no comment open.)
+extern void (*fast_lex_comment_line)(const LexPoint& p);
+
+#endif
@@ -25,6 +25,12 @@
 extern int yy_flex_debug;       // for the lexer; prints recognized rules
 extern int cool_yydebug;        // for the parser
        int lex_verbose;         // also for the lexer; prints tokens
+       int lex_fast;            // lexer: use the hand-written scanner
+       int lex_binary;          // lexer: write binary tokens (tokenstream.h)
+       int parse_jobs;          // parser: files parsed at once
+       int lex_in_process;      // parser: scan the input files itself
+       int parse_handwritten;   // parser: use the parser of pratt.cc
+       int parse_skeleton;      // parser: method bodies after the classes
        int semant_debug;        // for semantic analysis
        int cgen_debug;          // for code gen
        bool disable_reg_alloc;  // Don't do register allocation
@@ -47,13 +53,19 @@ void handle_flags(int argc, char *argv[]) {
   yy_flex_debug= 0;
   cool_yydebug = 0;
   lex_verbose  = 0;
+  lex_fast     = 0;
+  lex_binary   = 0;
+  parse_jobs   = 1;
+  lex_in_process = 0;
+  parse_handwritten = 0;
+  parse_skeleton = 0;
   semant_debug = 0;
   cgen_debug = 0;
   cgen_optimize = 0;
   disable_reg_alloc = 0;
   
 
-  while ((c = getopt(argc, argv, "lpscvrOo:gtT")) != -1) {
+  while ((c = getopt(argc, argv, "lpscvrfbihkj:Oo:gtT")) != -1) {
     switch (c) {
 #ifdef DEBUG
     case 'l':
@@ -96,6 +108,26 @@ void handle_flags(int argc, char *argv[]) {
     case 'o':  // set the name of the output file
       out_filename = optarg;
       break;
+    case 'f':  // scan with fastlex.cc instead of the flex scanner
+      lex_fast = 1;
+      break;
+    case 'b':  // binary tokens between lexer and parser
+      lex_binary = 1;
+      break;
+    case 'i':  // parser: scan the input files on a thread of its own
+      lex_in_process = 1;
+      break;
+    case 'h':  // parser: the hand-written parser instead of bison's
+      parse_handwritten = 1;
+      break;
+    case 'k':  // parser: parse the class skeletons, then the method bodies
+      parse_skeleton = 1;
+      break;
+    case 'j':  // parse the files of a binary token stream in parallel
+      parse_jobs = atoi(optarg);
+      if (parse_jobs < 1)
+        unknownopt = 1;
+      break;
     case 'O':  // enable optimization
       cgen_optimize = 1;
       break;
@@ -111,9 +143,9 @@ void handle_flags(int argc, char *argv[]) {
   if (unknownopt) {
       cerr << "usage: " << argv[0] << 
 #ifdef DEBUG
-	  " [-lvpscOgtTr -o outname] [input-files]\n";
+	  " [-lvpscfbihkOgtTr -j jobs -o outname] [input-files]\n";
 #else
-      " [-OgtT -o outname] [input-files]\n";
+      " [-fbihkOgtT -j jobs -o outname] [input-files]\n";
 #endif
       exit(1);
   }
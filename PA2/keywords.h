@@ -0,0 +1,123 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _KEYWORDS_H_
+#define _KEYWORDS_H_
+
+#include "cool-parse.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  keywords.h
+//
+//  Keyword recognition for both scanners.  A keyword is scanned as an
+//  identifier and then looked up here, so the flex scanner needs no
+//  case-insensitive rule per keyword.
+//
+//  Keywords are case insensitive, except that true and false must start
+//  with a lowercase letter.  A word of identifier characters is a keyword
+//  only if all of it is; "classy" is an identifier.
+//
+//  The lookup is a perfect hash of the length and the first two letters,
+//  lowercased.  Its multiplier is found by the compiler, which checks that
+//  no two keywords share a slot, so a word is compared against at most
+//  one keyword.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+namespace keywords {
+
+struct Keyword {
+  const char *name;     // lowercase
+  int len;
+  int token;
+};
+
+constexpr Keyword words[] = {
+  { "class", 5, CLASS },     { "else", 4, ELSE },     { "fi", 2, FI },
+  { "if", 2, IF },           { "in", 2, IN },         { "inherits", 8, INHERITS },
+  { "isvoid", 6, ISVOID },   { "let", 3, LET },       { "loop", 4, LOOP },
+  { "pool", 4, POOL },       { "then", 4, THEN },     { "while", 5, WHILE },
+  { "case", 4, CASE },       { "esac", 4, ESAC },     { "new", 3, NEW },
+  { "of", 2, OF },           { "not", 3, NOT },
+  { "true", 4, BOOL_CONST }, { "false", 5, BOOL_CONST },
+};
+
+constexpr int NKEYWORDS = sizeof(words) / sizeof(words[0]);
+constexpr int MIN_LEN = 2, MAX_LEN = 8;
+constexpr int BITS = 5;
+constexpr int NSLOTS = 1 << BITS;
+
+// ORing in 0x20 lowercases a letter; other characters cannot match
+// anyway, since the final comparison is against the whole keyword.
+constexpr unsigned hash(const char *s, int len, unsigned mult)
+{
+  unsigned key = (unsigned char) (s[0] | 0x20) |
+                 (unsigned char) (s[1] | 0x20) << 8 | (unsigned) len << 16;
+  return (key * mult) >> (32 - BITS);
+}
+
+constexpr bool perfect(unsigned mult)
+{
+  unsigned used = 0;
+  for (int i = 0; i < NKEYWORDS; i++) {
+    unsigned bit = 1u << hash(words[i].name, words[i].len, mult);
+    if (used & bit)
+      return false;
+    used |= bit;
+  }
+  return true;
+}
+
+constexpr unsigned find_multiplier()
+{
+  for (unsigned m = 1; ; m += 2)
+    if (perfect(m * 2654435761u))
+      return m * 2654435761u;
+}
+
+constexpr unsigned MULT = find_multiplier();
+
+struct Slots {
+  signed char keyword[NSLOTS];          // index into words, or -1
+  constexpr Slots() : keyword()
+  {
+    for (int h = 0; h < NSLOTS; h++)
+      keyword[h] = -1;
+    for (int i = 0; i < NKEYWORDS; i++)
+      keyword[hash(words[i].name, words[i].len, MULT)] = i;
+  }
+};
+
+constexpr Slots slots;
+
+} // namespace keywords
+
+//
+// The token for the len identifier characters at s if they are a
+// keyword, or 0 if not.  For true and false, yylval.boolean is set.
+//
+inline int keyword_token(const char *s, int len, YYSTYPE& yylval)
+{
+  if (len < keywords::MIN_LEN || len > keywords::MAX_LEN)
+    return 0;
+  int i = keywords::slots.keyword[keywords::hash(s, len, keywords::MULT)];
+  if (i < 0 || keywords::words[i].len != len)
+    return 0;
+  const char *kw = keywords::words[i].name;
+  for (int k = 0; k < len; k++)
+    if ((s[k] | 0x20) != kw[k])
+      return 0;
+  int token = keywords::words[i].token;
+  if (token == BOOL_CONST) {
+    if (s[0] != kw[0])                  // True, FALSE, ...
+      return 0;
+    yylval.boolean = (kw[0] == 't');
+  }
+  return token;
+}
+
+#endif
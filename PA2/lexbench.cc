@@ -0,0 +1,409 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  lexbench.cc
+//
+//  Measures the throughput of both scanners (make lexbench).
+//
+//  It generates COOL sources of a few kinds, each stressing one part of
+//  the scanner:
+//
+//    ident     identifiers, keywords and punctuation
+//    comment   block comments nested -d deep, with a few tokens between
+//    string    string constants of about -l characters with escapes
+//    integer   integer constants and arithmetic
+//    mixed     all of the above, interleaved
+//
+//  Each is scanned -r times in this process by the flex scanner
+//  (cool_yylex) and by the hand-written one (fast_lex), from a temporary
+//  file.  The best run is reported.  The results go to stdout as JSON:
+//  for each corpus and scanner, the bytes and tokens scanned, the time,
+//  MB/s, tokens/s, and the heap allocations per token on the first run,
+//  while the string tables are still empty.  "fast_vectors" says which
+//  of fast_lex's run loops the build has (avx2, sse2 or scalar); it
+//  follows the -m flags in CFLAGS.
+//
+//  Options:
+//    -n bytes   size of each corpus (default 4M; k and M suffixes)
+//    -r runs    scans of each corpus per scanner (default 5)
+//    -d depth   comment nesting (default 4)
+//    -l length  string constant length (default 200, at most 1000)
+//    -s seed    for the generator (default 1)
+//    -g dir     only write the corpora to dir/<kind>.cl
+//
+//  The sources are generated from the seed alone, so runs with the same
+//  options scan the same text and can be compared across commits.  Build
+//  both commits with the same CFLAGS.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>     // for getopt
+#include <chrono>
+#include <string>
+#include "cool-parse.h"
+#include "fastlex.h"
+
+int curr_lineno = 1;
+char *curr_filename = "<bench>";
+YYSTYPE cool_yylval;
+
+extern FILE *yyin;
+extern int cool_yylex();
+
+//
+// Every heap allocation is counted, whoever makes it: the string tables,
+// flex's buffers, operator new.
+//
+static long allocations;
+
+#ifdef __GLIBC__
+extern "C" {
+extern void *__libc_malloc(size_t n);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t n);
+
+void *malloc(size_t n)
+{
+  allocations++;
+  return __libc_malloc(n);
+}
+
+void *calloc(size_t n, size_t size)
+{
+  allocations++;
+  return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t n)
+{
+  allocations++;
+  return __libc_realloc(p, n);
+}
+}
+#define COUNTS_ALLOCATIONS 1
+#else
+#define COUNTS_ALLOCATIONS 0
+#endif
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  The generator
+//
+/////////////////////////////////////////////////////////////////////////
+
+class Generator {
+private:
+  unsigned long long state;
+  std::string out;
+
+  unsigned next()                       // xorshift64*
+  {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return (unsigned) ((state * 2685821657736338717ull) >> 32);
+  }
+  int below(int n) { return next() % n; }
+
+  void ident(bool type);
+  void integer();
+  void string(int len);
+  void comment(int depth);
+  void ident_line();
+  void integer_line();
+  void string_line(int len);
+  void comment_block(int depth);
+public:
+  Generator(unsigned seed) : state(seed * 0x9e3779b97f4a7c15ull + 1) { }
+  std::string make(const char *kind, long size, int depth, int len);
+};
+
+static const char *kinds[] = { "ident", "comment", "string", "integer",
+			       "mixed" };
+enum { NKINDS = sizeof(kinds) / sizeof(kinds[0]) };
+
+static const char *keywords[] = { "if", "then", "else", "fi", "while",
+				  "loop", "pool", "let", "in", "case",
+				  "of", "esac", "new", "isvoid", "not",
+				  "true", "false" };
+enum { NKEYWORDS = sizeof(keywords) / sizeof(keywords[0]) };
+
+void Generator::ident(bool type)
+{
+  static const char first[] = "abcdefghijklmnopqrstuvwxyz";
+  static const char rest[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+  char c = first[below(26)];
+  out += type ? c - 'a' + 'A' : c;
+  for (int n = below(12); n > 0; n--)
+    out += rest[below(sizeof(rest) - 1)];
+}
+
+void Generator::integer()
+{
+  out += std::to_string(next() % 1000000);
+}
+
+void Generator::string(int len)
+{
+  static const char *escapes[] = { "\\n", "\\t", "\\\"", "\\\\", "\\b" };
+  static const char chars[] =
+    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 .,;:!?()+-*/<>=";
+  out += '"';
+  for (int i = 0; i < len; i++) {
+    if (below(16) == 0)
+      out += escapes[below(5)];
+    else
+      out += chars[below(sizeof(chars) - 1)];
+  }
+  out += '"';
+}
+
+void Generator::comment(int depth)
+{
+  static const char *words[] = { "lorem", "ipsum", "dolor", "sit", "amet",
+				 "x <- y + 1;", "*", "(", ")", "--" };
+  out += "(*";
+  for (int n = 4 + below(12); n > 0; n--) {
+    out += ' ';
+    if (depth > 1 && below(6) == 0)
+      comment(depth - 1);
+    else
+      out += words[below(10)];
+    if (below(5) == 0)
+      out += '\n';
+  }
+  out += " *)";
+}
+
+void Generator::ident_line()
+{
+  out += "    ";
+  ident(false);
+  out += " <- ";
+  switch (below(4)) {
+  case 0:
+    out += "new ";
+    ident(true);
+    break;
+  case 1:
+    out += keywords[below(NKEYWORDS)];
+    out += ' ';
+    ident(false);
+    break;
+  default:
+    ident(false);
+    out += '.';
+    ident(false);
+    out += '(';
+    for (int n = below(4); n > 0; n--) {
+      ident(false);
+      if (n > 1)
+	out += ", ";
+    }
+    out += ')';
+  }
+  out += ";\n";
+}
+
+void Generator::integer_line()
+{
+  static const char *ops[] = { " + ", " - ", " * ", " / ", " < ", " <= ",
+			       " = " };
+  out += "    ";
+  ident(false);
+  out += " <- ";
+  integer();
+  for (int n = 1 + below(6); n > 0; n--) {
+    out += ops[below(7)];
+    integer();
+  }
+  out += ";\n";
+}
+
+void Generator::string_line(int len)
+{
+  out += "    ";
+  ident(false);
+  out += " <- ";
+  string(len / 2 + below(len / 2 + 1));
+  out += ";\n";
+}
+
+void Generator::comment_block(int depth)
+{
+  comment(depth);
+  out += '\n';
+  ident_line();
+}
+
+std::string Generator::make(const char *kind, long size, int depth, int len)
+{
+  out.clear();
+  out.reserve(size + 4096);
+  int k = 0;
+  while (k < NKINDS && strcmp(kinds[k], kind) != 0)
+    k++;
+  while ((long) out.size() < size) {
+    switch (k == NKINDS - 1 ? below(NKINDS - 1) : k) {
+    case 0: ident_line(); break;
+    case 1: comment_block(depth); break;
+    case 2: string_line(len); break;
+    case 3: integer_line(); break;
+    }
+  }
+  return out;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  The benchmark
+//
+/////////////////////////////////////////////////////////////////////////
+
+struct Result {
+  long tokens;
+  double seconds;                       // the best run
+  double allocs_per_token;              // on the first run
+};
+
+static long scan_flex(FILE *f)
+{
+  long tokens = 0;
+  rewind(f);
+  yyin = f;
+  curr_lineno = 1;
+  while (cool_yylex() != 0)
+    tokens++;
+  return tokens;
+}
+
+static long scan_fast(FILE *f)
+{
+  long tokens = 0;
+  rewind(f);
+  if (!fast_lex_open(f)) {
+    fprintf(stderr, "lexbench: could not read the corpus\n");
+    exit(1);
+  }
+  curr_lineno = 1;
+  while (fast_lex() != 0)
+    tokens++;
+  fast_lex_close();
+  return tokens;
+}
+
+static Result run(long (*scan)(FILE *), FILE *f, int runs)
+{
+  Result r = { 0, 0, 0 };
+  for (int i = 0; i < runs; i++) {
+    long before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    r.tokens = scan(f);
+    std::chrono::duration<double> t = std::chrono::steady_clock::now() - start;
+    if (i == 0) {
+      r.seconds = t.count();
+      r.allocs_per_token = r.tokens ? (double) (allocations - before) / r.tokens : 0;
+    } else if (t.count() < r.seconds)
+      r.seconds = t.count();
+  }
+  return r;
+}
+
+static long parse_size(const char *s)
+{
+  char *end;
+  long n = strtol(s, &end, 10);
+  if (*end == 'k' || *end == 'K')
+    n <<= 10;
+  else if (*end == 'm' || *end == 'M')
+    n <<= 20;
+  return n;
+}
+
+static void usage()
+{
+  fprintf(stderr, "usage: lexbench [-n bytes] [-r runs] [-d depth] "
+	  "[-l length] [-s seed] [-g dir]\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+  long size = 4 << 20;
+  int runs = 5, depth = 4, len = 200;
+  unsigned seed = 1;
+  const char *dir = NULL;
+  int c;
+
+  while ((c = getopt(argc, argv, "n:r:d:l:s:g:")) != -1) {
+    switch (c) {
+    case 'n': size = parse_size(optarg); break;
+    case 'r': runs = atoi(optarg); break;
+    case 'd': depth = atoi(optarg); break;
+    case 'l': len = atoi(optarg); break;
+    case 's': seed = strtoul(optarg, NULL, 10); break;
+    case 'g': dir = optarg; break;
+    default: usage();
+    }
+  }
+  if (size <= 0 || runs < 1 || depth < 1 || len < 0 || len > 1000)
+    usage();
+
+  printf("{\n  \"corpus_bytes\": %ld,\n  \"runs\": %d,\n"
+	 "  \"comment_depth\": %d,\n  \"string_length\": %d,\n"
+	 "  \"seed\": %u,\n  \"fast_vectors\": \"%s\",\n  \"results\": [",
+	 size, runs, depth, len, seed, fast_lex_vectors());
+  const char *sep = "\n";
+  for (int k = 0; k < NKINDS; k++) {
+    Generator gen(seed);
+    std::string text = gen.make(kinds[k], size, depth, len);
+
+    FILE *f;
+    if (dir) {
+      std::string name = std::string(dir) + "/" + kinds[k] + ".cl";
+      if ((f = fopen(name.c_str(), "w")) == NULL) {
+	fprintf(stderr, "lexbench: could not create %s\n", name.c_str());
+	exit(1);
+      }
+    } else if ((f = tmpfile()) == NULL) {
+      fprintf(stderr, "lexbench: could not create a temporary file\n");
+      exit(1);
+    }
+    fwrite(text.data(), 1, text.size(), f);
+    fflush(f);
+    if (dir) {
+      fclose(f);
+      continue;
+    }
+
+    static const struct {
+      const char *name;
+      long (*scan)(FILE *);
+    } scanners[] = { { "flex", scan_flex }, { "fast", scan_fast } };
+    for (int s = 0; s < 2; s++) {
+      Result r = run(scanners[s].scan, f, runs);
+      double mb = text.size() / (1024.0 * 1024.0);
+      printf("%s    { \"corpus\": \"%s\", \"scanner\": \"%s\", "
+	     "\"bytes\": %zu, \"tokens\": %ld, \"seconds\": %.6f, "
+	     "\"mb_per_s\": %.2f, \"tokens_per_s\": %.0f, ",
+	     sep, kinds[k], scanners[s].name, text.size(), r.tokens,
+	     r.seconds, mb / r.seconds, r.tokens / r.seconds);
+      if (COUNTS_ALLOCATIONS)
+	printf("\"allocs_per_token\": %.4f }", r.allocs_per_token);
+      else
+	printf("\"allocs_per_token\": null }");
+      sep = ",\n";
+    }
+    fclose(f);
+  }
+  printf("\n  ]\n}\n");
+  return 0;
+}
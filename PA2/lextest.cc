@@ -11,13 +11,18 @@
 //  Reads input from file argument.
 //
 //  Option -l prints summary of flex actions.
+//  Option -f scans with the hand-written scanner in fastlex.cc instead.
+//  Option -b writes the binary token format of tokenstream.h.
 //
 //////////////////////////////////////////////////////////////////////////////
 
 #include <stdio.h>      // needed on Linux system
 #include <unistd.h>     // for getopt
+#include <sys/stat.h>   // for fstat
 #include "cool-parse.h" // bison-generated file; defines tokens
 #include "utilities.h"
+#include "fastlex.h"
+#include "tokenstream.h"
 
 //
 //  The lexer keeps this global variable up to date with the line number
@@ -43,6 +48,8 @@ extern int optind;  // used for option processing (man 3 getopt for more info)
 //
 extern int yy_flex_debug;      // Flex debugging; see flex documentation.
 extern int lex_verbose;        // Controls printing of tokens.
+extern int lex_fast;           // Use the hand-written scanner.
+extern int lex_binary;         // Write binary tokens.
 void handle_flags(int argc, char *argv[]);
 
 //
@@ -58,18 +65,41 @@ extern void dump_cool_token(ostream& out, int lineno,
 			    int token, YYSTYPE yylval);
 
 
+//
+// Does stderr go where stdout does, as with >file 2>&1 or a terminal?
+// Then the scanner's messages on stderr have to land between the right
+// tokens, so tokens cannot be held back.
+//
+static bool stderr_with_stdout()
+{
+	struct stat out, err;
+	return fstat(1, &out) == 0 && fstat(2, &err) == 0 &&
+	    out.st_dev == err.st_dev && out.st_ino == err.st_ino;
+}
+
 int main(int argc, char** argv) {
 	int token;
 	
 	handle_flags(argc,argv);
+	TokenWriter *writer = lex_binary ? new TokenWriter(stdout) : NULL;
+	TokenDumper *dumper = lex_binary ? NULL : new TokenDumper(1);
+	bool unbuffered = yy_flex_debug || stderr_with_stdout();
 
 	while (optind < argc) {
 	    fin = fopen(argv[optind], "r");
 	    if (fin == NULL) {
+		if (dumper)
+		    dumper->flush();
 		cerr << "Could not open input file " << argv[optind] << endl;
 		exit(1);
 	    }
 	    yyin = fin;
+	    if (lex_fast && !fast_lex_open(fin)) {
+		if (dumper)
+		    dumper->flush();
+		cerr << "Could not read input file " << argv[optind] << endl;
+		exit(1);
+	    }
 
             // sm: the 'coolc' compiler's file-handling loop resets
             // this counter, so let's make the stand-alone lexer
@@ -79,13 +109,31 @@ int main(int argc, char** argv) {
 	    //
 	    // Scan and print all tokens.
 	    //
-	    cout << "#name \"" << argv[optind] << "\"" << endl;
-	    while ((token = cool_yylex()) != 0) {
-		dump_cool_token(cout, curr_lineno, token, cool_yylval);
+	    if (writer)
+		writer->begin_file(argv[optind]);
+	    else {
+		dumper->begin_file(argv[optind]);
+		if (unbuffered)
+		    dumper->flush();
+	    }
+	    while ((token = lex_fast ? fast_lex() : cool_yylex()) != 0) {
+		if (writer)
+		    writer->put(curr_lineno, token, cool_yylval);
+		else {
+		    dumper->put(curr_lineno, token, cool_yylval);
+		    if (unbuffered)
+			dumper->flush();
+		}
 	    }
+	    if (writer)
+		writer->end_file();
+	    if (lex_fast)
+		fast_lex_close();
 	    fclose(fin);
 	    optind++;
 	}
+	if (dumper)
+	    dumper->flush();
 	exit(0);
 }
 
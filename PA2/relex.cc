@@ -0,0 +1,158 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  relex.cc
+//
+//  LexedFile, declared in relex.h, on top of the scanner of fastlex.cc.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include "relex.h"
+
+extern int curr_lineno;
+extern YYSTYPE cool_yylval;
+
+static const LexPoint file_start = { 0, 1, 0, -1 };
+
+//
+// An unmatched character's message is in a buffer the scanner reuses, so
+// every ERROR message is kept here, once.
+//
+static char *keep_message(const char *msg)
+{
+  static std::unordered_set<std::string> messages;
+  return (char *) messages.insert(msg).first->c_str();
+}
+
+// the line starts inside comments, as the scanner reports them
+static std::vector<LexPoint> *comment_lines;
+
+static void note_comment_line(const LexPoint& p)
+{
+  comment_lines->push_back(p);
+}
+
+//
+// Append to out the line starts of text after from.offset and no later
+// than upto, with the state the scanner had at each: none outside a
+// comment, or what it reported in in_comments.
+//
+static void add_lines(const char *text, const LexPoint& from, int upto,
+		      const std::vector<LexPoint>& in_comments,
+		      std::vector<LexPoint>& out)
+{
+  size_t c = 0;
+  int lineno = from.lineno;
+  const char *p = text + from.offset, *e = text + upto;
+  while (p < e && (p = (const char *) memchr(p, '\n', e - p)) != NULL) {
+    p++;
+    LexPoint lp = { (int) (p - text), ++lineno, 0, -1 };
+    while (c < in_comments.size() && in_comments[c].offset < lp.offset)
+      c++;
+    if (c < in_comments.size() && in_comments[c].offset == lp.offset)
+      lp = in_comments[c];
+    out.push_back(lp);
+  }
+}
+
+LexedFile::LexedFile() : rescanned(0)
+{
+  lines.push_back(file_start);
+}
+
+void LexedFile::lex(const char *text, int len)
+{
+  tokens.clear();
+  lines.clear();
+  lines.push_back(file_start);
+  relex(text, len, 0, 0, len);
+}
+
+void LexedFile::relex(const char *text, int len, int start, int old_end,
+		      int new_end)
+{
+  int delta = new_end - old_end;
+
+  // Start again at the line the edit begins on.  The tokens from there
+  // on, or from its comment if it starts in one, are scanned again.
+  size_t li = std::upper_bound(lines.begin(), lines.end(), start,
+			       [](int off, const LexPoint& p)
+			       { return off < p.offset; }) - lines.begin() - 1;
+  LexPoint from = lines[li];
+  int first = from.comment_level ? from.comment_start : from.offset;
+  auto by_offset = [](const LexToken& t, int off) { return t.span.offset < off; };
+  size_t kept = std::lower_bound(tokens.begin(), tokens.end(), first,
+				 by_offset) - tokens.begin();
+
+  std::vector<LexPoint> in_comments;
+  comment_lines = &in_comments;
+  fast_lex_comment_line = note_comment_line;
+  fast_lex_open_text(text, len);
+  fast_lex_seek(from);
+
+  // Scan until a token past the edit starts where an old one did.
+  std::vector<LexToken> fresh;
+  size_t same = tokens.size();          // the first old token kept after
+  int upto = len;                       // where it starts in text
+  int line_shift = 0;
+  int token;
+  while ((token = fast_lex()) != 0) {
+    LexToken t;
+    t.token = token;
+    t.lineno = curr_lineno;
+    t.span = fast_lex_span();
+    t.yylval = cool_yylval;
+    if (token == ERROR)
+      t.yylval.error_msg = keep_message(t.yylval.error_msg);
+
+    if (t.span.offset >= new_end) {
+      int old = t.span.offset - delta;
+      size_t j = std::lower_bound(tokens.begin() + kept, tokens.end(), old,
+				  by_offset) - tokens.begin();
+      if (j < tokens.size() && tokens[j].span.offset == old) {
+	same = j;
+	upto = t.span.offset;
+	line_shift = t.lineno - tokens[j].lineno;
+	break;
+      }
+    }
+    fresh.push_back(t);
+  }
+  fast_lex_comment_line = NULL;
+  fast_lex_close();
+  rescanned = fresh.size();
+
+  std::vector<LexToken> new_tokens(tokens.begin(), tokens.begin() + kept);
+  new_tokens.insert(new_tokens.end(), fresh.begin(), fresh.end());
+  for (size_t j = same; j < tokens.size(); j++) {
+    LexToken t = tokens[j];
+    t.span.offset += delta;
+    t.lineno += line_shift;
+    new_tokens.push_back(t);
+  }
+  tokens.swap(new_tokens);
+
+  std::vector<LexPoint> new_lines(lines.begin(), lines.begin() + li + 1);
+  add_lines(text, from, upto, in_comments, new_lines);
+  size_t i = std::upper_bound(lines.begin(), lines.end(), upto - delta,
+			      [](int off, const LexPoint& p)
+			      { return off < p.offset; }) - lines.begin();
+  for (; i < lines.size(); i++) {
+    LexPoint lp = lines[i];
+    lp.offset += delta;
+    lp.lineno += line_shift;
+    if (lp.comment_level)
+      lp.comment_start += delta;
+    new_lines.push_back(lp);
+  }
+  lines.swap(new_lines);
+}
@@ -0,0 +1,59 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _RELEX_H_
+#define _RELEX_H_
+
+#include <vector>
+#include "cool-parse.h"
+#include "fastlex.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  relex.h
+//
+//  Incremental scanning, for an editor or a watch-mode rebuild that has
+//  the tokens of a file and changes a few lines of it.
+//
+//  A LexedFile keeps the tokens of its text along with the scanner's
+//  state at the start of every line (a LexPoint; see fastlex.h).  After
+//  an edit, scanning starts again at the start of the line the edit
+//  begins on, in the state the scanner had there, and stops at the first
+//  token past the edit that starts where an old token started: from
+//  there on the text is the same and so are the tokens, only moved.  The
+//  new tokens are spliced in between the old ones, and the result is
+//  what scanning the whole new text would give.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+struct LexToken {
+  int token;
+  int lineno;                   // curr_lineno after the token
+  TokenSpan span;
+  YYSTYPE yylval;               // an ERROR's message is kept, not reused
+};
+
+class LexedFile {
+private:
+  std::vector<LexToken> tokens;
+  std::vector<LexPoint> lines;          // lines[i] starts line i + 1
+  int rescanned;                        // tokens the last scan produced
+public:
+  LexedFile();
+
+  // Scan all len bytes of text.
+  void lex(const char *text, int len);
+
+  // text, len bytes, is the text last scanned with the bytes from start
+  // to old_end replaced by the bytes from start to new_end.
+  void relex(const char *text, int len, int start, int old_end, int new_end);
+
+  const std::vector<LexToken>& get_tokens() const { return tokens; }
+  const std::vector<LexPoint>& get_lines() const { return lines; }
+  int get_rescanned() const { return rescanned; }
+};
+
+#endif
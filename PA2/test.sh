@@ -0,0 +1,15 @@
+#!/bin/bash
+# test.sh: the hand-written scanner (-f) must print exactly what the flex
+# scanner prints, tokens and diagnostics alike.
+
+for file in test.cl hello.cl "$@"; do
+    echo "Testing $file..."
+    ./lexer $file > flex_${file%.cl}.txt 2>&1
+    ./lexer -f $file > fast_${file%.cl}.txt 2>&1
+    if diff flex_${file%.cl}.txt fast_${file%.cl}.txt > /dev/null; then
+        echo "$file: PASS"
+    else
+        echo "$file: FAIL"
+        diff flex_${file%.cl}.txt fast_${file%.cl}.txt | head -20
+    fi
+done
@@ -0,0 +1,482 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  tokenstream.cc
+//
+//  The text token dumper, and writing and reading the binary token format
+//  described in tokenstream.h.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include <charconv>
+#include "tokenstream.h"
+#include "utilities.h"
+
+extern int curr_lineno;
+extern char *curr_filename;
+extern YYSTYPE cool_yylval;
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  TokenDumper
+//
+/////////////////////////////////////////////////////////////////////////
+
+TokenDumper::TokenDumper(int f) : fd(f), buf(new char[BUFSIZE]), used(0) { }
+
+TokenDumper::~TokenDumper()
+{
+  flush();
+  delete[] buf;
+}
+
+static void write_all(int fd, const char *p, int n)
+{
+  while (n > 0) {
+    ssize_t done = write(fd, p, n);
+    if (done < 0) {
+      if (errno == EINTR)
+	continue;
+      fatal_error("Could not write tokens\n");
+    }
+    p += done;
+    n -= done;
+  }
+}
+
+void TokenDumper::flush()
+{
+  write_all(fd, buf, used);
+  used = 0;
+}
+
+char *TokenDumper::room(int n)
+{
+  if (used + n > BUFSIZE)
+    flush();
+  return buf + used;
+}
+
+void TokenDumper::append(const char *s, int len)
+{
+  if (len > BUFSIZE) {
+    // too big to buffer, so it goes straight out
+    flush();
+    write_all(fd, s, len);
+    return;
+  }
+  memcpy(room(len), s, len);
+  used += len;
+}
+
+//
+// Characters print_escaped_string shows as themselves are copied a run
+// at a time; the rest are escaped one by one.
+//
+static inline bool plain_char(char c)
+{
+  return c != '\\' && c != '"' && isprint(c);
+}
+
+void TokenDumper::append_escaped(const char *s)
+{
+  for (;;) {
+    const char *run = s;
+    while (plain_char(*s))
+      s++;
+    append(run, s - run);
+    if (*s == '\0')
+      return;
+    char esc[4];
+    int len = escape_dump_string(s, 1, esc);
+    append(esc, len);
+    s++;
+  }
+}
+
+void TokenDumper::begin_file(const char *filename)
+{
+  append("#name \"", 7);
+  append(filename, strlen(filename));
+  append("\"\n", 2);
+}
+
+void TokenDumper::put(int lineno, int token, YYSTYPE& yylval)
+{
+  // '#', the line number and a space
+  char *p = room(16);
+  *p++ = '#';
+  p = std::to_chars(p, p + 14, lineno).ptr;
+  *p++ = ' ';
+  used = p - buf;
+  const char *name = cool_token_to_string(token);
+  append(name, strlen(name));
+
+  switch (token) {
+  case STR_CONST: {
+    StringEntryP str = (StringEntryP) yylval.symbol;
+    append(" \"", 2);
+    append(str->get_escaped(), str->get_escaped_len());
+    append("\"", 1);
+    break;
+  }
+  case INT_CONST:
+  case TYPEID:
+  case OBJECTID:
+    append(" ", 1);
+    append(yylval.symbol->get_string(), yylval.symbol->get_len());
+    break;
+  case BOOL_CONST:
+    if (yylval.boolean)
+      append(" true", 5);
+    else
+      append(" false", 6);
+    break;
+  case ERROR:
+    // an empty message reports a NUL in the input; see dump_cool_token
+    if (yylval.error_msg[0] == 0)
+      append(" \"\\000\"", 7);
+    else {
+      append(" \"", 2);
+      append_escaped(yylval.error_msg);
+      append("\"", 1);
+    }
+    break;
+  }
+  append("\n", 1);
+}
+
+static const char magic[] = "\177CTK";
+enum { VERSION = 1, FILE_TAG = 'F', LINE_FLAG = 0x80 };
+
+//
+// Token codes.  Code c stands for token_of_code[c]; 0 ends a file's
+// tokens, and BOOL_CONST appears twice, as true and as false.
+//
+enum { END_CODE = 0, TRUE_CODE = 1, FALSE_CODE = 2 };
+
+static const int token_of_code[] = {
+  0, BOOL_CONST, BOOL_CONST,
+  CLASS, ELSE, FI, IF, IN, INHERITS, LET, LOOP, POOL, THEN, WHILE,
+  CASE, ESAC, OF, DARROW, NEW, ISVOID, STR_CONST, INT_CONST,
+  TYPEID, OBJECTID, ASSIGN, NOT, LE, ERROR,
+  '+', '-', '*', '/', '~', '<', '=', '.', '@', ',', ':', ';',
+  '(', ')', '{', '}',
+};
+
+enum { NCODES = sizeof(token_of_code) / sizeof(token_of_code[0]) };
+
+static int code_of_token(int token, YYSTYPE& yylval)
+{
+  if (token == BOOL_CONST)
+    return yylval.boolean ? TRUE_CODE : FALSE_CODE;
+  for (int c = FALSE_CODE + 1; c < NCODES; c++)
+    if (token_of_code[c] == token)
+      return c;
+  fatal_error("token stream: token has no code\n");
+  return END_CODE;
+}
+
+static void put_varint(std::string& s, unsigned v)
+{
+  while (v >= 0x80) {
+    s += (char) (v | 0x80);
+    v >>= 7;
+  }
+  s += (char) v;
+}
+
+static void put_string(std::string& s, const char *t, int len)
+{
+  put_varint(s, len);
+  s.append(t, len);
+}
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  TokenWriter
+//
+/////////////////////////////////////////////////////////////////////////
+
+TokenWriter::TokenWriter(FILE *f) : out(f), file_stamp(0), line(1)
+{
+  fwrite(magic, 1, sizeof(magic) - 1, out);
+  putc(VERSION, out);
+  for (int k = 0; k < NSECTIONS; k++)
+    count[k] = 0;
+}
+
+void TokenWriter::begin_file(const char *filename)
+{
+  name = filename;
+  tokens.clear();
+  for (int k = 0; k < NSECTIONS; k++) {
+    section[k].clear();
+    count[k] = 0;
+  }
+  file_stamp++;
+  line = 1;
+}
+
+//
+// The index of sym in section k, adding it to the section the first
+// time it is used in this file.
+//
+int TokenWriter::symbol_ref(int k, Symbol sym)
+{
+  unsigned i = sym->get_index();
+  if (i >= local[k].size()) {
+    local[k].resize(i + 1);
+    stamp[k].resize(i + 1, 0);
+  }
+  if (stamp[k][i] != file_stamp) {
+    stamp[k][i] = file_stamp;
+    local[k][i] = count[k]++;
+    put_string(section[k], sym->get_string(), sym->get_len());
+  }
+  return local[k][i];
+}
+
+void TokenWriter::put(int lineno, int token, YYSTYPE& yylval)
+{
+  int code = code_of_token(token, yylval);
+  if (lineno != line) {
+    tokens += (char) (code | LINE_FLAG);
+    put_varint(tokens, lineno - line);
+    line = lineno;
+  } else
+    tokens += (char) code;
+
+  switch (token) {
+  case TYPEID:
+  case OBJECTID:
+    put_varint(tokens, symbol_ref(ID_SECTION, yylval.symbol));
+    break;
+  case INT_CONST:
+    put_varint(tokens, symbol_ref(INT_SECTION, yylval.symbol));
+    break;
+  case STR_CONST:
+    put_varint(tokens, symbol_ref(STR_SECTION, yylval.symbol));
+    break;
+  case ERROR:
+    put_string(tokens, yylval.error_msg, strlen(yylval.error_msg));
+    break;
+  }
+}
+
+void TokenWriter::end_file()
+{
+  std::string rec;
+  rec += (char) FILE_TAG;
+  put_string(rec, name.data(), name.size());
+  for (int k = 0; k < NSECTIONS; k++) {
+    put_varint(rec, count[k]);
+    rec += section[k];
+  }
+  tokens += (char) END_CODE;
+  put_varint(rec, tokens.size());
+  fwrite(rec.data(), 1, rec.size(), out);
+  fwrite(tokens.data(), 1, tokens.size(), out);
+  fflush(out);
+}
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  Reading
+//
+//  A file's symbols are interned once, when its record is read, so a
+//  symbol in a token is an array load.
+//
+/////////////////////////////////////////////////////////////////////////
+
+static void corrupt()
+{
+  fatal_error("token stream: malformed input\n");
+}
+
+static unsigned get_varint(FILE *f)
+{
+  unsigned v = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    int c = getc(f);
+    if (c == EOF)
+      corrupt();
+    v |= (unsigned) (c & 0x7f) << shift;
+    if (!(c & 0x80))
+      return v;
+  }
+  corrupt();
+  return 0;
+}
+
+// a string from f, in text, NUL-terminated; returns its length
+static int get_string(FILE *f, std::vector<char>& text)
+{
+  unsigned len = get_varint(f);
+  text.resize(len + 1);
+  if (fread(text.data(), 1, len, f) != len)
+    corrupt();
+  text[len] = '\0';
+  return len;
+}
+
+template <class Elem>
+static void get_section(FILE *f, StringTable<Elem>& table,
+			std::vector<Symbol>& syms, std::vector<char>& text)
+{
+  unsigned n = get_varint(f);
+  syms.resize(n);
+  for (unsigned i = 0; i < n; i++) {
+    int len = get_string(f, text);
+    syms[i] = table.add_string(text.data(), len);
+  }
+}
+
+bool token_stream_detect(FILE *f)
+{
+  int n = sizeof(magic) - 1;
+  int i = 0, c = EOF;
+  // Only a full match is consumed.  The text format starts with '#',
+  // so a mismatch is seen at the first byte and can be pushed back.
+  while (i < n && (c = getc(f)) == (unsigned char) magic[i])
+    i++;
+  if (i < n) {
+    if (c != EOF)
+      ungetc(c, f);
+    if (i > 0)
+      corrupt();
+    return false;
+  }
+  if (getc(f) != VERSION)
+    fatal_error("token stream: unknown version\n");
+  return true;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  TokenReader
+//
+/////////////////////////////////////////////////////////////////////////
+
+TokenReader::TokenReader() : next_tok(0), filename(NULL), lineno(1) { }
+
+bool TokenReader::read_file(FILE *f)
+{
+  int tag = getc(f);
+  if (tag == EOF)
+    return false;
+  if (tag != FILE_TAG)
+    corrupt();
+
+  std::vector<char> text;
+  get_string(f, text);
+  filename = strdup(text.data());
+  get_section(f, idtable, id_syms, text);
+  get_section(f, inttable, int_syms, text);
+  get_section(f, stringtable, str_syms, text);
+
+  unsigned len = ::get_varint(f);
+  tokens.resize(len);
+  if (fread(tokens.data(), 1, len, f) != len)
+    corrupt();
+  next_tok = 0;
+  lineno = 1;
+  return true;
+}
+
+unsigned TokenReader::get_varint()
+{
+  unsigned v = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    if (next_tok >= tokens.size())
+      corrupt();
+    int c = tokens[next_tok++];
+    v |= (unsigned) (c & 0x7f) << shift;
+    if (!(c & 0x80))
+      return v;
+  }
+  corrupt();
+  return 0;
+}
+
+Symbol TokenReader::symbol(std::vector<Symbol>& syms)
+{
+  unsigned i = get_varint();
+  if (i >= syms.size())
+    corrupt();
+  return syms[i];
+}
+
+int TokenReader::lex(YYSTYPE& yylval)
+{
+  if (next_tok >= tokens.size())
+    return 0;
+
+  int code = tokens[next_tok++];
+  if (code & LINE_FLAG) {
+    code &= ~LINE_FLAG;
+    lineno += get_varint();
+  }
+  if (code == END_CODE) {
+    next_tok = tokens.size();
+    return 0;
+  }
+  if (code >= NCODES) {
+    corrupt();
+    return 0;
+  }
+
+  int token = token_of_code[code];
+  switch (code) {
+  case TRUE_CODE:  yylval.boolean = 1; break;
+  case FALSE_CODE: yylval.boolean = 0; break;
+  }
+  switch (token) {
+  case TYPEID:
+  case OBJECTID:  yylval.symbol = symbol(id_syms); break;
+  case INT_CONST: yylval.symbol = symbol(int_syms); break;
+  case STR_CONST: yylval.symbol = symbol(str_syms); break;
+  case ERROR: {
+    unsigned len = get_varint();
+    if (len > tokens.size() - next_tok)
+      corrupt();
+    yylval.error_msg = strndup((char *) &tokens[next_tok], len);
+    next_tok += len;
+    break;
+  }
+  }
+  return token;
+}
+
+bool TokenReader::at_end() const
+{
+  return next_tok >= tokens.size() ||
+    (tokens[next_tok] & ~LINE_FLAG) == END_CODE;
+}
+
+//
+// The stream as one run of tokens, file after file, through one reader.
+//
+static TokenReader stream_reader;
+
+int token_stream_lex(FILE *f)
+{
+  int token;
+  while ((token = stream_reader.lex(cool_yylval)) == 0) {
+    if (!stream_reader.read_file(f))
+      return 0;
+    curr_filename = stream_reader.get_filename();
+  }
+  curr_lineno = stream_reader.get_lineno();
+  return token;
+}
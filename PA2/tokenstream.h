@@ -0,0 +1,131 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _TOKENSTREAM_H_
+#define _TOKENSTREAM_H_
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "cool-parse.h"
+#include "stringtab.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  tokenstream.h
+//
+//  Writers for the lexer's output.  TokenDumper writes the text format of
+//  dump_cool_token; TokenWriter writes a binary format, described below.
+//
+//  A binary alternative to the text token format of dump_cool_token, for
+//  the pipe between the lexer and the parser.  The lexer writes it when
+//  given -b; the parser recognizes it by its first bytes, so the text
+//  format keeps working unchanged.
+//
+//  The stream is the magic bytes "\177CTK" and a version byte, then one
+//  record per source file:
+//
+//    'F'                       record tag
+//    name                      the file name, as a string
+//    3 symbol sections         identifiers, integers, then strings: a
+//                              count, then that many strings, each symbol
+//                              used in the file exactly once
+//    token section             its length in bytes, then the tokens,
+//                              ending with token code 0
+//
+//  Every number is an unsigned LEB128 varint and a string is its length
+//  followed by its bytes.  A token is one code byte, with the top bit set
+//  if a varint follows giving how many lines it is past the previous
+//  token (the first token of a file counts from line 1).  Identifier,
+//  integer and string constants are followed by their index in the
+//  matching symbol section; an ERROR is followed by its message as a
+//  string.  true and false have codes of their own.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+//
+// Writes exactly what dump_cool_token would for each token, but formats
+// into a buffer that goes to the file descriptor with one write(2) when
+// it fills, instead of flushing cout after every token.  Call flush
+// before anything else writes to the same descriptor.
+//
+class TokenDumper {
+private:
+  enum { BUFSIZE = 1 << 16 };
+
+  int fd;
+  char *buf;
+  int used;
+
+  char *room(int n);                    // n free bytes in buf
+  void append(const char *s, int len);
+  void append_escaped(const char *s);   // as print_escaped_string
+public:
+  TokenDumper(int fd);
+  ~TokenDumper();
+  void begin_file(const char *filename);
+  void put(int lineno, int token, YYSTYPE& yylval);
+  void flush();
+};
+
+class TokenWriter {
+private:
+  enum { ID_SECTION, INT_SECTION, STR_SECTION, NSECTIONS };
+
+  FILE *out;
+  std::string name;
+  std::string tokens;                   // the current file's tokens
+  std::string section[NSECTIONS];       // and its symbols
+  int count[NSECTIONS];
+  // local[k][i] is the index in section k of the symbol with table
+  // index i, valid if stamp[k][i] is the current file's stamp.
+  std::vector<int> local[NSECTIONS];
+  std::vector<int> stamp[NSECTIONS];
+  int file_stamp;
+  int line;
+
+  int symbol_ref(int k, Symbol sym);
+public:
+  TokenWriter(FILE *f);
+  void begin_file(const char *filename);
+  void put(int lineno, int token, YYSTYPE& yylval);
+  void end_file();                      // writes the file's record
+};
+
+// Is the stream in f in the binary format?  Consumes the magic bytes if
+// so, and nothing otherwise.
+extern bool token_stream_detect(FILE *f);
+
+//
+// Reads a binary stream one file record at a time, after
+// token_stream_detect.  Each reader keeps its own position, so the files
+// of a stream can be read in by one thread and then lexed by several.
+//
+class TokenReader {
+private:
+  std::vector<Symbol> id_syms, int_syms, str_syms;
+  std::vector<unsigned char> tokens;    // the file's tokens
+  size_t next_tok;                      // next unread byte of tokens
+  char *filename;
+  int lineno;
+
+  unsigned get_varint();
+  Symbol symbol(std::vector<Symbol>& syms);
+public:
+  TokenReader();
+  bool read_file(FILE *f);              // false at the end of the stream
+  int lex(YYSTYPE& yylval);             // 0 at the end of the file
+  bool at_end() const;                  // has the file no more tokens?
+  char *get_filename() const            { return filename; }
+  int get_lineno() const                { return lineno; }   // of the last token
+};
+
+// The next token from a binary stream in f, like cool_yylex: sets
+// cool_yylval, curr_lineno and curr_filename, and returns 0 at the end
+// of the stream.
+extern int token_stream_lex(FILE *f);
+
+#endif
@@ -55,7 +55,7 @@
 #define YYSKELETON_NAME "yacc.c"
 
 /* Pure parsers.  */
-#define YYPURE 0
+#define YYPURE 2
 
 /* Push parsers.  */
 #define YYPUSH 0
@@ -70,9 +70,6 @@
 #define yyerror         cool_yyerror
 #define yydebug         cool_yydebug
 #define yynerrs         cool_yynerrs
-#define yylval          cool_yylval
-#define yychar          cool_yychar
-#define yylloc          cool_yylloc
 
 /* First part of user prologue.  */
 #line 1 "cool.y"
@@ -81,39 +78,58 @@
 #include "cool-tree.h"
 #include "stringtab.h"
 #include "utilities.h"
+#include "parsestate.h"
 
-extern char *curr_filename;
-extern int curr_lineno;
+// A location is just the line.  It is kept in a struct, rather than an
+// int, only so that the parser's stacks can grow on the heap as deep as
+// a program nests (to a million or so levels): bison moves them in C++
+// only when told both stacks' types can be copied as bytes.
+struct YYLTYPE {
+  int first_line, first_column, last_line, last_column;
+
+  operator int() const { return first_line; }
+  YYLTYPE& operator=(int line)
+  {
+    first_line = last_line = line;
+    first_column = last_column = 0;
+    return *this;
+  }
+};
+#define YYLTYPE_IS_DECLARED 1
+#define YYLTYPE_IS_TRIVIAL 1
+#define YYSTYPE_IS_TRIVIAL 1
+#define YYMAXDEPTH (1 << 24)
 
-#define YYLTYPE int
 #define YYLLOC_DEFAULT(Current, Rhs, N)         \
     Current = Rhs[1]; \
     node_lineno = Current;
 
-extern int node_lineno;
+// Each thread builds its own nodes; see parser-phase.cc.
+extern thread_local int node_lineno;
 
 #define SET_NODELOC(Current)  \
     node_lineno = Current;
 
-void yyerror(char *s);
-extern int cool_yylex();
 extern Symbol self_sym;
 
-static int yylex_wrapper() {
-  extern YYLTYPE cool_yylloc;
-  int token = cool_yylex();
-  cool_yylloc = curr_lineno;
+static int yylex_wrapper(YYSTYPE *yylval, YYLTYPE *yylloc, ParseState *ps) {
+  int token = parse_lex(ps, yylval);
+  *yylloc = ps->lineno;
   return token;
 }
 #define yylex yylex_wrapper
 
+static void yyerror(YYLTYPE *yylloc, ParseState *ps, const char *s) {
+  parse_error(ps, s);
+}
+
 /************************************************************************/
 
 Program ast_root;
 Classes parse_results;
 int omerrs = 0;
 
-#line 117 "cool.tab.c"
+#line 133 "cool.tab.c"
 
 # ifndef YY_CAST
 #  ifdef __cplusplus
@@ -588,15 +604,15 @@ static const yytype_int8 yytranslate[] =
 
 #if YYDEBUG
 /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
-static const yytype_uint8 yyrline[] =
+static const yytype_int16 yyrline[] =
 {
-       0,    91,    91,    95,    97,   101,   103,   105,   110,   111,
-     115,   117,   119,   124,   125,   127,   131,   136,   137,   139,
-     143,   145,   149,   151,   153,   155,   157,   159,   161,   163,
-     165,   167,   169,   171,   173,   175,   177,   179,   181,   183,
-     185,   187,   189,   191,   193,   195,   199,   204,   209,   211,
-     213,   215,   217,   219,   221,   223,   225,   227,   229,   231,
-     233,   238,   240,   244
+       0,   114,   114,   118,   120,   124,   126,   128,   133,   134,
+     138,   140,   142,   147,   148,   150,   154,   159,   160,   162,
+     166,   168,   172,   174,   176,   178,   180,   182,   184,   186,
+     188,   190,   192,   194,   196,   198,   200,   202,   204,   206,
+     208,   210,   212,   214,   216,   218,   222,   227,   232,   234,
+     236,   238,   240,   242,   244,   246,   248,   250,   252,   254,
+     256,   261,   263,   267
 };
 #endif
 
@@ -880,7 +896,7 @@ enum { YYENOMEM = -2 };
       }                                                           \
     else                                                          \
       {                                                           \
-        yyerror (YY_("syntax error: cannot back up")); \
+        yyerror (&yylloc, ps, YY_("syntax error: cannot back up")); \
         YYERROR;                                                  \
       }                                                           \
   while (0)
@@ -996,7 +1012,7 @@ do {                                                                      \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Kind, Value, Location); \
+                  Kind, Value, Location, ps); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -1008,11 +1024,12 @@ do {                                                                      \
 
 static void
 yy_symbol_value_print (FILE *yyo,
-                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp)
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, ParseState *ps)
 {
   FILE *yyoutput = yyo;
   YY_USE (yyoutput);
   YY_USE (yylocationp);
+  YY_USE (ps);
   if (!yyvaluep)
     return;
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
@@ -1027,14 +1044,14 @@ yy_symbol_value_print (FILE *yyo,
 
 static void
 yy_symbol_print (FILE *yyo,
-                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp)
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, ParseState *ps)
 {
   YYFPRINTF (yyo, "%s %s (",
              yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
   YYLOCATION_PRINT (yyo, yylocationp);
   YYFPRINTF (yyo, ": ");
-  yy_symbol_value_print (yyo, yykind, yyvaluep, yylocationp);
+  yy_symbol_value_print (yyo, yykind, yyvaluep, yylocationp, ps);
   YYFPRINTF (yyo, ")");
 }
 
@@ -1068,7 +1085,7 @@ do {                                                            \
 
 static void
 yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp,
-                 int yyrule)
+                 int yyrule, ParseState *ps)
 {
   int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
@@ -1082,7 +1099,7 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp,
       yy_symbol_print (stderr,
                        YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
                        &yyvsp[(yyi + 1) - (yynrhs)],
-                       &(yylsp[(yyi + 1) - (yynrhs)]));
+                       &(yylsp[(yyi + 1) - (yynrhs)]), ps);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -1090,7 +1107,7 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp,
 # define YY_REDUCE_PRINT(Rule)          \
 do {                                    \
   if (yydebug)                          \
-    yy_reduce_print (yyssp, yyvsp, yylsp, Rule); \
+    yy_reduce_print (yyssp, yyvsp, yylsp, Rule, ps); \
 } while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
@@ -1131,10 +1148,11 @@ int yydebug;
 
 static void
 yydestruct (const char *yymsg,
-            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, YYLTYPE *yylocationp)
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, YYLTYPE *yylocationp, ParseState *ps)
 {
   YY_USE (yyvaluep);
   YY_USE (yylocationp);
+  YY_USE (ps);
   if (!yymsg)
     yymsg = "Deleting";
   YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
@@ -1145,30 +1163,38 @@ yydestruct (const char *yymsg,
 }
 
 
+
+
+
+
+/*----------.
+| yyparse.  |
+`----------*/
+
+int
+yyparse (ParseState *ps)
+{
 /* Lookahead token kind.  */
 int yychar;
 
+
 /* The semantic value of the lookahead symbol.  */
-YYSTYPE yylval;
+/* Default value used for initialization, for pacifying older GCCs
+   or non-GCC compilers.  */
+YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
+YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
+
 /* Location data for the lookahead symbol.  */
-YYLTYPE yylloc
+static YYLTYPE yyloc_default
 # if defined YYLTYPE_IS_TRIVIAL && YYLTYPE_IS_TRIVIAL
   = { 1, 1, 1, 1 }
 # endif
 ;
-/* Number of syntax errors so far.  */
-int yynerrs;
-
-
-
+YYLTYPE yylloc = yyloc_default;
 
-/*----------.
-| yyparse.  |
-`----------*/
+    /* Number of syntax errors so far.  */
+    int yynerrs = 0;
 
-int
-yyparse (void)
-{
     yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
     int yyerrstatus = 0;
@@ -1336,7 +1362,7 @@ yybackup:
   if (yychar == YYEMPTY)
     {
       YYDPRINTF ((stderr, "Reading a token\n"));
-      yychar = yylex ();
+      yychar = yylex (&yylval, &yylloc, ps);
     }
 
   if (yychar <= YYEOF)
@@ -1428,385 +1454,385 @@ yyreduce:
   switch (yyn)
     {
   case 2: /* program: cool_list  */
-#line 92 "cool.y"
-          { (yyloc) = (yylsp[0]); ast_root = program((yyvsp[0].classes)); }
-#line 1434 "cool.tab.c"
+#line 115 "cool.y"
+          { (yyloc) = (yylsp[0]); ps->ast_root = program((yyvsp[0].classes)); }
+#line 1460 "cool.tab.c"
     break;
 
   case 3: /* cool_list: class  */
-#line 96 "cool.y"
+#line 119 "cool.y"
              { (yyloc) = (yylsp[0]); (yyval.classes) = single_Classes((yyvsp[0].class_)); }
-#line 1440 "cool.tab.c"
+#line 1466 "cool.tab.c"
     break;
 
   case 4: /* cool_list: cool_list class  */
-#line 98 "cool.y"
+#line 121 "cool.y"
              { (yyloc) = (yylsp[-1]); (yyval.classes) = append_Classes((yyvsp[-1].classes), single_Classes((yyvsp[0].class_))); }
-#line 1446 "cool.tab.c"
+#line 1472 "cool.tab.c"
     break;
 
   case 5: /* class: CLASS TYPEID '{' class_element '}' ';'  */
-#line 102 "cool.y"
-        { (yyloc) = (yylsp[-5]); Symbol obj_sym = idtable.add_string("Object"); (yyval.class_) = class_((yyvsp[-4].symbol), obj_sym, (yyvsp[-2].features), stringtable.add_string(curr_filename)); }
-#line 1452 "cool.tab.c"
+#line 125 "cool.y"
+        { (yyloc) = (yylsp[-5]); Symbol obj_sym = predef_symbol(PREDEF_Object); (yyval.class_) = class_((yyvsp[-4].symbol), obj_sym, (yyvsp[-2].features), stringtable.add_string(ps->filename)); }
+#line 1478 "cool.tab.c"
     break;
 
   case 6: /* class: CLASS TYPEID INHERITS TYPEID '{' class_element '}' ';'  */
-#line 104 "cool.y"
-        { (yyloc) = (yylsp[-7]); (yyval.class_) = class_((yyvsp[-6].symbol), (yyvsp[-4].symbol), (yyvsp[-2].features), stringtable.add_string(curr_filename)); }
-#line 1458 "cool.tab.c"
+#line 127 "cool.y"
+        { (yyloc) = (yylsp[-7]); (yyval.class_) = class_((yyvsp[-6].symbol), (yyvsp[-4].symbol), (yyvsp[-2].features), stringtable.add_string(ps->filename)); }
+#line 1484 "cool.tab.c"
     break;
 
   case 7: /* class: error ';'  */
-#line 106 "cool.y"
-        { (yyloc) = (yylsp[-1]); Symbol err_sym = idtable.add_string("Error"); Symbol obj_sym = idtable.add_string("Object"); (yyval.class_) = class_(err_sym, obj_sym, nil_Features(), stringtable.add_string(curr_filename)); }
-#line 1464 "cool.tab.c"
+#line 129 "cool.y"
+        { (yyloc) = (yylsp[-1]); Symbol err_sym = idtable.add_string("Error"); Symbol obj_sym = predef_symbol(PREDEF_Object); (yyval.class_) = class_(err_sym, obj_sym, nil_Features(), stringtable.add_string(ps->filename)); }
+#line 1490 "cool.tab.c"
     break;
 
   case 8: /* class_element: %empty  */
-#line 110 "cool.y"
+#line 133 "cool.y"
                { (yyval.features) = nil_Features(); }
-#line 1470 "cool.tab.c"
+#line 1496 "cool.tab.c"
     break;
 
   case 9: /* class_element: class_element feature_item ';'  */
-#line 112 "cool.y"
+#line 135 "cool.y"
                { (yyloc) = (yylsp[-1]); (yyval.features) = append_Features((yyvsp[-2].features), single_Features((yyvsp[-1].feature))); }
-#line 1476 "cool.tab.c"
+#line 1502 "cool.tab.c"
     break;
 
   case 10: /* feature_item: OBJECTID '(' formal_arg ')' ':' TYPEID '{' expr '}'  */
-#line 116 "cool.y"
+#line 139 "cool.y"
           { (yyloc) = (yylsp[-8]); (yyval.feature) = method((yyvsp[-8].symbol), (yyvsp[-6].formals), (yyvsp[-3].symbol), (yyvsp[-1].expression)); }
-#line 1482 "cool.tab.c"
+#line 1508 "cool.tab.c"
     break;
 
   case 11: /* feature_item: OBJECTID ':' TYPEID ASSIGN expr  */
-#line 118 "cool.y"
+#line 141 "cool.y"
           { (yyloc) = (yylsp[-4]); (yyval.feature) = attr((yyvsp[-4].symbol), (yyvsp[-2].symbol), (yyvsp[0].expression)); }
-#line 1488 "cool.tab.c"
+#line 1514 "cool.tab.c"
     break;
 
   case 12: /* feature_item: OBJECTID ':' TYPEID  */
-#line 120 "cool.y"
+#line 143 "cool.y"
           { (yyloc) = (yylsp[-2]); Expression no_init = no_expr(); SET_NODELOC((yylsp[-2])); (yyval.feature) = attr((yyvsp[-2].symbol), (yyvsp[0].symbol), no_init); }
-#line 1494 "cool.tab.c"
+#line 1520 "cool.tab.c"
     break;
 
   case 13: /* formal_arg: %empty  */
-#line 124 "cool.y"
+#line 147 "cool.y"
               { (yyval.formals) = nil_Formals(); }
-#line 1500 "cool.tab.c"
+#line 1526 "cool.tab.c"
     break;
 
   case 14: /* formal_arg: formal  */
-#line 126 "cool.y"
+#line 149 "cool.y"
               { (yyval.formals) = single_Formals((yyvsp[0].formal)); }
-#line 1506 "cool.tab.c"
+#line 1532 "cool.tab.c"
     break;
 
   case 15: /* formal_arg: formal_arg ',' formal  */
-#line 128 "cool.y"
+#line 151 "cool.y"
               { (yyloc) = (yylsp[-2]); (yyval.formals) = append_Formals((yyvsp[-2].formals), single_Formals((yyvsp[0].formal))); }
-#line 1512 "cool.tab.c"
+#line 1538 "cool.tab.c"
     break;
 
   case 16: /* formal: OBJECTID ':' TYPEID  */
-#line 132 "cool.y"
+#line 155 "cool.y"
          { (yyloc) = (yylsp[-2]); (yyval.formal) = formal((yyvsp[-2].symbol), (yyvsp[0].symbol)); }
-#line 1518 "cool.tab.c"
+#line 1544 "cool.tab.c"
     break;
 
   case 17: /* arg_list_call: %empty  */
-#line 136 "cool.y"
+#line 159 "cool.y"
             { (yyval.expressions) = nil_Expressions(); }
-#line 1524 "cool.tab.c"
+#line 1550 "cool.tab.c"
     break;
 
   case 18: /* arg_list_call: expr  */
-#line 138 "cool.y"
+#line 161 "cool.y"
             { (yyval.expressions) = single_Expressions((yyvsp[0].expression)); }
-#line 1530 "cool.tab.c"
+#line 1556 "cool.tab.c"
     break;
 
   case 19: /* arg_list_call: arg_list_call ',' expr  */
-#line 140 "cool.y"
+#line 163 "cool.y"
             { (yyloc) = (yylsp[-2]); (yyval.expressions) = append_Expressions((yyvsp[-2].expressions), single_Expressions((yyvsp[0].expression))); }
-#line 1536 "cool.tab.c"
+#line 1562 "cool.tab.c"
     break;
 
   case 20: /* block_sequence: expr ';'  */
-#line 144 "cool.y"
+#line 167 "cool.y"
                   { (yyval.expressions) = single_Expressions((yyvsp[-1].expression)); }
-#line 1542 "cool.tab.c"
+#line 1568 "cool.tab.c"
     break;
 
   case 21: /* block_sequence: block_sequence expr ';'  */
-#line 146 "cool.y"
+#line 169 "cool.y"
                   { (yyloc) = (yylsp[-2]); (yyval.expressions) = append_Expressions((yyvsp[-2].expressions), single_Expressions((yyvsp[-1].expression))); }
-#line 1548 "cool.tab.c"
+#line 1574 "cool.tab.c"
     break;
 
   case 22: /* expr: INT_CONST  */
-#line 150 "cool.y"
+#line 173 "cool.y"
        { (yyloc) = (yylsp[0]); SET_NODELOC((yylsp[0])); (yyval.expression) = int_const((yyvsp[0].symbol)); }
-#line 1554 "cool.tab.c"
+#line 1580 "cool.tab.c"
     break;
 
   case 23: /* expr: STR_CONST  */
-#line 152 "cool.y"
+#line 175 "cool.y"
        { (yyloc) = (yylsp[0]); SET_NODELOC((yylsp[0])); (yyval.expression) = string_const((yyvsp[0].symbol)); }
-#line 1560 "cool.tab.c"
+#line 1586 "cool.tab.c"
     break;
 
   case 24: /* expr: BOOL_CONST  */
-#line 154 "cool.y"
+#line 177 "cool.y"
        { (yyloc) = (yylsp[0]); SET_NODELOC((yylsp[0])); (yyval.expression) = bool_const((yyvsp[0].boolean)); }
-#line 1566 "cool.tab.c"
+#line 1592 "cool.tab.c"
     break;
 
   case 25: /* expr: OBJECTID  */
-#line 156 "cool.y"
+#line 179 "cool.y"
        { (yyloc) = (yylsp[0]); SET_NODELOC((yylsp[0])); (yyval.expression) = object((yyvsp[0].symbol)); }
-#line 1572 "cool.tab.c"
+#line 1598 "cool.tab.c"
     break;
 
   case 26: /* expr: OBJECTID ASSIGN expr  */
-#line 158 "cool.y"
+#line 181 "cool.y"
        { (yyloc) = (yylsp[-2]); SET_NODELOC((yylsp[-2])); (yyval.expression) = assign((yyvsp[-2].symbol), (yyvsp[0].expression)); }
-#line 1578 "cool.tab.c"
+#line 1604 "cool.tab.c"
     break;
 
   case 27: /* expr: expr '*' expr  */
-#line 160 "cool.y"
+#line 183 "cool.y"
        { (yyloc) = (yylsp[-2]); SET_NODELOC((yylsp[-2])); (yyval.expression) = mul((yyvsp[-2].expression), (yyvsp[0].expression)); }
-#line 1584 "cool.tab.c"
+#line 1610 "cool.tab.c"
     break;
 
   case 28: /* expr: expr '/' expr  */
-#line 162 "cool.y"
+#line 185 "cool.y"
        { (yyloc) = (yylsp[-2]); SET_NODELOC((yylsp[-2])); (yyval.expression) = divide((yyvsp[-2].expression), (yyvsp[0].expression)); }
-#line 1590 "cool.tab.c"
+#line 1616 "cool.tab.c"
     break;
 
   case 29: /* expr: expr '+' expr  */
-#line 164 "cool.y"
+#line 187 "cool.y"
        { (yyloc) = (yylsp[-2]); SET_NODELOC((yylsp[-2])); (yyval.expression) = plus((yyvsp[-2].expression), (yyvsp[0].expression)); }
-#line 1596 "cool.tab.c"
+#line 1622 "cool.tab.c"
     break;
 
   case 30: /* expr: expr '-' expr  */
-#line 166 "cool.y"
+#line 189 "cool.y"
        { (yyloc) = (yylsp[-2]); SET_NODELOC((yylsp[-2])); (yyval.expression) = sub((yyvsp[-2].expression), (yyvsp[0].expression)); }
-#line 1602 "cool.tab.c"
+#line 1628 "cool.tab.c"
     break;
 
   case 31: /* expr: OBJECTID '(' arg_list_call ')'  */
-#line 168 "cool.y"
+#line 191 "cool.y"
        { (yyloc) = (yylsp[-3]); SET_NODELOC((yylsp[-3])); (yyval.expression) = dispatch(object(self_sym), (yyvsp[-3].symbol), (yyvsp[-1].expressions)); }
-#line 1608 "cool.tab.c"
+#line 1634 "cool.tab.c"
     break;
 
   case 32: /* expr: expr '.' OBJECTID '(' arg_list_call ')'  */
-#line 170 "cool.y"
+#line 193 "cool.y"
        { (yyloc) = (yylsp[-5]); SET_NODELOC((yylsp[-5])); (yyval.expression) = dispatch((yyvsp[-5].expression), (yyvsp[-3].symbol), (yyvsp[-1].expressions)); }
-#line 1614 "cool.tab.c"
+#line 1640 "cool.tab.c"
     break;
 
   case 33: /* expr: expr '@' TYPEID '.' OBJECTID '(' arg_list_call ')'  */
-#line 172 "cool.y"
+#line 195 "cool.y"
        { (yyloc) = (yylsp[-7]); SET_NODELOC((yylsp[-7])); (yyval.expression) = static_dispatch((yyvsp[-7].expression), (yyvsp[-5].symbol), (yyvsp[-3].symbol), (yyvsp[-1].expressions)); }
-#line 1620 "cool.tab.c"
+#line 1646 "cool.tab.c"
     break;
 
   case 34: /* expr: IF expr THEN expr ELSE expr FI  */
-#line 174 "cool.y"
+#line 197 "cool.y"
        { (yyloc) = (yylsp[-6]); SET_NODELOC((yylsp[-6])); (yyval.expression) = cond((yyvsp[-5].expression), (yyvsp[-3].expression), (yyvsp[-1].expression)); }
-#line 1626 "cool.tab.c"
+#line 1652 "cool.tab.c"
     break;
 
   case 35: /* expr: WHILE expr LOOP expr POOL  */
-#line 176 "cool.y"
+#line 199 "cool.y"
        { (yyloc) = (yylsp[-4]); SET_NODELOC((yylsp[-4])); (yyval.expression) = loop((yyvsp[-3].expression), (yyvsp[-1].expression)); }
-#line 1632 "cool.tab.c"
+#line 1658 "cool.tab.c"
     break;
 
   case 36: /* expr: NEW TYPEID  */
-#line 178 "cool.y"
+#line 201 "cool.y"
        { (yyloc) = (yylsp[-1]); SET_NODELOC((yylsp[-1])); (yyval.expression) = new_((yyvsp[0].symbol)); }
-#line 1638 "cool.tab.c"
+#line 1664 "cool.tab.c"
     break;
 
   case 37: /* expr: ISVOID expr  */
-#line 180 "cool.y"
+#line 203 "cool.y"
        { (yyloc) = (yylsp[-1]); SET_NODELOC((yylsp[-1])); (yyval.expression) = isvoid((yyvsp[0].expression)); }
-#line 1644 "cool.tab.c"
+#line 1670 "cool.tab.c"
     break;
 
   case 38: /* expr: '~' expr  */
-#line 182 "cool.y"
+#line 205 "cool.y"
        { (yyloc) = (yylsp[-1]); SET_NODELOC((yylsp[-1])); (yyval.expression) = neg((yyvsp[0].expression)); }
-#line 1650 "cool.tab.c"
+#line 1676 "cool.tab.c"
     break;
 
   case 39: /* expr: NOT expr  */
-#line 184 "cool.y"
+#line 207 "cool.y"
        { (yyloc) = (yylsp[-1]); SET_NODELOC((yylsp[-1])); (yyval.expression) = comp((yyvsp[0].expression)); }
-#line 1656 "cool.tab.c"
+#line 1682 "cool.tab.c"
     break;
 
   case 40: /* expr: expr '<' expr  */
-#line 186 "cool.y"
+#line 209 "cool.y"
        { (yyloc) = (yylsp[-2]); SET_NODELOC((yylsp[-2])); (yyval.expression) = lt((yyvsp[-2].expression), (yyvsp[0].expression)); }
-#line 1662 "cool.tab.c"
+#line 1688 "cool.tab.c"
     break;
 
   case 41: /* expr: expr LE expr  */
-#line 188 "cool.y"
+#line 211 "cool.y"
        { (yyloc) = (yylsp[-2]); SET_NODELOC((yylsp[-2])); (yyval.expression) = leq((yyvsp[-2].expression), (yyvsp[0].expression)); }
-#line 1668 "cool.tab.c"
+#line 1694 "cool.tab.c"
     break;
 
   case 42: /* expr: expr '=' expr  */
-#line 190 "cool.y"
+#line 213 "cool.y"
        { (yyloc) = (yylsp[-2]); SET_NODELOC((yylsp[-2])); (yyval.expression) = eq((yyvsp[-2].expression), (yyvsp[0].expression)); }
-#line 1674 "cool.tab.c"
+#line 1700 "cool.tab.c"
     break;
 
   case 43: /* expr: CASE expr OF case_list ESAC  */
-#line 192 "cool.y"
+#line 215 "cool.y"
        { (yyloc) = (yylsp[-4]); SET_NODELOC((yylsp[-4])); (yyval.expression) = typcase((yyvsp[-3].expression), (yyvsp[-1].cases)); }
-#line 1680 "cool.tab.c"
+#line 1706 "cool.tab.c"
     break;
 
   case 44: /* expr: '{' block_sequence '}'  */
-#line 194 "cool.y"
+#line 217 "cool.y"
        { (yyloc) = (yylsp[-2]); SET_NODELOC((yylsp[-2])); (yyval.expression) = block((yyvsp[-1].expressions)); }
-#line 1686 "cool.tab.c"
+#line 1712 "cool.tab.c"
     break;
 
   case 45: /* expr: '(' expr ')'  */
-#line 196 "cool.y"
+#line 219 "cool.y"
        { (yyloc) = (yylsp[-2]); (yyval.expression) = (yyvsp[-1].expression); }
-#line 1692 "cool.tab.c"
+#line 1718 "cool.tab.c"
     break;
 
   case 46: /* expr: LET OBJECTID ':' TYPEID ASSIGN expr ',' OBJECTID ':' TYPEID ASSIGN expr ',' OBJECTID ':' TYPEID ASSIGN expr IN expr  */
-#line 200 "cool.y"
+#line 223 "cool.y"
        { (yyloc) = (yylsp[-19]); SET_NODELOC((yylsp[-19])); Expression let3_init = (yyvsp[-2].expression); Expression let2_init = (yyvsp[-8].expression); Expression let1_init = (yyvsp[-14].expression); 
          Expression let3 = let((yyvsp[-6].symbol), (yyvsp[-4].symbol), let3_init, (yyvsp[0].expression));
          Expression let2 = let((yyvsp[-12].symbol), (yyvsp[-10].symbol), let2_init, let3);
          (yyval.expression) = let((yyvsp[-18].symbol), (yyvsp[-16].symbol), let1_init, let2); }
-#line 1701 "cool.tab.c"
+#line 1727 "cool.tab.c"
     break;
 
   case 47: /* expr: LET OBJECTID ':' TYPEID ',' OBJECTID ':' TYPEID ',' OBJECTID ':' TYPEID IN expr  */
-#line 205 "cool.y"
+#line 228 "cool.y"
        { (yyloc) = (yylsp[-13]); SET_NODELOC((yylsp[-13])); Expression no_init = no_expr(); 
          Expression let3 = let((yyvsp[-4].symbol), (yyvsp[-2].symbol), no_init, (yyvsp[0].expression));
          Expression let2 = let((yyvsp[-8].symbol), (yyvsp[-6].symbol), no_init, let3);
          (yyval.expression) = let((yyvsp[-12].symbol), (yyvsp[-10].symbol), no_init, let2); }
-#line 1710 "cool.tab.c"
+#line 1736 "cool.tab.c"
     break;
 
   case 48: /* expr: LET OBJECTID ':' TYPEID IN expr  */
-#line 210 "cool.y"
+#line 233 "cool.y"
        { (yyloc) = (yylsp[-5]); SET_NODELOC((yylsp[-5])); Expression no_init = no_expr(); (yyval.expression) = let((yyvsp[-4].symbol), (yyvsp[-2].symbol), no_init, (yyvsp[0].expression)); }
-#line 1716 "cool.tab.c"
+#line 1742 "cool.tab.c"
     break;
 
   case 49: /* expr: LET OBJECTID ':' TYPEID ASSIGN expr IN expr  */
-#line 212 "cool.y"
+#line 235 "cool.y"
        { (yyloc) = (yylsp[-7]); SET_NODELOC((yylsp[-7])); (yyval.expression) = let((yyvsp[-6].symbol), (yyvsp[-4].symbol), (yyvsp[-2].expression), (yyvsp[0].expression)); }
-#line 1722 "cool.tab.c"
+#line 1748 "cool.tab.c"
     break;
 
   case 50: /* expr: LET OBJECTID ':' TYPEID ',' OBJECTID ':' TYPEID IN expr  */
-#line 214 "cool.y"
+#line 237 "cool.y"
        { (yyloc) = (yylsp[-9]); SET_NODELOC((yylsp[-9])); Expression no_init = no_expr(); Expression let2 = let((yyvsp[-4].symbol), (yyvsp[-2].symbol), no_init, (yyvsp[0].expression)); (yyval.expression) = let((yyvsp[-8].symbol), (yyvsp[-6].symbol), no_init, let2); }
-#line 1728 "cool.tab.c"
+#line 1754 "cool.tab.c"
     break;
 
   case 51: /* expr: LET OBJECTID ':' TYPEID ASSIGN expr ',' OBJECTID ':' TYPEID IN expr  */
-#line 216 "cool.y"
+#line 239 "cool.y"
        { (yyloc) = (yylsp[-11]); SET_NODELOC((yylsp[-11])); Expression no_init = no_expr(); Expression let2 = let((yyvsp[-4].symbol), (yyvsp[-2].symbol), no_init, (yyvsp[0].expression)); (yyval.expression) = let((yyvsp[-10].symbol), (yyvsp[-8].symbol), (yyvsp[-6].expression), let2); }
-#line 1734 "cool.tab.c"
+#line 1760 "cool.tab.c"
     break;
 
   case 52: /* expr: LET OBJECTID ':' TYPEID ',' OBJECTID ':' TYPEID ASSIGN expr IN expr  */
-#line 218 "cool.y"
+#line 241 "cool.y"
        { (yyloc) = (yylsp[-11]); SET_NODELOC((yylsp[-11])); Expression no_init = no_expr(); Expression let2 = let((yyvsp[-6].symbol), (yyvsp[-4].symbol), (yyvsp[-2].expression), (yyvsp[0].expression)); (yyval.expression) = let((yyvsp[-10].symbol), (yyvsp[-8].symbol), no_init, let2); }
-#line 1740 "cool.tab.c"
+#line 1766 "cool.tab.c"
     break;
 
   case 53: /* expr: LET OBJECTID ':' TYPEID ASSIGN expr ',' OBJECTID ':' TYPEID ASSIGN expr IN expr  */
-#line 220 "cool.y"
+#line 243 "cool.y"
        { (yyloc) = (yylsp[-13]); SET_NODELOC((yylsp[-13])); Expression let2 = let((yyvsp[-6].symbol), (yyvsp[-4].symbol), (yyvsp[-2].expression), (yyvsp[0].expression)); (yyval.expression) = let((yyvsp[-12].symbol), (yyvsp[-10].symbol), (yyvsp[-8].expression), let2); }
-#line 1746 "cool.tab.c"
+#line 1772 "cool.tab.c"
     break;
 
   case 54: /* expr: LET OBJECTID ':' TYPEID ',' OBJECTID ':' TYPEID ',' OBJECTID ':' TYPEID ASSIGN expr IN expr  */
-#line 222 "cool.y"
+#line 245 "cool.y"
        { (yyloc) = (yylsp[-15]); SET_NODELOC((yylsp[-15])); Expression no_init = no_expr(); Expression let3 = let((yyvsp[-6].symbol), (yyvsp[-4].symbol), (yyvsp[-2].expression), (yyvsp[0].expression)); Expression let2 = let((yyvsp[-10].symbol), (yyvsp[-8].symbol), no_init, let3); (yyval.expression) = let((yyvsp[-14].symbol), (yyvsp[-12].symbol), no_init, let2); }
-#line 1752 "cool.tab.c"
+#line 1778 "cool.tab.c"
     break;
 
   case 55: /* expr: LET OBJECTID ':' TYPEID ASSIGN expr ',' OBJECTID ':' TYPEID ',' OBJECTID ':' TYPEID IN expr  */
-#line 224 "cool.y"
+#line 247 "cool.y"
        { (yyloc) = (yylsp[-15]); SET_NODELOC((yylsp[-15])); Expression no_init = no_expr(); Expression let3 = let((yyvsp[-4].symbol), (yyvsp[-2].symbol), no_init, (yyvsp[0].expression)); Expression let2 = let((yyvsp[-8].symbol), (yyvsp[-6].symbol), no_init, let3); (yyval.expression) = let((yyvsp[-14].symbol), (yyvsp[-12].symbol), (yyvsp[-10].expression), let2); }
-#line 1758 "cool.tab.c"
+#line 1784 "cool.tab.c"
     break;
 
   case 56: /* expr: LET OBJECTID ':' TYPEID ASSIGN expr ',' OBJECTID ':' TYPEID ASSIGN expr ',' OBJECTID ':' TYPEID IN expr  */
-#line 226 "cool.y"
+#line 249 "cool.y"
        { (yyloc) = (yylsp[-17]); SET_NODELOC((yylsp[-17])); Expression no_init = no_expr(); Expression let3 = let((yyvsp[-4].symbol), (yyvsp[-2].symbol), no_init, (yyvsp[0].expression)); Expression let2 = let((yyvsp[-10].symbol), (yyvsp[-8].symbol), (yyvsp[-6].expression), let3); (yyval.expression) = let((yyvsp[-16].symbol), (yyvsp[-14].symbol), (yyvsp[-12].expression), let2); }
-#line 1764 "cool.tab.c"
+#line 1790 "cool.tab.c"
     break;
 
   case 57: /* expr: LET OBJECTID ':' TYPEID ASSIGN expr ',' OBJECTID ':' TYPEID ',' OBJECTID ':' TYPEID ASSIGN expr IN expr  */
-#line 228 "cool.y"
+#line 251 "cool.y"
        { (yyloc) = (yylsp[-17]); SET_NODELOC((yylsp[-17])); Expression no_init = no_expr(); Expression let3 = let((yyvsp[-6].symbol), (yyvsp[-4].symbol), (yyvsp[-2].expression), (yyvsp[0].expression)); Expression let2 = let((yyvsp[-10].symbol), (yyvsp[-8].symbol), no_init, let3); (yyval.expression) = let((yyvsp[-16].symbol), (yyvsp[-14].symbol), (yyvsp[-12].expression), let2); }
-#line 1770 "cool.tab.c"
+#line 1796 "cool.tab.c"
     break;
 
   case 58: /* expr: LET OBJECTID ':' TYPEID ',' OBJECTID ':' TYPEID ASSIGN expr ',' OBJECTID ':' TYPEID ASSIGN expr IN expr  */
-#line 230 "cool.y"
+#line 253 "cool.y"
        { (yyloc) = (yylsp[-17]); SET_NODELOC((yylsp[-17])); Expression no_init = no_expr(); Expression let3 = let((yyvsp[-6].symbol), (yyvsp[-4].symbol), (yyvsp[-2].expression), (yyvsp[0].expression)); Expression let2 = let((yyvsp[-12].symbol), (yyvsp[-10].symbol), (yyvsp[-8].expression), let3); (yyval.expression) = let((yyvsp[-16].symbol), (yyvsp[-14].symbol), no_init, let2); }
-#line 1776 "cool.tab.c"
+#line 1802 "cool.tab.c"
     break;
 
   case 59: /* expr: LET OBJECTID ':' TYPEID ASSIGN expr ',' OBJECTID ':' TYPEID ASSIGN expr ',' OBJECTID ':' TYPEID ASSIGN expr IN expr  */
-#line 232 "cool.y"
+#line 255 "cool.y"
        { (yyloc) = (yylsp[-19]); SET_NODELOC((yylsp[-19])); Expression let3 = let((yyvsp[-6].symbol), (yyvsp[-4].symbol), (yyvsp[-2].expression), (yyvsp[0].expression)); Expression let2 = let((yyvsp[-12].symbol), (yyvsp[-10].symbol), (yyvsp[-8].expression), let3); (yyval.expression) = let((yyvsp[-18].symbol), (yyvsp[-16].symbol), (yyvsp[-14].expression), let2); }
-#line 1782 "cool.tab.c"
+#line 1808 "cool.tab.c"
     break;
 
   case 60: /* expr: LET OBJECTID ':' TYPEID ',' OBJECTID ':' TYPEID ASSIGN expr ',' OBJECTID ':' TYPEID IN expr  */
-#line 234 "cool.y"
+#line 257 "cool.y"
        { (yyloc) = (yylsp[-15]); SET_NODELOC((yylsp[-15])); Expression no_init = no_expr(); Expression let3 = let((yyvsp[-4].symbol), (yyvsp[-2].symbol), no_init, (yyvsp[0].expression)); Expression let2 = let((yyvsp[-10].symbol), (yyvsp[-8].symbol), (yyvsp[-6].expression), let3); (yyval.expression) = let((yyvsp[-14].symbol), (yyvsp[-12].symbol), no_init, let2); }
-#line 1788 "cool.tab.c"
+#line 1814 "cool.tab.c"
     break;
 
   case 61: /* case_list: case_branch  */
-#line 239 "cool.y"
+#line 262 "cool.y"
             { (yyval.cases) = single_Cases((yyvsp[0].case_)); }
-#line 1794 "cool.tab.c"
+#line 1820 "cool.tab.c"
     break;
 
   case 62: /* case_list: case_list case_branch  */
-#line 241 "cool.y"
+#line 264 "cool.y"
             { (yyloc) = (yylsp[-1]); (yyval.cases) = append_Cases((yyvsp[-1].cases), single_Cases((yyvsp[0].case_))); }
-#line 1800 "cool.tab.c"
+#line 1826 "cool.tab.c"
     break;
 
   case 63: /* case_branch: OBJECTID ':' TYPEID DARROW expr ';'  */
-#line 245 "cool.y"
+#line 268 "cool.y"
                { (yyloc) = (yylsp[-5]); SET_NODELOC((yylsp[-5])); (yyval.case_) = branch((yyvsp[-5].symbol), (yyvsp[-3].symbol), (yyvsp[-1].expression)); }
-#line 1806 "cool.tab.c"
+#line 1832 "cool.tab.c"
     break;
 
 
-#line 1810 "cool.tab.c"
+#line 1836 "cool.tab.c"
 
       default: break;
     }
@@ -1854,7 +1880,7 @@ yyerrlab:
   if (!yyerrstatus)
     {
       ++yynerrs;
-      yyerror (YY_("syntax error"));
+      yyerror (&yylloc, ps, YY_("syntax error"));
     }
 
   yyerror_range[1] = yylloc;
@@ -1872,7 +1898,7 @@ yyerrlab:
       else
         {
           yydestruct ("Error: discarding",
-                      yytoken, &yylval, &yylloc);
+                      yytoken, &yylval, &yylloc, ps);
           yychar = YYEMPTY;
         }
     }
@@ -1928,7 +1954,7 @@ yyerrlab1:
 
       yyerror_range[1] = *yylsp;
       yydestruct ("Error: popping",
-                  YY_ACCESSING_SYMBOL (yystate), yyvsp, yylsp);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, yylsp, ps);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -1969,7 +1995,7 @@ yyabortlab:
 | yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
 `-----------------------------------------------------------*/
 yyexhaustedlab:
-  yyerror (YY_("memory exhausted"));
+  yyerror (&yylloc, ps, YY_("memory exhausted"));
   yyresult = 2;
   goto yyreturnlab;
 
@@ -1984,7 +2010,7 @@ yyreturnlab:
          user semantic actions for why this is necessary.  */
       yytoken = YYTRANSLATE (yychar);
       yydestruct ("Cleanup: discarding lookahead",
-                  yytoken, &yylval, &yylloc);
+                  yytoken, &yylval, &yylloc, ps);
     }
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYABORT or YYACCEPT.  */
@@ -1993,7 +2019,7 @@ yyreturnlab:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, yylsp);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, yylsp, ps);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
@@ -2004,24 +2030,9 @@ yyreturnlab:
   return yyresult;
 }
 
-#line 249 "cool.y"
+#line 272 "cool.y"
 
 
 int curr_lineno = 1;
-Symbol self_sym = idtable.add_string("self");
-
-void yyerror(char *s)
-{
-  extern char *curr_filename;
-  
-  std::cerr << "\"" << curr_filename << "\", line " << curr_lineno << ": " \
-       << s << " at or near ";
-  print_cool_token(yychar);
-  std::cerr << std::endl;
-  omerrs++;
-  
-  if(omerrs > 50) {
-    fprintf(stdout, "More than 50 errors\n");
-    exit(1);
-  }
-}
+YYSTYPE cool_yylval;            // set by cool_yylex and token_stream_lex
+Symbol self_sym = predef_symbol(PREDEF_self);
@@ -10,12 +10,79 @@
 #include "tree.h"
 #include "cool-tree.handcode.h"
 #include "cool-tree.h"
+#include "treewalk.h"
+
+
+//
+// An expression is dumped by running the dump_step of each expression
+// below it off a WalkStack (see walkstack.h), rather than by calling
+// dump on each, as they can be nested deeper than the C++ stack goes.
+//
+static void dump_expression(ostream& stream, int n, Expression e)
+{
+   ExpressionWalk walk;
+   walk.push(e, 0, n);
+   WalkStep<Expression> s;
+   while (walk.pop(s))
+      visit_expression(s.node, [&](auto *x) {
+         x->dump_step(stream, s.n, s.stage, walk);
+      });
+}
+
+
+//
+// A list held by an expression is dumped as list_node::dump would dump
+// it, with its elements left to the walk: dump_list_head dumps what
+// comes before the elements and returns their indentation, and
+// dump_list_tail what comes after them.
+//
+template <class Elem> static bool is_append(list_node<Elem> *l)
+{
+   return l->get_shape() == list_node<Elem>::Append;
+}
+
+
+template <class Elem> static int dump_list_head(ostream& stream, int n, list_node<Elem> *l)
+{
+   if (l->get_shape() == list_node<Elem>::Nil)
+      stream << pad(n) << "(nil)\n";
+   else if (is_append(l)) {
+      stream << pad(n) << "list\n";
+      return n+2;
+   }
+   return n;
+}
+
+
+template <class Elem> static void dump_list_tail(ostream& stream, int n, list_node<Elem> *l)
+{
+   if (is_append(l))
+      stream << pad(n) << "(end_of_list)\n";
+}
+
+
+//
+// A copy of a node shares the node's children (see tree.h): shared(t)
+// counts one more holder of child t, and copied(copy, t) gives the copy
+// the line number of node t.  A copy of an expression also has its type.
+//
+template <class T> static T shared(T t)
+{
+   t->share();
+   return t;
+}
+
+template <class T> static T copied(T copy, tree_node *t)
+{
+   copy->set(t);
+   return copy;
+}
 
 
 // constructors' functions
 Program program_class::copy_Program()
 {
-   return new program_class(classes->copy_list());
+   return copied(new program_class(shared(classes)), this);
 }
 
 
@@ -28,7 +95,7 @@ void program_class::dump(ostream& stream, int n)
 
 Class_ class__class::copy_Class_()
 {
-   return new class__class(copy_Symbol(name), copy_Symbol(parent), features->copy_list(), copy_Symbol(filename));
+   return copied(new class__class(copy_Symbol(name), copy_Symbol(parent), shared(features), copy_Symbol(filename)), this);
 }
 
 
@@ -44,7 +111,7 @@ void class__class::dump(ostream& stream, int n)
 
 Feature method_class::copy_Feature()
 {
-   return new method_class(copy_Symbol(name), formals->copy_list(), copy_Symbol(return_type), expr->copy_Expression());
+   return copied(new method_class(copy_Symbol(name), shared(formals), copy_Symbol(return_type), shared(expr)), this);
 }
 
 
@@ -60,7 +127,7 @@ void method_class::dump(ostream& stream, int n)
 
 Feature attr_class::copy_Feature()
 {
-   return new attr_class(copy_Symbol(name), copy_Symbol(type_decl), init->copy_Expression());
+   return copied(new attr_class(copy_Symbol(name), copy_Symbol(type_decl), shared(init)), this);
 }
 
 
@@ -75,7 +142,7 @@ void attr_class::dump(ostream& stream, int n)
 
 Formal formal_class::copy_Formal()
 {
-   return new formal_class(copy_Symbol(name), copy_Symbol(type_decl));
+   return copied(new formal_class(copy_Symbol(name), copy_Symbol(type_decl)), this);
 }
 
 
@@ -89,267 +156,435 @@ void formal_class::dump(ostream& stream, int n)
 
 Case branch_class::copy_Case()
 {
-   return new branch_class(copy_Symbol(name), copy_Symbol(type_decl), expr->copy_Expression());
+   return copied(new branch_class(copy_Symbol(name), copy_Symbol(type_decl), shared(expr)), this);
 }
 
 
-void branch_class::dump(ostream& stream, int n)
+Expression branch_class::dump_head(ostream& stream, int n)
 {
    stream << pad(n) << "branch\n";
    dump_Symbol(stream, n+2, name);
    dump_Symbol(stream, n+2, type_decl);
-   expr->dump(stream, n+2);
+   return expr;
+}
+
+
+void branch_class::dump(ostream& stream, int n)
+{
+   dump_head(stream, n)->dump(stream, n+2);
 }
 
 
 Expression assign_class::copy_Expression()
 {
-   return new assign_class(copy_Symbol(name), expr->copy_Expression());
+   return copied(new assign_class(copy_Symbol(name), shared(expr)), this)->set_type(type);
 }
 
 
 void assign_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void assign_class::dump_step(ostream& stream, int n, int,
+                             ExpressionWalk& walk)
 {
    stream << pad(n) << "assign\n";
    dump_Symbol(stream, n+2, name);
-   expr->dump(stream, n+2);
+   walk.push(expr, 0, n+2);
 }
 
 
 Expression static_dispatch_class::copy_Expression()
 {
-   return new static_dispatch_class(expr->copy_Expression(), copy_Symbol(type_name), copy_Symbol(name), actual->copy_list());
+   return copied(new static_dispatch_class(shared(expr), copy_Symbol(type_name), copy_Symbol(name), shared(actual)), this)->set_type(type);
 }
 
 
 void static_dispatch_class::dump(ostream& stream, int n)
 {
-   stream << pad(n) << "static_dispatch\n";
-   expr->dump(stream, n+2);
-   dump_Symbol(stream, n+2, type_name);
-   dump_Symbol(stream, n+2, name);
-   actual->dump(stream, n+2);
+   dump_expression(stream, n, this);
+}
+
+
+void static_dispatch_class::dump_step(ostream& stream, int n, int stage,
+                                      ExpressionWalk& walk)
+{
+   switch (stage) {
+   case 0:
+      stream << pad(n) << "static_dispatch\n";
+      walk.push(this, 1, n);
+      walk.push(expr, 0, n+2);
+      break;
+   case 1:
+      dump_Symbol(stream, n+2, type_name);
+      dump_Symbol(stream, n+2, name);
+      walk.push(this, 2, n);
+      walk.push_list(actual, dump_list_head(stream, n+2, actual));
+      break;
+   default:
+      dump_list_tail(stream, n+2, actual);
+   }
 }
 
 
 Expression dispatch_class::copy_Expression()
 {
-   return new dispatch_class(expr->copy_Expression(), copy_Symbol(name), actual->copy_list());
+   return copied(new dispatch_class(shared(expr), copy_Symbol(name), shared(actual)), this)->set_type(type);
 }
 
 
 void dispatch_class::dump(ostream& stream, int n)
 {
-   stream << pad(n) << "dispatch\n";
-   expr->dump(stream, n+2);
-   dump_Symbol(stream, n+2, name);
-   actual->dump(stream, n+2);
+   dump_expression(stream, n, this);
+}
+
+
+void dispatch_class::dump_step(ostream& stream, int n, int stage,
+                               ExpressionWalk& walk)
+{
+   switch (stage) {
+   case 0:
+      stream << pad(n) << "dispatch\n";
+      walk.push(this, 1, n);
+      walk.push(expr, 0, n+2);
+      break;
+   case 1:
+      dump_Symbol(stream, n+2, name);
+      walk.push(this, 2, n);
+      walk.push_list(actual, dump_list_head(stream, n+2, actual));
+      break;
+   default:
+      dump_list_tail(stream, n+2, actual);
+   }
 }
 
 
 Expression cond_class::copy_Expression()
 {
-   return new cond_class(pred->copy_Expression(), then_exp->copy_Expression(), else_exp->copy_Expression());
+   return copied(new cond_class(shared(pred), shared(then_exp), shared(else_exp)), this)->set_type(type);
 }
 
 
 void cond_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void cond_class::dump_step(ostream& stream, int n, int,
+                           ExpressionWalk& walk)
 {
    stream << pad(n) << "cond\n";
-   pred->dump(stream, n+2);
-   then_exp->dump(stream, n+2);
-   else_exp->dump(stream, n+2);
+   walk.push(else_exp, 0, n+2);
+   walk.push(then_exp, 0, n+2);
+   walk.push(pred, 0, n+2);
 }
 
 
 Expression loop_class::copy_Expression()
 {
-   return new loop_class(pred->copy_Expression(), body->copy_Expression());
+   return copied(new loop_class(shared(pred), shared(body)), this)->set_type(type);
 }
 
 
 void loop_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void loop_class::dump_step(ostream& stream, int n, int,
+                           ExpressionWalk& walk)
 {
    stream << pad(n) << "loop\n";
-   pred->dump(stream, n+2);
-   body->dump(stream, n+2);
+   walk.push(body, 0, n+2);
+   walk.push(pred, 0, n+2);
 }
 
 
 Expression typcase_class::copy_Expression()
 {
-   return new typcase_class(expr->copy_Expression(), cases->copy_list());
+   return copied(new typcase_class(shared(expr), shared(cases)), this)->set_type(type);
 }
 
 
 void typcase_class::dump(ostream& stream, int n)
 {
-   stream << pad(n) << "typcase\n";
-   expr->dump(stream, n+2);
-   cases->dump(stream, n+2);
+   dump_expression(stream, n, this);
+}
+
+
+void typcase_class::dump_step(ostream& stream, int n, int stage,
+                              ExpressionWalk& walk)
+{
+   // the branches, as cases->dump(stream, n+2) would dump them
+   int m = is_append(cases) ? n+4 : n+2;
+   int i = stage - 2;
+   if (stage == 0) {
+      stream << pad(n) << "typcase\n";
+      walk.push(this, 1, n);
+      walk.push(expr, 0, n+2);
+   } else if (stage == 1) {
+      dump_list_head(stream, n+2, cases);
+      walk.push(this, 2, n);
+   } else if (cases->more(i)) {
+      walk.push(this, stage + 1, n);
+      walk.push(cases->nth(i)->dump_head(stream, m), 0, m+2);
+   } else
+      dump_list_tail(stream, n+2, cases);
 }
 
 
 Expression block_class::copy_Expression()
 {
-   return new block_class(body->copy_list());
+   return copied(new block_class(shared(body)), this)->set_type(type);
 }
 
 
 void block_class::dump(ostream& stream, int n)
 {
-   stream << pad(n) << "block\n";
-   body->dump(stream, n+2);
+   dump_expression(stream, n, this);
+}
+
+
+void block_class::dump_step(ostream& stream, int n, int stage,
+                            ExpressionWalk& walk)
+{
+   if (stage == 0) {
+      stream << pad(n) << "block\n";
+      walk.push(this, 1, n);
+      walk.push_list(body, dump_list_head(stream, n+2, body));
+   } else
+      dump_list_tail(stream, n+2, body);
 }
 
 
 Expression let_class::copy_Expression()
 {
-   return new let_class(copy_Symbol(identifier), copy_Symbol(type_decl), init->copy_Expression(), body->copy_Expression());
+   return copied(new let_class(copy_Symbol(identifier), copy_Symbol(type_decl), shared(init), shared(body)), this)->set_type(type);
 }
 
 
 void let_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void let_class::dump_step(ostream& stream, int n, int,
+                          ExpressionWalk& walk)
 {
    stream << pad(n) << "let\n";
    dump_Symbol(stream, n+2, identifier);
    dump_Symbol(stream, n+2, type_decl);
-   init->dump(stream, n+2);
-   body->dump(stream, n+2);
+   walk.push(body, 0, n+2);
+   walk.push(init, 0, n+2);
 }
 
 
 Expression plus_class::copy_Expression()
 {
-   return new plus_class(e1->copy_Expression(), e2->copy_Expression());
+   return copied(new plus_class(shared(e1), shared(e2)), this)->set_type(type);
 }
 
 
 void plus_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void plus_class::dump_step(ostream& stream, int n, int,
+                           ExpressionWalk& walk)
 {
    stream << pad(n) << "plus\n";
-   e1->dump(stream, n+2);
-   e2->dump(stream, n+2);
+   walk.push(e2, 0, n+2);
+   walk.push(e1, 0, n+2);
 }
 
 
 Expression sub_class::copy_Expression()
 {
-   return new sub_class(e1->copy_Expression(), e2->copy_Expression());
+   return copied(new sub_class(shared(e1), shared(e2)), this)->set_type(type);
 }
 
 
 void sub_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void sub_class::dump_step(ostream& stream, int n, int,
+                          ExpressionWalk& walk)
 {
    stream << pad(n) << "sub\n";
-   e1->dump(stream, n+2);
-   e2->dump(stream, n+2);
+   walk.push(e2, 0, n+2);
+   walk.push(e1, 0, n+2);
 }
 
 
 Expression mul_class::copy_Expression()
 {
-   return new mul_class(e1->copy_Expression(), e2->copy_Expression());
+   return copied(new mul_class(shared(e1), shared(e2)), this)->set_type(type);
 }
 
 
 void mul_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void mul_class::dump_step(ostream& stream, int n, int,
+                          ExpressionWalk& walk)
 {
    stream << pad(n) << "mul\n";
-   e1->dump(stream, n+2);
-   e2->dump(stream, n+2);
+   walk.push(e2, 0, n+2);
+   walk.push(e1, 0, n+2);
 }
 
 
 Expression divide_class::copy_Expression()
 {
-   return new divide_class(e1->copy_Expression(), e2->copy_Expression());
+   return copied(new divide_class(shared(e1), shared(e2)), this)->set_type(type);
 }
 
 
 void divide_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void divide_class::dump_step(ostream& stream, int n, int,
+                             ExpressionWalk& walk)
 {
    stream << pad(n) << "divide\n";
-   e1->dump(stream, n+2);
-   e2->dump(stream, n+2);
+   walk.push(e2, 0, n+2);
+   walk.push(e1, 0, n+2);
 }
 
 
 Expression neg_class::copy_Expression()
 {
-   return new neg_class(e1->copy_Expression());
+   return copied(new neg_class(shared(e1)), this)->set_type(type);
 }
 
 
 void neg_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void neg_class::dump_step(ostream& stream, int n, int,
+                          ExpressionWalk& walk)
 {
    stream << pad(n) << "neg\n";
-   e1->dump(stream, n+2);
+   walk.push(e1, 0, n+2);
 }
 
 
 Expression lt_class::copy_Expression()
 {
-   return new lt_class(e1->copy_Expression(), e2->copy_Expression());
+   return copied(new lt_class(shared(e1), shared(e2)), this)->set_type(type);
 }
 
 
 void lt_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void lt_class::dump_step(ostream& stream, int n, int,
+                         ExpressionWalk& walk)
 {
    stream << pad(n) << "lt\n";
-   e1->dump(stream, n+2);
-   e2->dump(stream, n+2);
+   walk.push(e2, 0, n+2);
+   walk.push(e1, 0, n+2);
 }
 
 
 Expression eq_class::copy_Expression()
 {
-   return new eq_class(e1->copy_Expression(), e2->copy_Expression());
+   return copied(new eq_class(shared(e1), shared(e2)), this)->set_type(type);
 }
 
 
 void eq_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void eq_class::dump_step(ostream& stream, int n, int,
+                         ExpressionWalk& walk)
 {
    stream << pad(n) << "eq\n";
-   e1->dump(stream, n+2);
-   e2->dump(stream, n+2);
+   walk.push(e2, 0, n+2);
+   walk.push(e1, 0, n+2);
 }
 
 
 Expression leq_class::copy_Expression()
 {
-   return new leq_class(e1->copy_Expression(), e2->copy_Expression());
+   return copied(new leq_class(shared(e1), shared(e2)), this)->set_type(type);
 }
 
 
 void leq_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void leq_class::dump_step(ostream& stream, int n, int,
+                          ExpressionWalk& walk)
 {
    stream << pad(n) << "leq\n";
-   e1->dump(stream, n+2);
-   e2->dump(stream, n+2);
+   walk.push(e2, 0, n+2);
+   walk.push(e1, 0, n+2);
 }
 
 
 Expression comp_class::copy_Expression()
 {
-   return new comp_class(e1->copy_Expression());
+   return copied(new comp_class(shared(e1)), this)->set_type(type);
 }
 
 
 void comp_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void comp_class::dump_step(ostream& stream, int n, int,
+                           ExpressionWalk& walk)
 {
    stream << pad(n) << "comp\n";
-   e1->dump(stream, n+2);
+   walk.push(e1, 0, n+2);
 }
 
 
 Expression int_const_class::copy_Expression()
 {
-   return new int_const_class(copy_Symbol(token));
+   return copied(new int_const_class(copy_Symbol(token)), this)->set_type(type);
 }
 
 
 void int_const_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void int_const_class::dump_step(ostream& stream, int n, int,
+                                ExpressionWalk&)
 {
    stream << pad(n) << "int_const\n";
    dump_Symbol(stream, n+2, token);
@@ -358,11 +593,18 @@ void int_const_class::dump(ostream& stream, int n)
 
 Expression bool_const_class::copy_Expression()
 {
-   return new bool_const_class(copy_Boolean(val));
+   return copied(new bool_const_class(copy_Boolean(val)), this)->set_type(type);
 }
 
 
 void bool_const_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void bool_const_class::dump_step(ostream& stream, int n, int,
+                                 ExpressionWalk&)
 {
    stream << pad(n) << "bool_const\n";
    dump_Boolean(stream, n+2, val);
@@ -371,11 +613,18 @@ void bool_const_class::dump(ostream& stream, int n)
 
 Expression string_const_class::copy_Expression()
 {
-   return new string_const_class(copy_Symbol(token));
+   return copied(new string_const_class(copy_Symbol(token)), this)->set_type(type);
 }
 
 
 void string_const_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void string_const_class::dump_step(ostream& stream, int n, int,
+                                   ExpressionWalk&)
 {
    stream << pad(n) << "string_const\n";
    dump_Symbol(stream, n+2, token);
@@ -384,11 +633,18 @@ void string_const_class::dump(ostream& stream, int n)
 
 Expression new__class::copy_Expression()
 {
-   return new new__class(copy_Symbol(type_name));
+   return copied(new new__class(copy_Symbol(type_name)), this)->set_type(type);
 }
 
 
 void new__class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void new__class::dump_step(ostream& stream, int n, int,
+                           ExpressionWalk&)
 {
    stream << pad(n) << "new_\n";
    dump_Symbol(stream, n+2, type_name);
@@ -397,24 +653,38 @@ void new__class::dump(ostream& stream, int n)
 
 Expression isvoid_class::copy_Expression()
 {
-   return new isvoid_class(e1->copy_Expression());
+   return copied(new isvoid_class(shared(e1)), this)->set_type(type);
 }
 
 
 void isvoid_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void isvoid_class::dump_step(ostream& stream, int n, int,
+                             ExpressionWalk& walk)
 {
    stream << pad(n) << "isvoid\n";
-   e1->dump(stream, n+2);
+   walk.push(e1, 0, n+2);
 }
 
 
 Expression no_expr_class::copy_Expression()
 {
-   return new no_expr_class();
+   return copied(new no_expr_class(), this)->set_type(type);
 }
 
 
 void no_expr_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void no_expr_class::dump_step(ostream& stream, int n, int,
+                              ExpressionWalk&)
 {
    stream << pad(n) << "no_expr\n";
 }
@@ -422,17 +692,159 @@ void no_expr_class::dump(ostream& stream, int n)
 
 Expression object_class::copy_Expression()
 {
-   return new object_class(copy_Symbol(name));
+   return copied(new object_class(copy_Symbol(name)), this)->set_type(type);
 }
 
 
 void object_class::dump(ostream& stream, int n)
+{
+   dump_expression(stream, n, this);
+}
+
+
+void object_class::dump_step(ostream& stream, int n, int,
+                             ExpressionWalk&)
 {
    stream << pad(n) << "object\n";
    dump_Symbol(stream, n+2, name);
 }
 
 
+// the children of each kind of node, for walk_tree (see treewalk.h)
+void TreeWalk::push_children(tree_node *t, TreeWalkStack& walk)
+{
+   switch (t->get_kind()) {
+   case NODE_program:
+      walk.push_list(static_cast<program_class *>(t)->classes);
+      break;
+   case NODE_class_:
+      walk.push_list(static_cast<class__class *>(t)->features);
+      break;
+   case NODE_method: {
+      method_class *m = static_cast<method_class *>(t);
+      walk.push(m->expr);
+      walk.push_list(m->formals);
+      break;
+   }
+   case NODE_attr:
+      walk.push(static_cast<attr_class *>(t)->init);
+      break;
+   case NODE_branch:
+      walk.push(static_cast<branch_class *>(t)->expr);
+      break;
+   case NODE_assign:
+      walk.push(static_cast<assign_class *>(t)->expr);
+      break;
+   case NODE_static_dispatch: {
+      static_dispatch_class *e = static_cast<static_dispatch_class *>(t);
+      walk.push_list(e->actual);
+      walk.push(e->expr);
+      break;
+   }
+   case NODE_dispatch: {
+      dispatch_class *e = static_cast<dispatch_class *>(t);
+      walk.push_list(e->actual);
+      walk.push(e->expr);
+      break;
+   }
+   case NODE_cond: {
+      cond_class *e = static_cast<cond_class *>(t);
+      walk.push(e->else_exp);
+      walk.push(e->then_exp);
+      walk.push(e->pred);
+      break;
+   }
+   case NODE_loop: {
+      loop_class *e = static_cast<loop_class *>(t);
+      walk.push(e->body);
+      walk.push(e->pred);
+      break;
+   }
+   case NODE_typcase: {
+      typcase_class *e = static_cast<typcase_class *>(t);
+      walk.push_list(e->cases);
+      walk.push(e->expr);
+      break;
+   }
+   case NODE_block:
+      walk.push_list(static_cast<block_class *>(t)->body);
+      break;
+   case NODE_let: {
+      let_class *e = static_cast<let_class *>(t);
+      walk.push(e->body);
+      walk.push(e->init);
+      break;
+   }
+   case NODE_plus:
+      walk.push(static_cast<plus_class *>(t)->e2);
+      walk.push(static_cast<plus_class *>(t)->e1);
+      break;
+   case NODE_sub:
+      walk.push(static_cast<sub_class *>(t)->e2);
+      walk.push(static_cast<sub_class *>(t)->e1);
+      break;
+   case NODE_mul:
+      walk.push(static_cast<mul_class *>(t)->e2);
+      walk.push(static_cast<mul_class *>(t)->e1);
+      break;
+   case NODE_divide:
+      walk.push(static_cast<divide_class *>(t)->e2);
+      walk.push(static_cast<divide_class *>(t)->e1);
+      break;
+   case NODE_lt:
+      walk.push(static_cast<lt_class *>(t)->e2);
+      walk.push(static_cast<lt_class *>(t)->e1);
+      break;
+   case NODE_eq:
+      walk.push(static_cast<eq_class *>(t)->e2);
+      walk.push(static_cast<eq_class *>(t)->e1);
+      break;
+   case NODE_leq:
+      walk.push(static_cast<leq_class *>(t)->e2);
+      walk.push(static_cast<leq_class *>(t)->e1);
+      break;
+   case NODE_neg:
+      walk.push(static_cast<neg_class *>(t)->e1);
+      break;
+   case NODE_comp:
+      walk.push(static_cast<comp_class *>(t)->e1);
+      break;
+   case NODE_isvoid:
+      walk.push(static_cast<isvoid_class *>(t)->e1);
+      break;
+   default:
+      // formals, constants, new_, no_expr and object have no children
+      break;
+   }
+}
+
+//
+// With -L (share_leaves), the leaves that come out the same wherever
+// they are -- constants, no_expr, and self, which semant gives the same
+// type at every use -- are made once a line, and every use of one on
+// that line shares it, so each still has its own line number.  The
+// arena of the nodes keeps them by kind and value (see tree.h).  Each
+// use after the first is counted with share(), so a pass that changes
+// the tree owns the leaf first, as semant does before it sets a type.
+//
+extern int share_leaves;
+
+template <class Make>
+static Expression leaf(NodeKind kind, int value, Make make)
+{
+  if (!share_leaves)
+    return make();
+  NodeArena *arena = NodeArena::current();
+  Expression e = static_cast<Expression>(arena->find_leaf(kind, value));
+  if (e == NULL) {
+    e = make();
+    arena->keep_leaf(kind, value, e);
+  } else
+    e->share();
+  return e;
+}
+
+
 // interfaces used by Bison
 Classes nil_Classes()
 {
@@ -446,7 +858,7 @@ Classes single_Classes(Class_ e)
 
 Classes append_Classes(Classes p1, Classes p2)
 {
-   return new append_node<Class_>(p1, p2);
+   return list_node<Class_>::append(p1, p2);
 }
 
 Features nil_Features()
@@ -461,7 +873,7 @@ Features single_Features(Feature e)
 
 Features append_Features(Features p1, Features p2)
 {
-   return new append_node<Feature>(p1, p2);
+   return list_node<Feature>::append(p1, p2);
 }
 
 Formals nil_Formals()
@@ -476,7 +888,7 @@ Formals single_Formals(Formal e)
 
 Formals append_Formals(Formals p1, Formals p2)
 {
-   return new append_node<Formal>(p1, p2);
+   return list_node<Formal>::append(p1, p2);
 }
 
 Expressions nil_Expressions()
@@ -491,7 +903,7 @@ Expressions single_Expressions(Expression e)
 
 Expressions append_Expressions(Expressions p1, Expressions p2)
 {
-   return new append_node<Expression>(p1, p2);
+   return list_node<Expression>::append(p1, p2);
 }
 
 Cases nil_Cases()
@@ -506,7 +918,7 @@ Cases single_Cases(Case e)
 
 Cases append_Cases(Cases p1, Cases p2)
 {
-   return new append_node<Case>(p1, p2);
+   return list_node<Case>::append(p1, p2);
 }
 
 Program program(Classes classes)
@@ -626,17 +1038,20 @@ Expression comp(Expression e1)
 
 Expression int_const(Symbol token)
 {
-  return new int_const_class(token);
+  return leaf(NODE_int_const, token->get_index(),
+              [&] { return new int_const_class(token); });
 }
 
 Expression bool_const(Boolean val)
 {
-  return new bool_const_class(val);
+  return leaf(NODE_bool_const, val ? 1 : 0,
+              [&] { return new bool_const_class(val); });
 }
 
 Expression string_const(Symbol token)
 {
-  return new string_const_class(token);
+  return leaf(NODE_string_const, token->get_index(),
+              [&] { return new string_const_class(token); });
 }
 
 Expression new_(Symbol type_name)
@@ -651,11 +1066,14 @@ Expression isvoid(Expression e1)
 
 Expression no_expr()
 {
-  return new no_expr_class();
+  return leaf(NODE_no_expr, 0, [] { return new no_expr_class(); });
 }
 
 Expression object(Symbol name)
 {
-  return new object_class(name);
+  if (name != predef_symbol(PREDEF_self))
+    return new object_class(name);
+  return leaf(NODE_object, name->get_index(),
+              [&] { return new object_class(name); });
 }
 
@@ -8,6 +8,7 @@
 #include "tree.h"
 #include "cool.h"
 #include "stringtab.h"
+#include "walkstack.h"
 #define yylineno curr_lineno;
 extern int yylineno;
 
@@ -44,12 +45,17 @@ typedef Expressions_class *Expressions;
 typedef list_node<Case> Cases_class;
 typedef Cases_class *Cases;
 
+// see walkstack.h
+typedef WalkStack<Expression> ExpressionWalk;
+
 #define Program_EXTRAS                          \
+virtual Classes get_classes() = 0;              \
 virtual void dump_with_types(ostream&, int) = 0; 
 
 
 
 #define program_EXTRAS                          \
+Classes get_classes() { return classes; }       \
 void dump_with_types(ostream&, int);            
 
 #define Class__EXTRAS                   \
@@ -69,6 +75,9 @@ virtual void dump_with_types(ostream&,int) = 0;
 #define Feature_SHARED_EXTRAS                                       \
 void dump_with_types(ostream&,int);    
 
+#define method_EXTRAS                                   \
+void set_body(Expression e) { expr = e; }
+
 
 
 
@@ -82,25 +91,33 @@ void dump_with_types(ostream&,int);
 
 
 #define Case_EXTRAS                             \
-virtual void dump_with_types(ostream& ,int) = 0;
+virtual void dump_with_types(ostream& ,int) = 0; \
+virtual Expression dump_head(ostream&, int) = 0; \
+virtual Expression dump_with_types_head(ostream&, int) = 0;
 
 
 #define branch_EXTRAS                                   \
-void dump_with_types(ostream& ,int);
+void dump_with_types(ostream& ,int);                    \
+Expression dump_head(ostream&, int);                    \
+Expression dump_with_types_head(ostream&, int);
 
 
 #define Expression_EXTRAS                    \
 Symbol type;                                 \
 Symbol get_type() { return type; }           \
-Expression set_type(Symbol s) { type = s; return this; } \
-virtual void dump_with_types(ostream&,int) = 0;  \
+Expression set_type(Symbol s)               \
+  { if (type == s) return this;             \
+    Expression e = is_shared() ? copy_Expression() : this; \
+    e->type = s; return e; }                \
+void dump_with_types(ostream&,int);          \
 void dump_type(ostream&, int);               \
 Expression_class() { type = (Symbol) NULL; }
 
 
 
 #define Expression_SHARED_EXTRAS           \
-void dump_with_types(ostream&,int); 
+void dump_step(ostream&, int, int, ExpressionWalk&); \
+void dump_with_types_step(ostream&, int, int, ExpressionWalk&);
 
 
 #endif
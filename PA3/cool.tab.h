@@ -119,7 +119,7 @@ extern int cool_yydebug;
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
 union YYSTYPE
 {
-#line 39 "cool.y"
+#line 62 "cool.y"
 
   Boolean boolean;
   Symbol symbol;
@@ -159,10 +159,9 @@ struct YYLTYPE
 #endif
 
 
-extern YYSTYPE cool_yylval;
-extern YYLTYPE cool_yylloc;
 
-int cool_yyparse (void);
+
+int cool_yyparse (ParseState *ps);
 
 
 #endif /* !YY_COOL_YY_COOL_TAB_H_INCLUDED  */
@@ -3,32 +3,51 @@
 #include "cool-tree.h"
 #include "stringtab.h"
 #include "utilities.h"
+#include "parsestate.h"
 
-extern char *curr_filename;
-extern int curr_lineno;
+// A location is just the line.  It is kept in a struct, rather than an
+// int, only so that the parser's stacks can grow on the heap as deep as
+// a program nests (to a million or so levels): bison moves them in C++
+// only when told both stacks' types can be copied as bytes.
+struct YYLTYPE {
+  int first_line, first_column, last_line, last_column;
+
+  operator int() const { return first_line; }
+  YYLTYPE& operator=(int line)
+  {
+    first_line = last_line = line;
+    first_column = last_column = 0;
+    return *this;
+  }
+};
+#define YYLTYPE_IS_DECLARED 1
+#define YYLTYPE_IS_TRIVIAL 1
+#define YYSTYPE_IS_TRIVIAL 1
+#define YYMAXDEPTH (1 << 24)
 
-#define YYLTYPE int
 #define YYLLOC_DEFAULT(Current, Rhs, N)         \
     Current = Rhs[1]; \
     node_lineno = Current;
 
-extern int node_lineno;
+// Each thread builds its own nodes; see parser-phase.cc.
+extern thread_local int node_lineno;
 
 #define SET_NODELOC(Current)  \
     node_lineno = Current;
 
-void yyerror(char *s);
-extern int cool_yylex();
 extern Symbol self_sym;
 
-static int yylex_wrapper() {
-  extern YYLTYPE cool_yylloc;
-  int token = cool_yylex();
-  cool_yylloc = curr_lineno;
+static int yylex_wrapper(YYSTYPE *yylval, YYLTYPE *yylloc, ParseState *ps) {
+  int token = parse_lex(ps, yylval);
+  *yylloc = ps->lineno;
   return token;
 }
 #define yylex yylex_wrapper
 
+static void yyerror(YYLTYPE *yylloc, ParseState *ps, const char *s) {
+  parse_error(ps, s);
+}
+
 /************************************************************************/
 
 Program ast_root;
@@ -36,6 +55,10 @@ Classes parse_results;
 int omerrs = 0;
 %}
 
+%define api.pure full
+%parse-param {ParseState *ps}
+%lex-param {ParseState *ps}
+
 %union {
   Boolean boolean;
   Symbol symbol;
@@ -89,7 +112,7 @@ int omerrs = 0;
 %%
 
 program : cool_list
-          { @$ = @1; ast_root = program($1); }
+          { @$ = @1; ps->ast_root = program($1); }
           ;
 
 cool_list : class
@@ -99,11 +122,11 @@ cool_list : class
            ;
 
 class : CLASS TYPEID '{' class_element '}' ';'
-        { @$ = @1; Symbol obj_sym = idtable.add_string("Object"); $$ = class_($2, obj_sym, $4, stringtable.add_string(curr_filename)); }
+        { @$ = @1; Symbol obj_sym = predef_symbol(PREDEF_Object); $$ = class_($2, obj_sym, $4, stringtable.add_string(ps->filename)); }
       | CLASS TYPEID INHERITS TYPEID '{' class_element '}' ';'
-        { @$ = @1; $$ = class_($2, $4, $6, stringtable.add_string(curr_filename)); }
+        { @$ = @1; $$ = class_($2, $4, $6, stringtable.add_string(ps->filename)); }
       | error ';'
-        { @$ = @1; Symbol err_sym = idtable.add_string("Error"); Symbol obj_sym = idtable.add_string("Object"); $$ = class_(err_sym, obj_sym, nil_Features(), stringtable.add_string(curr_filename)); }
+        { @$ = @1; Symbol err_sym = idtable.add_string("Error"); Symbol obj_sym = predef_symbol(PREDEF_Object); $$ = class_(err_sym, obj_sym, nil_Features(), stringtable.add_string(ps->filename)); }
       ;
 
 class_element : 
@@ -249,20 +272,5 @@ case_branch : OBJECTID ':' TYPEID DARROW expr ';'
 %%
 
 int curr_lineno = 1;
-Symbol self_sym = idtable.add_string("self");
-
-void yyerror(char *s)
-{
-  extern char *curr_filename;
-  
-  std::cerr << "\"" << curr_filename << "\", line " << curr_lineno << ": " \
-       << s << " at or near ";
-  print_cool_token(yychar);
-  std::cerr << std::endl;
-  omerrs++;
-  
-  if(omerrs > 50) {
-    fprintf(stdout, "More than 50 errors\n");
-    exit(1);
-  }
-}
+YYSTYPE cool_yylval;            // set by cool_yylex and token_stream_lex
+Symbol self_sym = predef_symbol(PREDEF_self);
@@ -7,6 +7,7 @@
 #include "cool.h"
 #include "tree.h"
 #include "cool-tree.h"
+#include "treewalk.h"
 #include "utilities.h"
 
 // defined in stringtab.cc
@@ -153,7 +154,7 @@ void class__class::dump_with_types(ostream& stream, int n)
    dump_Symbol(stream, n+2, name);
    dump_Symbol(stream, n+2, parent);
    stream << pad(n+2) << "\"";
-   print_escaped_string(stream, filename->get_string());
+   ((StringEntryP) filename)->print_escaped(stream);
    stream << "\"\n" << pad(n+2) << "(\n";
    for(int i = features->first(); features->more(i); i = features->next(i))
      features->nth(i)->dump_with_types(stream, n+2);
@@ -206,108 +207,176 @@ void formal_class::dump_with_types(ostream& stream, int n)
 
 //
 // branch_class::dump_with_types dumps the name, type declaration,
-// and body of any case branch.
+// and body of any case branch.  The head, everything before the body,
+// is dumped on its own by typcase_class (see below), which then dumps
+// the body off its walk.
 //
-void branch_class::dump_with_types(ostream& stream, int n)
+Expression branch_class::dump_with_types_head(ostream& stream, int n)
 {
    dump_line(stream,n,this);
    stream << pad(n) << "_branch\n";
    dump_Symbol(stream, n+2, name);
    dump_Symbol(stream, n+2, type_decl);
-   expr->dump_with_types(stream, n+2);
+   return expr;
 }
 
-//
-// assign_class::dump_with_types prints "assign" and then (indented)
-// the variable being assigned, the expression, and finally the type
-// of the result.  Note the call to dump_type (see above) at the
-// end of the method.
-//
-void assign_class::dump_with_types(ostream& stream, int n)
+void branch_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "_assign\n";
-   dump_Symbol(stream, n+2, name);
-   expr->dump_with_types(stream, n+2);
-   dump_type(stream,n);
+   dump_with_types_head(stream, n)->dump_with_types(stream, n+2);
 }
 
 //
-// static_dispatch_class::dump_with_types prints the expression,
-// static dispatch class, function name, and actual arguments
-// of any static dispatch.  
+// An expression is not dumped by calling dump_with_types on its
+// subexpressions, as the nodes above are: expressions can be nested far
+// deeper than the C++ stack goes.  Instead, dump_with_types on an
+// expression runs the dump_with_types_step of every expression below it
+// off a WalkStack (see walkstack.h).  Stage 0 of a step dumps the head
+// of the node and pushes its subexpressions, to be dumped at a greater
+// indentation, after pushing the node itself again at the stage that
+// dumps whatever follows them.
 //
-void static_dispatch_class::dump_with_types(ostream& stream, int n)
+void Expression_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "_static_dispatch\n";
-   expr->dump_with_types(stream, n+2);
-   dump_Symbol(stream, n+2, type_name);
-   dump_Symbol(stream, n+2, name);
-   stream << pad(n+2) << "(\n";
-   for(int i = actual->first(); actual->more(i); i = actual->next(i))
-     actual->nth(i)->dump_with_types(stream, n+2);
-   stream << pad(n+2) << ")\n";
-   dump_type(stream,n);
+   ExpressionWalk walk;
+   walk.push(this, 0, n);
+   WalkStep<Expression> s;
+   while (walk.pop(s))
+     visit_expression(s.node, [&](auto *x) {
+       x->dump_with_types_step(stream, s.n, s.stage, walk);
+     });
 }
 
 //
-//   dispatch_class::dump_with_types is similar to 
-//   static_dispatch_class::dump_with_types 
+// assign_class::dump_with_types_step prints "assign" and then (indented)
+// the variable being assigned, the expression, and finally the type
+// of the result.  Note the call to dump_type (see above) at the
+// last stage.
 //
-void dispatch_class::dump_with_types(ostream& stream, int n)
+void assign_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                        ExpressionWalk& walk)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "_dispatch\n";
-   expr->dump_with_types(stream, n+2);
-   dump_Symbol(stream, n+2, name);
-   stream << pad(n+2) << "(\n";
-   for(int i = actual->first(); actual->more(i); i = actual->next(i))
-     actual->nth(i)->dump_with_types(stream, n+2);
-   stream << pad(n+2) << ")\n";
-   dump_type(stream,n);
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_assign\n";
+     dump_Symbol(stream, n+2, name);
+     walk.push(this, 1, n);
+     walk.push(expr, 0, n+2);
+   } else
+     dump_type(stream,n);
 }
 
 //
-// cond_class::dump_with_types dumps each of the three expressions
+// static_dispatch_class::dump_with_types_step prints the expression,
+// static dispatch class, function name, and actual arguments
+// of any static dispatch.  
+//
+void static_dispatch_class::dump_with_types_step(ostream& stream, int n,
+                                                 int stage,
+                                                 ExpressionWalk& walk)
+{
+   switch (stage) {
+   case 0:
+     dump_line(stream,n,this);
+     stream << pad(n) << "_static_dispatch\n";
+     walk.push(this, 1, n);
+     walk.push(expr, 0, n+2);
+     break;
+   case 1:
+     dump_Symbol(stream, n+2, type_name);
+     dump_Symbol(stream, n+2, name);
+     stream << pad(n+2) << "(\n";
+     walk.push(this, 2, n);
+     walk.push_list(actual, n+2);
+     break;
+   default:
+     stream << pad(n+2) << ")\n";
+     dump_type(stream,n);
+   }
+}
+
+//
+//   dispatch_class::dump_with_types_step is similar to 
+//   static_dispatch_class::dump_with_types_step 
+//
+void dispatch_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                          ExpressionWalk& walk)
+{
+   switch (stage) {
+   case 0:
+     dump_line(stream,n,this);
+     stream << pad(n) << "_dispatch\n";
+     walk.push(this, 1, n);
+     walk.push(expr, 0, n+2);
+     break;
+   case 1:
+     dump_Symbol(stream, n+2, name);
+     stream << pad(n+2) << "(\n";
+     walk.push(this, 2, n);
+     walk.push_list(actual, n+2);
+     break;
+   default:
+     stream << pad(n+2) << ")\n";
+     dump_type(stream,n);
+   }
+}
+
+//
+// cond_class::dump_with_types_step dumps each of the three expressions
 // in the conditional and then the type of the entire expression.
+// They are pushed last first, to be dumped first first.
 //
-void cond_class::dump_with_types(ostream& stream, int n)
+void cond_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                      ExpressionWalk& walk)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "_cond\n";
-   pred->dump_with_types(stream, n+2);
-   then_exp->dump_with_types(stream, n+2);
-   else_exp->dump_with_types(stream, n+2);
-   dump_type(stream,n);
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_cond\n";
+     walk.push(this, 1, n);
+     walk.push(else_exp, 0, n+2);
+     walk.push(then_exp, 0, n+2);
+     walk.push(pred, 0, n+2);
+   } else
+     dump_type(stream,n);
 }
 
 //
-// loop_class::dump_with_types dumps the predicate and then the
+// loop_class::dump_with_types_step dumps the predicate and then the
 // body of the loop, and finally the type of the entire expression.
 //
-void loop_class::dump_with_types(ostream& stream, int n)
+void loop_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                      ExpressionWalk& walk)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "_loop\n";
-   pred->dump_with_types(stream, n+2);
-   body->dump_with_types(stream, n+2);
-   dump_type(stream,n);
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_loop\n";
+     walk.push(this, 1, n);
+     walk.push(body, 0, n+2);
+     walk.push(pred, 0, n+2);
+   } else
+     dump_type(stream,n);
 }
 
 //
-//  typcase_class::dump_with_types dumps each branch of the
-//  the Case_ one at a time.  The type of the entire expression
-//  is dumped at the end.
+//  typcase_class::dump_with_types_step dumps each branch of the
+//  the Case_ one at a time, a stage for each: the head of the branch
+//  and then its body.  The type of the entire expression is dumped at
+//  the end.
 //
-void typcase_class::dump_with_types(ostream& stream, int n)
+void typcase_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                         ExpressionWalk& walk)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "_typcase\n";
-   expr->dump_with_types(stream, n+2);
-   for(int i = cases->first(); cases->more(i); i = cases->next(i))
-     cases->nth(i)->dump_with_types(stream, n+2);
-   dump_type(stream,n);
+   int i = stage - 1;
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_typcase\n";
+     walk.push(this, 1, n);
+     walk.push(expr, 0, n+2);
+   } else if (cases->more(i)) {
+     Expression body = cases->nth(i)->dump_with_types_head(stream, n+2);
+     walk.push(this, stage + 1, n);
+     walk.push(body, 0, n+4);
+   } else
+     dump_type(stream,n);
 }
 
 //
@@ -315,107 +384,151 @@ void typcase_class::dump_with_types(ostream& stream, int n)
 //  and introduce nothing that isn't already in the code discussed
 //  above.
 //
-void block_class::dump_with_types(ostream& stream, int n)
-{
-   dump_line(stream,n,this);
-   stream << pad(n) << "_block\n";
-   for(int i = body->first(); body->more(i); i = body->next(i))
-     body->nth(i)->dump_with_types(stream, n+2);
-   dump_type(stream,n);
+void block_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                       ExpressionWalk& walk)
+{
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_block\n";
+     walk.push(this, 1, n);
+     walk.push_list(body, n+2);
+   } else
+     dump_type(stream,n);
+}
+
+void let_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                     ExpressionWalk& walk)
+{
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_let\n";
+     dump_Symbol(stream, n+2, identifier);
+     dump_Symbol(stream, n+2, type_decl);
+     walk.push(this, 1, n);
+     walk.push(body, 0, n+2);
+     walk.push(init, 0, n+2);
+   } else
+     dump_type(stream,n);
+}
+
+void plus_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                      ExpressionWalk& walk)
+{
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_plus\n";
+     walk.push(this, 1, n);
+     walk.push(e2, 0, n+2);
+     walk.push(e1, 0, n+2);
+   } else
+     dump_type(stream,n);
+}
+
+void sub_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                     ExpressionWalk& walk)
+{
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_sub\n";
+     walk.push(this, 1, n);
+     walk.push(e2, 0, n+2);
+     walk.push(e1, 0, n+2);
+   } else
+     dump_type(stream,n);
 }
 
-void let_class::dump_with_types(ostream& stream, int n)
+void mul_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                     ExpressionWalk& walk)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "_let\n";
-   dump_Symbol(stream, n+2, identifier);
-   dump_Symbol(stream, n+2, type_decl);
-   init->dump_with_types(stream, n+2);
-   body->dump_with_types(stream, n+2);
-   dump_type(stream,n);
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_mul\n";
+     walk.push(this, 1, n);
+     walk.push(e2, 0, n+2);
+     walk.push(e1, 0, n+2);
+   } else
+     dump_type(stream,n);
 }
 
-void plus_class::dump_with_types(ostream& stream, int n)
+void divide_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                        ExpressionWalk& walk)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "_plus\n";
-   e1->dump_with_types(stream, n+2);
-   e2->dump_with_types(stream, n+2);
-   dump_type(stream,n);
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_divide\n";
+     walk.push(this, 1, n);
+     walk.push(e2, 0, n+2);
+     walk.push(e1, 0, n+2);
+   } else
+     dump_type(stream,n);
 }
 
-void sub_class::dump_with_types(ostream& stream, int n)
+void neg_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                     ExpressionWalk& walk)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "_sub\n";
-   e1->dump_with_types(stream, n+2);
-   e2->dump_with_types(stream, n+2);
-   dump_type(stream,n);
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_neg\n";
+     walk.push(this, 1, n);
+     walk.push(e1, 0, n+2);
+   } else
+     dump_type(stream,n);
 }
 
-void mul_class::dump_with_types(ostream& stream, int n)
+void lt_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                    ExpressionWalk& walk)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "_mul\n";
-   e1->dump_with_types(stream, n+2);
-   e2->dump_with_types(stream, n+2);
-   dump_type(stream,n);
-}
-
-void divide_class::dump_with_types(ostream& stream, int n)
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_lt\n";
+     walk.push(this, 1, n);
+     walk.push(e2, 0, n+2);
+     walk.push(e1, 0, n+2);
+   } else
+     dump_type(stream,n);
+}
+
+
+void eq_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                    ExpressionWalk& walk)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "_divide\n";
-   e1->dump_with_types(stream, n+2);
-   e2->dump_with_types(stream, n+2);
-   dump_type(stream,n);
-}
-
-void neg_class::dump_with_types(ostream& stream, int n)
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_eq\n";
+     walk.push(this, 1, n);
+     walk.push(e2, 0, n+2);
+     walk.push(e1, 0, n+2);
+   } else
+     dump_type(stream,n);
+}
+
+void leq_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                     ExpressionWalk& walk)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "_neg\n";
-   e1->dump_with_types(stream, n+2);
-   dump_type(stream,n);
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_leq\n";
+     walk.push(this, 1, n);
+     walk.push(e2, 0, n+2);
+     walk.push(e1, 0, n+2);
+   } else
+     dump_type(stream,n);
 }
-
-void lt_class::dump_with_types(ostream& stream, int n)
+
+void comp_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                      ExpressionWalk& walk)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "_lt\n";
-   e1->dump_with_types(stream, n+2);
-   e2->dump_with_types(stream, n+2);
-   dump_type(stream,n);
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_comp\n";
+     walk.push(this, 1, n);
+     walk.push(e1, 0, n+2);
+   } else
+     dump_type(stream,n);
 }
 
-
-void eq_class::dump_with_types(ostream& stream, int n)
-{
-   dump_line(stream,n,this);
-   stream << pad(n) << "_eq\n";
-   e1->dump_with_types(stream, n+2);
-   e2->dump_with_types(stream, n+2);
-   dump_type(stream,n);
-}
-
-void leq_class::dump_with_types(ostream& stream, int n)
-{
-   dump_line(stream,n,this);
-   stream << pad(n) << "_leq\n";
-   e1->dump_with_types(stream, n+2);
-   e2->dump_with_types(stream, n+2);
-   dump_type(stream,n);
-}
-
-void comp_class::dump_with_types(ostream& stream, int n)
-{
-   dump_line(stream,n,this);
-   stream << pad(n) << "_comp\n";
-   e1->dump_with_types(stream, n+2);
-   dump_type(stream,n);
-}
-
-void int_const_class::dump_with_types(ostream& stream, int n)
+void int_const_class::dump_with_types_step(ostream& stream, int n, int,
+                                           ExpressionWalk&)
 {
    dump_line(stream,n,this);
    stream << pad(n) << "_int\n";
@@ -423,7 +536,8 @@ void int_const_class::dump_with_types(ostream& stream, int n)
    dump_type(stream,n);
 }
 
-void bool_const_class::dump_with_types(ostream& stream, int n)
+void bool_const_class::dump_with_types_step(ostream& stream, int n, int,
+                                            ExpressionWalk&)
 {
    dump_line(stream,n,this);
    stream << pad(n) << "_bool\n";
@@ -431,17 +545,19 @@ void bool_const_class::dump_with_types(ostream& stream, int n)
    dump_type(stream,n);
 }
 
-void string_const_class::dump_with_types(ostream& stream, int n)
+void string_const_class::dump_with_types_step(ostream& stream, int n, int,
+                                              ExpressionWalk&)
 {
    dump_line(stream,n,this);
    stream << pad(n) << "_string\n";
    stream << pad(n+2) << "\"";
-   print_escaped_string(stream,token->get_string());
+   ((StringEntryP) token)->print_escaped(stream);
    stream << "\"\n";
    dump_type(stream,n);
 }
 
-void new__class::dump_with_types(ostream& stream, int n)
+void new__class::dump_with_types_step(ostream& stream, int n, int,
+                                      ExpressionWalk&)
 {
    dump_line(stream,n,this);
    stream << pad(n) << "_new\n";
@@ -449,26 +565,31 @@ void new__class::dump_with_types(ostream& stream, int n)
    dump_type(stream,n);
 }
 
-void isvoid_class::dump_with_types(ostream& stream, int n)
+void isvoid_class::dump_with_types_step(ostream& stream, int n, int stage,
+                                        ExpressionWalk& walk)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "_isvoid\n";
-   e1->dump_with_types(stream, n+2);
-   dump_type(stream,n);
+   if (stage == 0) {
+     dump_line(stream,n,this);
+     stream << pad(n) << "_isvoid\n";
+     walk.push(this, 1, n);
+     walk.push(e1, 0, n+2);
+   } else
+     dump_type(stream,n);
 }
 
-void no_expr_class::dump_with_types(ostream& stream, int n)
+void no_expr_class::dump_with_types_step(ostream& stream, int n, int,
+                                         ExpressionWalk&)
 {
    dump_line(stream,n,this);
    stream << pad(n) << "_no_expr\n";
    dump_type(stream,n);
 }
 
-void object_class::dump_with_types(ostream& stream, int n)
+void object_class::dump_with_types_step(ostream& stream, int n, int,
+                                        ExpressionWalk&)
 {
    dump_line(stream,n,this);
    stream << pad(n) << "_object\n";
    dump_Symbol(stream, n+2, name);
    dump_type(stream,n);
 }
-
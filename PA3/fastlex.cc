@@ -0,0 +1 @@
+../PA2/fastlex.cc
\ No newline at end of file
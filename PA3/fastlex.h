@@ -0,0 +1 @@
+../PA2/fastlex.h
\ No newline at end of file
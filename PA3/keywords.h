@@ -0,0 +1 @@
+../PA2/keywords.h
\ No newline at end of file
@@ -10,32 +10,303 @@
 //
 //  Reads a COOL token stream from a file and builds the abstract syntax tree.
 //
+//  With -j n and a binary token stream (lexer -b), the files of the stream
+//  are parsed n at a time, each by its own instance of the parser into its
+//  own list of classes.  The lists are joined in the order of the files,
+//  and error messages are reported in that order too.  As each file is
+//  parsed on its own, error recovery does not carry on into the next file.
+//
+//  With -i the parser scans the input files named on the command line
+//  itself, with the scanner of fastlex.cc running on a thread of its own
+//  and handing tokens over through a TokenRing, instead of reading the
+//  lexer's output.
+//
+//  With -h the programs are parsed by the hand-written parser of pratt.cc
+//  rather than by the bison parser of cool.y.
+//
+//  With -k the hand-written parser reads every token first, parses the
+//  classes with their method bodies skipped, and then the bodies, -j n at
+//  a time (see skeleton.h).
+//
 //////////////////////////////////////////////////////////////////////////////
 
 #include <stdio.h>     // for Linux system
+#include <string.h>    // for strdup
 #include <unistd.h>    // for getopt
+#include <atomic>
+#include <sstream>
+#include <thread>
 #include "cool-io.h"  //includes iostream
 #include "cool-tree.h"
 #include "utilities.h"  // for fatal_error
 #include "cool-parse.h"
+#include "parsestate.h"
+#include "tokenstream.h"
+#include "tokenring.h"
+#include "fastlex.h"
+#include "skeleton.h"
 
 //
 // These globals keep everything working.
 //
 FILE *token_file = stdin;		// we read from this file
-extern Classes parse_results;	 // list of classes; used for multiple files 
+extern Classes parse_results;	 // list of classes; used for multiple files
 extern Program ast_root;	 // the AST produced by the parse
 
 char *curr_filename = "<stdin>";
 
 extern int omerrs;             // a count of lex and parse errors
+extern int parse_jobs;         // how many files to parse at once (-j)
+extern int lex_in_process;     // scan the input files here (-i)
+extern int parse_handwritten;  // use pratt_parse (-h)
+extern int parse_skeleton;     // method bodies after the classes (-k)
+
+extern thread_local int node_lineno;
+extern int curr_lineno;
 
-extern int cool_yyparse();
+extern int cool_yylex();
+extern void print_cool_token(ostream& out, int tok, YYSTYPE& yylval);
 void handle_flags(int argc, char *argv[]);
 
+static bool binary_input;      // is token_file a binary token stream?
+
+int parse_lex(ParseState *ps, YYSTYPE *yylval)
+{
+    int token;
+    if (ps->reader) {
+	token = ps->reader->lex(*yylval);
+	ps->lineno = ps->reader->get_lineno();
+    } else if (ps->ring) {
+	RingToken t;
+	ps->ring->pop(t);
+	token = t.token;
+	*yylval = t.yylval;
+	ps->lineno = t.lineno;
+	ps->filename = t.filename;
+    } else if (ps->buffer) {
+	const RingToken& t = ps->buffer[ps->buffer_pos];
+	if (t.token != 0)
+	    ps->buffer_pos++;
+	token = t.token;
+	*yylval = t.yylval;
+	ps->lineno = t.lineno;
+	ps->filename = t.filename;
+    } else {
+	token = binary_input ? token_stream_lex(token_file) : cool_yylex();
+	*yylval = cool_yylval;
+	ps->lineno = curr_lineno;
+	ps->filename = curr_filename;
+    }
+    ps->token = token;
+    ps->yylval = yylval;
+    return token;
+}
+
+static int parse(ParseState *ps)
+{
+    return parse_handwritten ? pratt_parse(ps) : cool_yyparse(ps);
+}
+
+void parse_error(ParseState *ps, const char *s)
+{
+    std::ostringstream buf;
+    ostream& out = ps->buffered ? (ostream&) buf : cerr;
+    out << "\"" << ps->filename << "\", line " << ps->lineno << ": "
+	<< s << " at or near ";
+    print_cool_token(out, ps->token, *ps->yylval);
+    out << endl;
+    ps->omerrs++;
+
+    if (ps->buffered)
+	ps->errors.push_back(buf.str());
+    else if (ps->omerrs > 50) {
+	fprintf(stdout, "More than 50 errors\n");
+	exit(1);
+    }
+}
+
+//
+// Parse every file of the binary stream on token_file, parse_jobs at a
+// time, and join the results into ast_root.
+//
+static void parse_in_parallel()
+{
+    std::vector<TokenReader *> readers;
+    for (;;) {
+	TokenReader *r = new TokenReader();
+	if (!r->read_file(token_file)) {
+	    delete r;
+	    break;
+	}
+	readers.push_back(r);
+    }
+
+    // A file without tokens adds nothing to the program, but on its own
+    // it would be a syntax error.
+    std::vector<ParseState *> states;
+    for (size_t i = 0; i < readers.size(); i++)
+	if (!readers[i]->at_end()) {
+	    states.push_back(new ParseState(readers[i],
+					    readers[i]->get_filename()));
+	    states.back()->buffered = true;
+	}
+    if (states.empty() && !readers.empty()) {
+	ParseState *ps = new ParseState(readers.back(),
+					readers.back()->get_filename());
+	ps->buffered = true;
+	states.push_back(ps);
+    }
+    if (states.empty()) {
+	// not even one file: parse the empty stream as usual
+	ParseState ps(NULL, curr_filename);
+	parse(&ps);
+	ast_root = ps.ast_root;
+	omerrs = ps.omerrs;
+	return;
+    }
+
+    std::atomic<size_t> next(0);
+    NodeArena *arena = NodeArena::current();
+    auto work = [&]() {
+	NodeArena mine;
+	NodeArena::Use use(&mine);
+	size_t i;
+	while ((i = next++) < states.size())
+	    parse(states[i]);
+	arena->adopt(mine);
+    };
+    std::vector<std::thread> pool;
+    for (size_t k = 1; k < (size_t) parse_jobs && k < states.size(); k++)
+	pool.push_back(std::thread(work));
+    work();
+    for (size_t k = 0; k < pool.size(); k++)
+	pool[k].join();
+
+    Classes classes = NULL;
+    for (size_t i = 0; i < states.size(); i++) {
+	ParseState *ps = states[i];
+	for (size_t e = 0; e < ps->errors.size(); e++) {
+	    cerr << ps->errors[e];
+	    if (++omerrs > 50) {
+		fprintf(stdout, "More than 50 errors\n");
+		exit(1);
+	    }
+	}
+	if (ps->ast_root == NULL)
+	    continue;
+	Classes c = ps->ast_root->get_classes();
+	if (classes == NULL) {
+	    // the program gets the line of its first class, as in one parse
+	    node_lineno = ps->ast_root->get_line_number();
+	    classes = c;
+	} else
+	    classes = append_Classes(classes, c);
+    }
+    if (omerrs == 0)
+	ast_root = program(classes);
+}
+
+//
+// The scanner thread of parser -i: the tokens of the files named in argv,
+// as the lexer would send them, then a 0.  Like the lexer, it stops at a
+// file it cannot open, and the parser gets the tokens before it.
+//
+static void scan_files(TokenRing *ring, int argc, char **argv)
+{
+    RingToken t;
+    t.lineno = 1;
+    t.filename = curr_filename;
+    for (int i = optind; i < argc; i++) {
+	FILE *fin = fopen(argv[i], "r");
+	if (fin == NULL) {
+	    cerr << "Could not open input file " << argv[i] << endl;
+	    break;
+	}
+	if (!fast_lex_open(fin)) {
+	    cerr << "Could not read input file " << argv[i] << endl;
+	    fclose(fin);
+	    break;
+	}
+	curr_lineno = 1;
+	t.filename = argv[i];
+	while ((t.token = fast_lex()) != 0) {
+	    t.lineno = curr_lineno;
+	    t.yylval = cool_yylval;
+	    // an unmatched character's message is in a buffer fast_lex reuses
+	    if (t.token == ERROR)
+		t.yylval.error_msg = strdup(t.yylval.error_msg);
+	    ring->push(t);
+	}
+	fast_lex_close();
+	fclose(fin);
+    }
+    t.token = 0;
+    ring->push(t);
+}
+
+static void parse_in_process(int argc, char *argv[])
+{
+    TokenRing *ring = new TokenRing();
+    std::thread scanner(scan_files, ring, argc, argv);
+
+    ParseState ps(NULL, curr_filename);
+    ps.ring = ring;
+    parse(&ps);
+
+    // A parse that gives up early leaves tokens behind; take them so the
+    // scanner can finish.
+    RingToken t;
+    t.token = ps.token;
+    while (t.token != 0)
+	ring->pop(t);
+    scanner.join();
+    delete ring;
+
+    ast_root = ps.ast_root;
+    omerrs = ps.omerrs;
+}
+
+//
+// Parse the whole stream on token_file as parser -k does.  If either pass
+// finds a syntax error, the tokens are parsed again in one go, which
+// reports the errors.
+//
+static void parse_skeleton_first()
+{
+    ParseState source(NULL, curr_filename);
+    SkeletonParse sp(&source);
+
+    Program skeleton = sp.parse_skeleton();
+    if (skeleton != NULL && sp.parse_bodies(parse_jobs)) {
+	ast_root = skeleton;
+	return;
+    }
+    ParseState ps(NULL, curr_filename);
+    sp.parse_all(&ps);
+    ast_root = ps.ast_root;
+    omerrs = ps.omerrs;
+}
+
 int main(int argc, char *argv[]) {
+    NodeArena arena;		// the nodes of this compilation
+    NodeArena::Use use(&arena);
+
     handle_flags(argc, argv);
-    cool_yyparse();
+    if (lex_in_process)
+	parse_in_process(argc, argv);
+    else {
+	binary_input = token_stream_detect(token_file);
+	if (parse_skeleton)
+	    parse_skeleton_first();
+	else if (binary_input && parse_jobs > 1)
+	    parse_in_parallel();
+	else {
+	    ParseState ps(NULL, curr_filename);
+	    parse(&ps);
+	    ast_root = ps.ast_root;
+	    omerrs = ps.omerrs;
+	}
+    }
     if (omerrs != 0) {
 	cerr << "Compilation halted due to lex and parse errors\n";
 	exit(1);
@@ -43,4 +314,3 @@ int main(int argc, char *argv[]) {
     ast_root->dump_with_types(cout,0);
     return 0;
 }
-
@@ -0,0 +1,72 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _PARSESTATE_H_
+#define _PARSESTATE_H_
+
+#include <string>
+#include <vector>
+#include "cool-tree.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  parsestate.h
+//
+//  Everything one run of the parser reads and writes.  The bison parser in
+//  cool.y is pure: cool_yyparse takes a ParseState and keeps nothing in
+//  globals, so several files can be parsed at once, each with its own
+//  state (see parser-phase.cc).
+//
+//  This header is included by cool.y, where bison defines YYSTYPE itself,
+//  so it only refers to YYSTYPE and the token sources through pointers.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+union YYSTYPE;
+class TokenReader;
+class TokenRing;
+struct RingToken;
+
+struct ParseState {
+  // Where the tokens come from: one file of a binary stream, a scanner
+  // running on another thread, tokens already read (from buffer_pos on;
+  // see skeleton.h), or, if all are NULL, the whole stream on token_file
+  // as cool_yylex or token_stream_lex reads it.
+  TokenReader *reader;
+  TokenRing *ring;
+  const RingToken *buffer;
+  int buffer_pos;
+
+  char *filename;               // the file of the last token
+  int lineno;                   // and its line
+  int token;                    // the last token, for error messages
+  YYSTYPE *yylval;              // and its value
+
+  Program ast_root;             // the AST produced by the parse
+  int omerrs;                   // a count of lex and parse errors
+  // If buffered, error messages are kept here instead of being printed.
+  bool buffered;
+  std::vector<std::string> errors;
+
+  ParseState(TokenReader *r, char *f) :
+    reader(r), ring(NULL), buffer(NULL), buffer_pos(0), filename(f),
+    lineno(1), token(0), yylval(NULL), ast_root(NULL), omerrs(0),
+    buffered(false) { }
+};
+
+// The next token for the parse in ps, setting *yylval and the position
+// in ps.
+extern int parse_lex(ParseState *ps, YYSTYPE *yylval);
+
+// Report the syntax error s at the last token read.
+extern void parse_error(ParseState *ps, const char *s);
+
+extern int cool_yyparse(ParseState *ps);
+
+// The hand-written parser of pratt.cc, with the same effect (parser -h).
+extern int pratt_parse(ParseState *ps);
+
+#endif
@@ -0,0 +1,798 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  pratt.cc
+//
+//  A hand-written parser for the grammar of cool.y (parser -h): recursive
+//  descent for classes and features, and precedence climbing (Pratt) for
+//  the operators, with the precedences and associativity of cool.y's
+//  %right/%left/%nonassoc declarations.  Expressions, which nest as deep
+//  as the program does, are parsed on a stack of frames of the parser's
+//  own rather than by calls (see parse_expr).
+//
+//  It builds the same AST through the same constructors, in the same
+//  order, and each node gets the line bison's YYLLOC_DEFAULT would give
+//  it: the line of the first token of the rule that builds it.
+//
+//  Syntax errors are found at the same token as in the bison parser,
+//  since both stop at the first token that cannot continue the program,
+//  and are reported through parse_error as yyerror does.  Recovery is
+//  what cool.y's one error rule, class : error ';', makes bison do:
+//  give up on the class, drop tokens up to and including the next ';',
+//  and carry on with the next class; further errors are not reported
+//  until three tokens have been shifted, and the parse stops at the end
+//  of input while recovering.
+//
+//  The one difference is let: cool.y spells out lets of one to three
+//  bindings, while here a let may have any number.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include "cool-tree.h"
+#include "cool-parse.h"
+#include "parsestate.h"
+#include "skeleton.h"
+
+extern thread_local int node_lineno;
+extern Symbol self_sym;
+
+// the operator precedences of cool.y, lowest first
+enum {
+  PREC_NONE,
+  PREC_IN,              // %nonassoc
+  PREC_ASSIGN,          // %right
+  PREC_NOT,             // %right
+  PREC_COMPARE,         // %nonassoc LE '<' '='
+  PREC_ADD,             // %left '+' '-'
+  PREC_MUL,             // %left '*' '/'
+  PREC_ISVOID,          // %left
+  PREC_NEG,             // %left '~'
+  PREC_AT,              // %left '@'
+  PREC_DOT              // %left '.'
+};
+
+static int infix_prec(int token)
+{
+  switch (token) {
+  case LE: case '<': case '=':  return PREC_COMPARE;
+  case '+': case '-':           return PREC_ADD;
+  case '*': case '/':           return PREC_MUL;
+  case '@':                     return PREC_AT;
+  case '.':                     return PREC_DOT;
+  default:                      return PREC_NONE;
+  }
+}
+
+class PrattParser {
+private:
+  enum { EMPTY = -1 };
+
+  ParseState *ps;
+  int token;                    // the lookahead, or EMPTY
+  YYSTYPE yylval;               // its value
+  int lineno;                   // and its line
+  int errstatus;                // as yyerrstatus: tokens to shift before
+                                // errors are reported again
+  bool failed;                  // unwinding to the class after an error
+  // If set, method bodies are skipped and noted here (parser -k).
+  std::vector<DeferredBody> *deferred;
+
+  int peek()
+  {
+    if (token == EMPTY) {
+      token = parse_lex(ps, &yylval);
+      lineno = ps->lineno;
+    }
+    return token;
+  }
+
+  void shift()
+  {
+    token = EMPTY;
+    if (errstatus)
+      errstatus--;
+  }
+
+  void syntax_error()
+  {
+    if (!failed && !errstatus)
+      parse_error(ps, "syntax error");
+    failed = true;
+  }
+
+  bool expect(int t)
+  {
+    if (failed)
+      return false;
+    if (peek() != t) {
+      syntax_error();
+      return false;
+    }
+    shift();
+    return true;
+  }
+
+  Symbol expect_symbol(int t)
+  {
+    Symbol s = (peek() == t) ? yylval.symbol : NULL;
+    return expect(t) ? s : NULL;
+  }
+
+  bool recover();
+
+  // the constructs of expressions under way (see parse_expr)
+  enum {
+    FRAME_EXPR = 1,             // operators after an operand
+    FRAME_ASSIGN,
+    FRAME_ARGS,                 // the arguments of a dispatch
+    FRAME_UNARY                 // isvoid, ~ and not
+    // and IF, WHILE, CASE, LET, '{' and '(' by their first token
+  };
+  struct Frame {
+    int what;
+    int stage;                  // which part of it is being parsed
+    int line;                   // of its first token
+    int min;                    // EXPR: as for parse_expr; CASE: the
+                                // line of the branch under way
+    int last;                   // EXPR: the operator just applied
+    int op;                     // EXPR: the one being applied; UNARY
+    Expression left, e, e1;     // its parts so far
+    Symbol name, type;
+    Expressions exprs;
+    Cases cases;
+    size_t bindings;            // LET: its first binding in lets
+  };
+  struct Binding {
+    Symbol name, type;
+    Expression init;            // or NULL
+  };
+  std::vector<Frame> frames;
+  std::vector<Binding> lets;
+
+  void push(int what, int line);
+  bool begin(int& min, Expression& v);
+  bool resume(int& min, Expression& v);
+  bool infix(int& min, Expression& v);
+  bool args(int& min, Expression& v);
+  bool let_bindings(int& min, bool first);
+
+  Class_ parse_class();
+  Feature parse_feature();
+  Formal parse_formal();
+  Formals parse_formals();
+  Expression parse_expr(int min);
+public:
+  PrattParser(ParseState *ps, std::vector<DeferredBody> *deferred = NULL) :
+    ps(ps), token(EMPTY), lineno(0), errstatus(0), failed(false),
+    deferred(deferred) { }
+  int parse();
+  Expression parse_body();
+};
+
+//
+// class : error ';'.  Returns false if the input ends first.
+//
+bool PrattParser::recover()
+{
+  failed = false;
+  errstatus = 3;
+  for (;;) {
+    int t = peek();
+    if (t == ';') {
+      shift();
+      return true;
+    }
+    if (t == 0)
+      return false;
+    token = EMPTY;              // dropped, not shifted
+  }
+}
+
+int PrattParser::parse()
+{
+  Classes classes = NULL;
+  int first_line = 0;
+  do {
+    // An error class gets the line of its first token, as bison gives
+    // the error token the location of the first symbol it pops.
+    peek();
+    int line = lineno;
+    Class_ c = parse_class();
+    if (failed) {
+      if (!recover())
+        return 1;
+      node_lineno = line;
+      Symbol err_sym = idtable.add_string("Error");
+      Symbol obj_sym = predef_symbol(PREDEF_Object);
+      c = class_(err_sym, obj_sym, nil_Features(),
+                 stringtable.add_string(ps->filename));
+    }
+    if (classes == NULL) {
+      first_line = line;
+      classes = single_Classes(c);
+    } else
+      classes = append_Classes(classes, single_Classes(c));
+  } while (peek() != 0);
+
+  node_lineno = first_line;
+  ps->ast_root = program(classes);
+  return 0;
+}
+
+Class_ PrattParser::parse_class()
+{
+  peek();
+  int line = lineno;
+  if (!expect(CLASS))
+    return NULL;
+  Symbol name = expect_symbol(TYPEID);
+  Symbol parent = predef_symbol(PREDEF_Object);
+  if (!failed && peek() == INHERITS) {
+    shift();
+    parent = expect_symbol(TYPEID);
+  }
+  if (!expect('{'))
+    return NULL;
+  Features features = nil_Features();
+  while (peek() == OBJECTID) {
+    Feature f = parse_feature();
+    if (!expect(';'))
+      return NULL;
+    features = append_Features(features, single_Features(f));
+  }
+  if (!expect('}') || !expect(';'))
+    return NULL;
+  node_lineno = line;
+  return class_(name, parent, features, stringtable.add_string(ps->filename));
+}
+
+Feature PrattParser::parse_feature()
+{
+  int line = lineno;
+  Symbol name = expect_symbol(OBJECTID);
+  if (peek() == '(') {
+    shift();
+    Formals formals = parse_formals();
+    if (!expect(')') || !expect(':'))
+      return NULL;
+    Symbol type = expect_symbol(TYPEID);
+    if (!expect('{'))
+      return NULL;
+    if (deferred) {
+      // Skip to the matching '}'.  The body comes later, from its tokens.
+      DeferredBody b;
+      b.start = ps->buffer_pos;
+      for (int depth = 0; peek() != '}' || depth > 0; shift()) {
+        if (token == 0) {
+          syntax_error();
+          return NULL;
+        }
+        if (token == '{')
+          depth++;
+        else if (token == '}')
+          depth--;
+      }
+      b.end = ps->buffer_pos - 1;
+      shift();
+      node_lineno = line;
+      b.method = (method_class *) method(name, formals, type, NULL);
+      deferred->push_back(b);
+      return b.method;
+    }
+    Expression body = parse_expr(PREC_NONE);
+    if (!expect('}'))
+      return NULL;
+    node_lineno = line;
+    return method(name, formals, type, body);
+  }
+  if (!expect(':'))
+    return NULL;
+  Symbol type = expect_symbol(TYPEID);
+  if (failed)
+    return NULL;
+  Expression init;
+  if (peek() == ASSIGN) {
+    shift();
+    init = parse_expr(PREC_NONE);
+    if (failed)
+      return NULL;
+  } else {
+    node_lineno = line;
+    init = no_expr();
+  }
+  node_lineno = line;
+  return attr(name, type, init);
+}
+
+Formal PrattParser::parse_formal()
+{
+  peek();
+  int line = lineno;
+  Symbol name = expect_symbol(OBJECTID);
+  if (!expect(':'))
+    return NULL;
+  Symbol type = expect_symbol(TYPEID);
+  if (failed)
+    return NULL;
+  node_lineno = line;
+  return formal(name, type);
+}
+
+//
+// formal_arg: empty, or formals separated by commas.  As in cool.y, the
+// empty list may be followed by a comma and more formals: "(, x : Int)".
+//
+Formals PrattParser::parse_formals()
+{
+  Formals formals = nil_Formals();
+  if (peek() == OBJECTID) {
+    Formal f = parse_formal();
+    if (failed)
+      return NULL;
+    formals = single_Formals(f);
+  }
+  while (peek() == ',') {
+    shift();
+    Formal f = parse_formal();
+    if (failed)
+      return NULL;
+    formals = append_Formals(formals, single_Formals(f));
+  }
+  return formals;
+}
+
+static bool starts_expr(int token)
+{
+  switch (token) {
+  case INT_CONST: case STR_CONST: case BOOL_CONST: case OBJECTID:
+  case IF: case WHILE: case NEW: case ISVOID: case '~': case NOT:
+  case CASE: case '{': case '(': case LET:
+    return true;
+  default:
+    return false;
+  }
+}
+
+//
+// An expression whose operators all bind tighter than min.  The nodes it
+// builds get the line of its first token.
+//
+// Where a recursive descent parser would call itself for a part of an
+// expression, this one pushes a Frame for the construct under way and
+// starts on the part; when the part is done, its value is handed to the
+// frame on top, which goes on from where it left off.  So it goes as
+// deep as the program nests with the native stack staying as it is.
+//
+//     begin(min, v)    starts an expression: pushes its EXPR frame and
+//                      parses what the expression starts with
+//     resume(min, v)   hands v, the value of the part just parsed, to
+//                      the frame on top
+//
+// Both return true if they want another expression, with operators
+// tighter than min, or false if the frame on top is done, in which case
+// it has been popped and v is its value.  After a syntax error they
+// return false, and the frames are dropped.
+//
+Expression PrattParser::parse_expr(int min)
+{
+  if (failed)
+    return NULL;
+  Expression v = NULL;
+  bool more = begin(min, v);
+  for (;;) {
+    if (failed) {
+      frames.clear();
+      lets.clear();
+      return NULL;
+    }
+    if (more)
+      more = begin(min, v);
+    else if (frames.empty())
+      return v;
+    else
+      more = resume(min, v);
+  }
+}
+
+void PrattParser::push(int what, int line)
+{
+  Frame f;
+  f.what = what;
+  f.stage = 0;
+  f.line = line;
+  f.min = PREC_NONE;
+  f.last = PREC_NONE;
+  f.op = 0;
+  f.left = f.e = f.e1 = NULL;
+  f.name = f.type = NULL;
+  f.exprs = NULL;
+  f.cases = NULL;
+  f.bindings = 0;
+  frames.push_back(f);
+}
+
+bool PrattParser::begin(int& min, Expression& v)
+{
+  peek();
+  int line = lineno;
+  push(FRAME_EXPR, line);
+  frames.back().min = min;
+  Symbol s;
+
+  switch (peek()) {
+  case INT_CONST:
+    s = yylval.symbol;
+    shift();
+    node_lineno = line;
+    v = int_const(s);
+    return false;
+
+  case STR_CONST:
+    s = yylval.symbol;
+    shift();
+    node_lineno = line;
+    v = string_const(s);
+    return false;
+
+  case BOOL_CONST: {
+    Boolean b = yylval.boolean;
+    shift();
+    node_lineno = line;
+    v = bool_const(b);
+    return false;
+  }
+
+  case OBJECTID:
+    s = yylval.symbol;
+    shift();
+    if (peek() == ASSIGN) {
+      shift();
+      push(FRAME_ASSIGN, line);
+      frames.back().name = s;
+      min = PREC_ASSIGN;
+      return true;
+    }
+    if (peek() == '(') {
+      shift();
+      push(FRAME_ARGS, line);
+      frames.back().name = s;
+      return args(min, v);
+    }
+    node_lineno = line;
+    v = object(s);
+    return false;
+
+  case IF:
+  case WHILE:
+  case CASE:
+  case '{':
+  case '(':
+    push(token, line);
+    shift();
+    min = PREC_NONE;
+    return true;
+
+  case NEW:
+    shift();
+    s = expect_symbol(TYPEID);
+    if (failed)
+      return false;
+    node_lineno = line;
+    v = new_(s);
+    return false;
+
+  case ISVOID:
+  case '~':
+  case NOT:
+    push(FRAME_UNARY, line);
+    frames.back().op = token;
+    min = token == ISVOID ? PREC_ISVOID : token == '~' ? PREC_NEG : PREC_NOT;
+    shift();
+    return true;
+
+  case LET:
+    shift();
+    push(LET, line);
+    frames.back().bindings = lets.size();
+    return let_bindings(min, true);
+
+  default:
+    syntax_error();
+    return false;
+  }
+}
+
+bool PrattParser::resume(int& min, Expression& v)
+{
+  Frame& f = frames.back();
+  node_lineno = f.line;
+
+  switch (f.what) {
+  case FRAME_EXPR:
+    switch (f.op) {
+    case '+': f.left = plus(f.left, v); break;
+    case '-': f.left = sub(f.left, v); break;
+    case '*': f.left = mul(f.left, v); break;
+    case '/': f.left = divide(f.left, v); break;
+    case '<': f.left = lt(f.left, v); break;
+    case LE:  f.left = leq(f.left, v); break;
+    case '=': f.left = eq(f.left, v); break;
+    default:  f.left = v; break;       // what it starts with, or a dispatch
+    }
+    return infix(min, v);
+
+  case FRAME_ASSIGN:
+    v = assign(f.name, v);
+    break;
+
+  case FRAME_ARGS:
+    f.exprs = f.stage == 0 ? single_Expressions(v)
+                           : append_Expressions(f.exprs, single_Expressions(v));
+    f.stage = 1;
+    return args(min, v);
+
+  case FRAME_UNARY:
+    switch (f.op) {
+    case ISVOID: v = isvoid(v); break;
+    case '~':    v = neg(v); break;
+    default:     v = comp(v); break;
+    }
+    break;
+
+  case IF:
+    if (f.stage < 2) {
+      if (f.stage == 0)
+        f.e = v;
+      else
+        f.e1 = v;
+      if (!expect(f.stage == 0 ? THEN : ELSE))
+        return false;
+      f.stage++;
+      min = PREC_NONE;
+      return true;
+    }
+    if (!expect(FI))
+      return false;
+    v = cond(f.e, f.e1, v);
+    break;
+
+  case WHILE:
+    if (f.stage == 0) {
+      f.e = v;
+      if (!expect(LOOP))
+        return false;
+      f.stage = 1;
+      min = PREC_NONE;
+      return true;
+    }
+    if (!expect(POOL))
+      return false;
+    v = loop(f.e, v);
+    break;
+
+  case CASE:
+    if (f.stage == 0) {
+      f.e = v;
+      if (!expect(OF))
+        return false;
+    } else {
+      if (!expect(';'))
+        return false;
+      node_lineno = f.min;      // the branch's line
+      Cases c = single_Cases(branch(f.name, f.type, v));
+      f.cases = f.cases ? append_Cases(f.cases, c) : c;
+      if (peek() == ESAC) {
+        shift();
+        node_lineno = f.line;
+        v = typcase(f.e, f.cases);
+        break;
+      }
+    }
+    // the next branch
+    peek();
+    f.min = lineno;
+    f.name = expect_symbol(OBJECTID);
+    if (!expect(':'))
+      return false;
+    f.type = expect_symbol(TYPEID);
+    if (!expect(DARROW))
+      return false;
+    f.stage = 1;
+    min = PREC_NONE;
+    return true;
+
+  case '{': {
+    if (!expect(';'))
+      return false;
+    Expressions one = single_Expressions(v);
+    f.exprs = f.exprs ? append_Expressions(f.exprs, one) : one;
+    if (peek() != '}') {
+      min = PREC_NONE;
+      return true;
+    }
+    shift();
+    v = block(f.exprs);
+    break;
+  }
+
+  case '(':
+    if (!expect(')'))
+      return false;
+    break;
+
+  case LET:
+    if (f.stage == 1) {
+      lets.back().init = v;
+      return let_bindings(min, false);
+    }
+    {
+      // the body: the lets are nested, the first binding outermost
+      Expression no_init = NULL;
+      for (size_t i = lets.size(); i-- > f.bindings; ) {
+        Expression init = lets[i].init;
+        if (init == NULL) {
+          if (no_init == NULL)
+            no_init = no_expr();
+          init = no_init;
+        }
+        v = let(lets[i].name, lets[i].type, init, v);
+      }
+      lets.resize(f.bindings);
+    }
+    break;
+  }
+  frames.pop_back();
+  return false;
+}
+
+//
+// The operators after the left operand of the EXPR frame on top, until
+// one that does not bind tighter than its min.
+//
+bool PrattParser::infix(int& min, Expression& v)
+{
+  Frame& f = frames.back();
+  int op = peek();
+  int prec = infix_prec(op);
+  if (prec <= f.min) {
+    v = f.left;
+    frames.pop_back();
+    return false;
+  }
+  if (prec == PREC_COMPARE && f.last == PREC_COMPARE) {
+    // %nonassoc: a < b < c
+    syntax_error();
+    return false;
+  }
+  f.last = prec;
+  f.op = op;
+  shift();
+
+  if (op == '.' || op == '@') {
+    Symbol type = NULL;
+    if (op == '@') {
+      type = expect_symbol(TYPEID);
+      if (!expect('.'))
+        return false;
+    }
+    Symbol name = expect_symbol(OBJECTID);
+    if (!expect('('))
+      return false;
+    int line = f.line;
+    Expression left = f.left;
+    push(FRAME_ARGS, line);
+    frames.back().left = left;
+    frames.back().type = type;
+    frames.back().name = name;
+    return args(min, v);
+  }
+  min = prec;
+  return true;
+}
+
+//
+// arg_list_call, which like formal_arg allows "(, e)", and the ')' after
+// it; then the dispatch, on self if the ARGS frame on top has no left.
+//
+bool PrattParser::args(int& min, Expression& v)
+{
+  Frame& f = frames.back();
+  if (f.exprs == NULL) {
+    f.exprs = nil_Expressions();
+    if (starts_expr(peek())) {
+      min = PREC_NONE;
+      return true;
+    }
+    f.stage = 1;                // any more are appended to the nil list
+  }
+  if (peek() == ',') {
+    shift();
+    min = PREC_NONE;
+    return true;
+  }
+  if (!expect(')'))
+    return false;
+  node_lineno = f.line;
+  if (f.left == NULL)
+    v = dispatch(object(self_sym), f.name, f.exprs);
+  else if (f.type != NULL)
+    v = static_dispatch(f.left, f.type, f.name, f.exprs);
+  else
+    v = dispatch(f.left, f.name, f.exprs);
+  frames.pop_back();
+  return false;
+}
+
+//
+// The bindings of the LET frame on top, from the first one if first or
+// else from after the last one's init; then IN, before the body, which
+// reaches as far right as it can.
+//
+bool PrattParser::let_bindings(int& min, bool first)
+{
+  for (;; first = false) {
+    if (!first) {
+      if (peek() != ',')
+        break;
+      shift();
+    }
+    Binding b;
+    b.name = expect_symbol(OBJECTID);
+    if (!expect(':'))
+      return false;
+    b.type = expect_symbol(TYPEID);
+    if (failed)
+      return false;
+    b.init = NULL;
+    lets.push_back(b);
+    if (peek() == ASSIGN) {
+      shift();
+      frames.back().stage = 1;
+      min = PREC_NONE;
+      return true;
+    }
+  }
+  if (!expect(IN))
+    return false;
+  frames.back().stage = 2;
+  min = PREC_IN;
+  return true;
+}
+
+//
+// A method body on its own: the expression, which must be followed by
+// the '}' that closes it.
+//
+Expression PrattParser::parse_body()
+{
+  Expression e = parse_expr(PREC_NONE);
+  if (!failed && peek() != '}')
+    syntax_error();
+  return failed ? NULL : e;
+}
+
+int pratt_parse(ParseState *ps)
+{
+  PrattParser parser(ps);
+  return parser.parse();
+}
+
+Program pratt_parse_skeleton(ParseState *ps, std::vector<DeferredBody>& bodies)
+{
+  PrattParser parser(ps, &bodies);
+  if (parser.parse() != 0 || ps->omerrs != 0)
+    return NULL;
+  return ps->ast_root;
+}
+
+Expression pratt_parse_body(ParseState *ps)
+{
+  PrattParser parser(ps);
+  return parser.parse_body();
+}
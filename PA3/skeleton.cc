@@ -0,0 +1,89 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  skeleton.cc
+//
+//  SkeletonParse, declared in skeleton.h.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include "skeleton.h"
+
+SkeletonParse::SkeletonParse(ParseState *ps)
+{
+  RingToken t;
+  do {
+    t.token = parse_lex(ps, &t.yylval);
+    t.lineno = ps->lineno;
+    t.filename = ps->filename;
+    // the scanner may reuse the buffer an error message is in
+    if (t.token == ERROR)
+      t.yylval.error_msg = strdup(t.yylval.error_msg);
+    tokens.push_back(t);
+  } while (t.token != 0);
+}
+
+Program SkeletonParse::parse_skeleton()
+{
+  ParseState ps(NULL, tokens[0].filename);
+  ps.buffer = &tokens[0];
+  ps.buffered = true;
+  bodies.clear();
+  return pratt_parse_skeleton(&ps, bodies);
+}
+
+bool SkeletonParse::parse_body(int i)
+{
+  DeferredBody& b = bodies[i];
+  ParseState ps(NULL, tokens[b.start].filename);
+  ps.buffer = &tokens[0];
+  ps.buffer_pos = b.start;
+  ps.buffered = true;
+  Expression e = pratt_parse_body(&ps);
+  // the parser has read the '}' and stopped
+  if (e == NULL || ps.buffer_pos != b.end + 1)
+    return false;
+  // The method is counted as shared, having been appended to its class's
+  // features (see tree.h), but no other tree can hold it yet: the
+  // program is not handed on until every body is in.
+  b.method->set_body(e);
+  return true;
+}
+
+bool SkeletonParse::parse_bodies(int jobs)
+{
+  std::atomic<int> next(0);
+  std::atomic<bool> ok(true);
+  NodeArena *arena = NodeArena::current();
+  auto work = [&]() {
+    NodeArena mine;
+    NodeArena::Use use(&mine);
+    int i;
+    while (ok && (i = next++) < (int) bodies.size())
+      if (!parse_body(i))
+	ok = false;
+    arena->adopt(mine);
+  };
+  std::vector<std::thread> pool;
+  for (int k = 1; k < jobs && k < (int) bodies.size(); k++)
+    pool.push_back(std::thread(work));
+  work();
+  for (size_t k = 0; k < pool.size(); k++)
+    pool[k].join();
+  return ok;
+}
+
+void SkeletonParse::parse_all(ParseState *ps)
+{
+  ps->buffer = &tokens[0];
+  ps->buffer_pos = 0;
+  pratt_parse(ps);
+}
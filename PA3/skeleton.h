@@ -0,0 +1,72 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _SKELETON_H_
+#define _SKELETON_H_
+
+#include <vector>
+#include "cool-tree.h"
+#include "parsestate.h"
+#include "tokenring.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  skeleton.h
+//
+//  Skeleton-first parsing (parser -k).  A first pass over the tokens
+//  parses the classes, attributes and method signatures, and skips each
+//  method body by matching braces, noting where its tokens are.  That
+//  gives the whole program with its method bodies missing, which is
+//  enough for anything that only needs the signatures.  The bodies are
+//  then parsed one at a time as they are wanted, or all together on a
+//  pool of threads.
+//
+//  Both passes are the hand-written parser of pratt.cc.  A pass that
+//  finds a syntax error reports nothing: the program is then parsed
+//  again in one go, so that the errors are reported exactly as without
+//  -k.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+struct DeferredBody {
+  method_class *method;         // the method the body belongs to
+  int start;                    // the body's first token
+  int end;                      // the '}' after its last token
+};
+
+class SkeletonParse {
+private:
+  std::vector<RingToken> tokens;        // the whole input, then a 0
+  std::vector<DeferredBody> bodies;
+public:
+  // Read every token ps's source has to give.
+  SkeletonParse(ParseState *ps);
+
+  // The first pass.  The program it returns has no method bodies until
+  // they are parsed; NULL if there is a syntax error.
+  Program parse_skeleton();
+
+  int get_body_count() { return bodies.size(); }
+  DeferredBody& get_body(int i) { return bodies[i]; }
+
+  // Parse the body of bodies[i] and give it to its method.  Different
+  // bodies may be parsed at once on different threads.  False if there
+  // is a syntax error.
+  bool parse_body(int i);
+
+  // Parse every body, jobs at a time.
+  bool parse_bodies(int jobs);
+
+  // The whole program in one pass, reporting errors as usual.
+  void parse_all(ParseState *ps);
+};
+
+// pratt.cc
+extern Program pratt_parse_skeleton(ParseState *ps,
+				    std::vector<DeferredBody>& bodies);
+extern Expression pratt_parse_body(ParseState *ps);
+
+#endif
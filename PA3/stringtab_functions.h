@@ -0,0 +1,284 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#include <string.h>
+#include <new>
+#include <atomic>
+#include <mutex>
+#include "cool-io.h"
+#include "stringtab.h"
+#include <stdio.h>
+
+//
+// Allocate an empty hash index of size slots.
+//
+template <class Elem>
+typename StringTable<Elem>::Slots *StringTable<Elem>::new_slots(int size)
+{
+  void *mem = ::operator new(sizeof(Slots) + (size - 1) * sizeof(std::atomic<Elem *>));
+  Slots *t = (Slots *) mem;
+  t->size = size;
+  t->older = NULL;
+  for (int i = 0; i < size; i++)
+    new (&t->slot[i]) std::atomic<Elem *>(NULL);
+  return t;
+}
+
+//
+// The cell holding entry i.  Segment k starts at index 64 * (2^k - 1),
+// so the segment is the position of the top bit of i / 64 + 1.
+// Segments are created on demand by whichever inserter needs one first.
+//
+template <class Elem>
+std::atomic<Elem *> &StringTable<Elem>::entry_ref(int i)
+{
+  unsigned q = ((unsigned) i >> SEG0_BITS) + 1;
+  int k = 31 - __builtin_clz(q);
+  int off = i - (((1 << k) - 1) << SEG0_BITS);
+
+  std::atomic<Elem *> *seg = segments[k].cells.load(std::memory_order_acquire);
+  if (seg == NULL) {
+    int n = 1 << (SEG0_BITS + k);
+    std::atomic<Elem *> *fresh = new std::atomic<Elem *>[n];
+    for (int j = 0; j < n; j++)
+      fresh[j].store(NULL, std::memory_order_relaxed);
+    if (segments[k].cells.compare_exchange_strong(seg, fresh,
+					    std::memory_order_acq_rel))
+      seg = fresh;
+    else
+      delete [] fresh;     // another thread won; seg is its segment
+  }
+  return seg[off];
+}
+
+//
+// Find the entry for the first len characters of s, or NULL.  h must be
+// hash_string(s, len).  This takes no lock.  An index is never full, so
+// probing always reaches an empty slot.
+//
+template <class Elem>
+Elem *StringTable<Elem>::find(Shard& sh, char *s, int len, unsigned h)
+{
+  Slots *t = sh.slots.load(std::memory_order_acquire);
+  if (t == NULL)
+    return NULL;
+
+  unsigned mask = t->size - 1;
+  for (unsigned i = h & mask; ; i = (i + 1) & mask) {
+    Elem *e = t->slot[i].load(std::memory_order_acquire);
+    if (e == NULL)
+      return NULL;
+    if (e->hash == h && e->equal_string(s, len))
+      return e;
+  }
+}
+
+//
+// Enter a string known not to be in the table, with hash h.  The
+// caller holds sh.lock.  The shard's index is replaced by one twice the
+// size whenever it would become more than half full; rehashing reuses
+// the stored hashes, so no string is hashed twice.
+//
+template <class Elem>
+Elem *StringTable<Elem>::insert(Shard& sh, char *s, int len, unsigned h)
+{
+  Slots *t = sh.slots.load(std::memory_order_relaxed);
+  if (t == NULL || 2 * (sh.count + 1) > t->size) {
+    Slots *n = new_slots(t ? 2 * t->size : 64);
+    if (t != NULL) {
+      unsigned mask = n->size - 1;
+      for (int j = 0; j < t->size; j++) {
+	Elem *e = t->slot[j].load(std::memory_order_relaxed);
+	if (e == NULL)
+	  continue;
+	unsigned i = e->hash & mask;
+	while (n->slot[i].load(std::memory_order_relaxed) != NULL)
+	  i = (i + 1) & mask;
+	n->slot[i].store(e, std::memory_order_relaxed);
+      }
+    }
+    n->older = t;
+    sh.slots.store(n, std::memory_order_release);
+    t = n;
+  }
+
+  // One arena allocation holds the entry followed by its text.
+  char *mem = (char *) sh.arena.alloc(sizeof(Elem) + len + 1);
+  char *text = mem + sizeof(Elem);
+  memcpy(text, s, len);
+  text[len] = '\0';
+  int ind = index.fetch_add(1, std::memory_order_relaxed);
+  Elem *e = new (mem) Elem(text, len, ind);
+  e->hash = h;
+  e->precompute(sh.arena);
+  entry_ref(ind).store(e, std::memory_order_release);
+  sh.count++;
+
+  unsigned mask = t->size - 1;
+  unsigned i = h & mask;
+  while (t->slot[i].load(std::memory_order_relaxed) != NULL)
+    i = (i + 1) & mask;
+  t->slot[i].store(e, std::memory_order_release);
+  return e;
+}
+
+//
+// Find or add a string: a lock-free look first, then again under the
+// shard's lock in case another thread added it in between.
+//
+template <class Elem>
+Elem *StringTable<Elem>::intern(char *s, int len, unsigned h)
+{
+  Shard& sh = shard_of(shards, h);
+  Elem *e = find(sh, s, len, h);
+  if (e != NULL)
+    return e;
+
+  std::lock_guard<std::mutex> guard(sh.lock);
+  e = find(sh, s, len, h);
+  if (e == NULL)
+    e = insert(sh, s, len, h);
+  return e;
+}
+
+//
+// Give the predefined strings indices 0..npredef-1.  Their hashes were
+// computed at compile time and they are known to be distinct, so this
+// neither hashes nor probes for duplicates.  Whoever gets here first
+// installs them while everyone else waits on install_lock.
+//
+template <class Elem>
+void StringTable<Elem>::install_predefined()
+{
+  std::lock_guard<std::mutex> guard(install_lock);
+  if (installed.load(std::memory_order_relaxed))
+    return;
+  assert(index.load() == 0);
+  for (int i = 0; i < npredef; i++) {
+    Shard& sh = shard_of(shards, predef[i].hash);
+    std::lock_guard<std::mutex> shard_guard(sh.lock);
+    insert(sh, (char *) predef[i].name, predef[i].len, predef[i].hash);
+  }
+  installed.store(true, std::memory_order_release);
+}
+
+//
+// Everything the table allocated besides the arenas, which free
+// themselves.  Entries live in the arenas, so this runs no destructors.
+//
+template <class Elem>
+StringTable<Elem>::~StringTable()
+{
+  for (int i = 0; i < NSHARDS; i++) {
+    Slots *t = shards[i].slots.load();
+    while (t != NULL) {
+      Slots *older = t->older;
+      ::operator delete(t);
+      t = older;
+    }
+  }
+  for (int k = 0; k < NSEGS; k++)
+    delete [] segments[k].cells.load();
+}
+
+//
+// The following methods each add a string to the string table.
+// Only one copy of each string is maintained.
+// Returns a pointer to the string table entry with the string.
+//
+//
+// s need not be NUL-terminated if it has maxchars characters: nothing
+// past them is read, so callers can intern text in place.
+//
+template <class Elem>
+Elem *StringTable<Elem>::add_string(char *s, int maxchars)
+{
+  int len = (int) strnlen(s, maxchars);
+
+  ready();
+  return intern(s, len, hash_string(s, len));
+}
+
+//
+// Add a null-terminated string to the string table.
+//
+template <class Elem>
+Elem *StringTable<Elem>::add_string(char *s)
+{
+  return add_string(s, (int) strlen(s));
+}
+
+//
+// Add the string representation of an integer to the string table.
+//
+template <class Elem>
+Elem *StringTable<Elem>::add_int(int i)
+{
+  char buf[20];
+  snprintf(buf, sizeof(buf), "%d", i);
+  return add_string(buf);
+}
+
+template <class Elem>
+int StringTable<Elem>::first()
+{
+  ready();
+  return 0;
+}
+
+template <class Elem>
+int StringTable<Elem>::more(int i)
+{
+  return i < index.load(std::memory_order_acquire);
+}
+
+template <class Elem>
+int StringTable<Elem>::next(int i)
+{
+  assert(i < index.load(std::memory_order_acquire));
+  return i+1;
+}
+
+//
+// Entries are stored by index, so this is a direct array access.
+//
+template <class Elem>
+Elem *StringTable<Elem>::lookup(int ind)
+{
+  ready();
+  assert(ind >= 0 && ind < index.load(std::memory_order_acquire));
+  Elem *e = entry_ref(ind).load(std::memory_order_acquire);
+  assert(e != NULL);   // fail if ind is not found
+  return e;
+}
+
+//
+// Lookup a string in the table.  Like the list-based table it replaces,
+// this fails if the string is not present.
+//
+template <class Elem>
+Elem *StringTable<Elem>::lookup_string(char *s)
+{
+  ready();
+  int len = (int) strlen(s);
+  unsigned h = hash_string(s, len);
+  Elem *e = find(shard_of(shards, h), s, len, h);
+  assert(e != NULL);   // fail if string is not found
+  return e;
+}
+
+//
+// Print the table in index order.
+//
+template <class Elem>
+void StringTable<Elem>::print()
+{
+  ready();
+  cerr << "[\n";
+  for (int i = first(); more(i); i = next(i))
+    cerr << *lookup(i) << " ";
+  cerr << "]\n";
+}
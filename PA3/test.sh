@@ -0,0 +1,56 @@
+#!/bin/bash
+# test.sh: the hand-written parser (-h) and skeleton-first parsing (-k)
+# must print exactly what the bison parser prints, on expressions nested
+# far deeper than the C++ stack would allow a recursive parser to go.
+#
+# usage: test.sh [depth] [files...]
+
+depth=${1:-200000}
+shift
+
+# rep n s: s, n times over
+rep() {
+    awk -v n=$1 -v s="$2" 'BEGIN { for (i = 0; i < n; i++) printf "%s", s }'
+}
+
+# deep name body: a program whose main is body
+deep() {
+    echo "class Main { main() : Object { $2 }; };" > deep_$1.cl
+}
+
+n=$depth
+deep paren  "$(rep $n '(')1$(rep $n ')')"
+deep let    "$(rep $n 'let x : Int <- 1 in ')x"
+deep neg    "$(rep $n '~')1"
+deep not    "$(rep $n 'not ')true"
+deep assign "$(rep $n 'x <- ')1"
+deep if     "$(rep $n 'if true then ')1$(rep $n ' else 2 fi')"
+deep while  "$(rep $n 'while true loop ')1$(rep $n ' pool')"
+deep case   "$(rep $n 'case ')1$(rep $n ' of x : Int => 1; esac')"
+deep block  "$(rep $n '{ ')1;$(rep $((n - 1)) ' };') }"
+deep args   "$(rep $n 'f(')1$(rep $n ')')"
+deep dot    "$(rep $n '(')1$(rep $n ').f()')"
+deep error  "$(rep $n '(')1 +$(rep $n ')')"
+
+status=0
+for file in deep_*.cl "$@"; do
+    echo "Testing $file..."
+    ./lexer $file > tokens_${file%.cl}.txt 2>&1
+    ./parser < tokens_${file%.cl}.txt > bison_${file%.cl}.txt 2>&1
+    for flag in -h -k; do
+        out=pratt${flag}_${file%.cl}.txt
+        ./parser $flag < tokens_${file%.cl}.txt > $out 2>&1
+        rc=$?
+        if [ $rc -ge 128 ]; then
+            echo "$file ($flag): FAIL, killed by signal $((rc - 128))"
+            status=1
+        elif diff bison_${file%.cl}.txt $out > /dev/null; then
+            echo "$file ($flag): PASS"
+        else
+            echo "$file ($flag): FAIL"
+            diff bison_${file%.cl}.txt $out | head -20
+            status=1
+        fi
+    done
+done
+exit $status
@@ -0,0 +1,75 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _TOKENRING_H_
+#define _TOKENRING_H_
+
+#include <atomic>
+#include <thread>
+#include "cool-parse.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  tokenring.h
+//
+//  A bounded single-producer, single-consumer queue of tokens, for running
+//  the scanner on its own thread ahead of the parser (parser -i; see
+//  parser-phase.cc).  Each side owns one index and only reads the other's;
+//  a side that finds the ring full or empty yields and tries again.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+struct RingToken {
+  int token;            // 0 after the last file
+  int lineno;
+  char *filename;
+  YYSTYPE yylval;
+};
+
+class TokenRing {
+private:
+  enum { SIZE = 1 << 12 };              // a power of two
+
+  RingToken slots[SIZE];
+  // Counts of tokens pushed and popped.  Each is written by one side
+  // only, and kept on its own cache line along with that side's last
+  // look at the other count, so a side touches the other's line only
+  // when the ring seems full or empty.
+  alignas(64) std::atomic<unsigned> pushed;
+  unsigned popped_seen;                 // producer's copy of popped
+  alignas(64) std::atomic<unsigned> popped;
+  unsigned pushed_seen;                 // consumer's copy of pushed
+public:
+  TokenRing() : pushed(0), popped_seen(0), popped(0), pushed_seen(0) { }
+
+  // producer
+  void push(const RingToken& t)
+  {
+    unsigned n = pushed.load(std::memory_order_relaxed);
+    while (n - popped_seen == SIZE) {
+      popped_seen = popped.load(std::memory_order_acquire);
+      if (n - popped_seen == SIZE)
+	std::this_thread::yield();
+    }
+    slots[n & (SIZE - 1)] = t;
+    pushed.store(n + 1, std::memory_order_release);
+  }
+
+  // consumer
+  void pop(RingToken& t)
+  {
+    unsigned n = popped.load(std::memory_order_relaxed);
+    while (n == pushed_seen) {
+      pushed_seen = pushed.load(std::memory_order_acquire);
+      if (n == pushed_seen)
+	std::this_thread::yield();
+    }
+    t = slots[n & (SIZE - 1)];
+    popped.store(n + 1, std::memory_order_release);
+  }
+};
+
+#endif
@@ -15,8 +15,9 @@
 
 #include "tree.h"
 
-/* line number to assign to the current node being constructed */
-int node_lineno = 1;
+/* line number to assign to the current node being constructed; one per
+   thread, so files can be parsed in parallel */
+thread_local int node_lineno = 1;
 
 ///////////////////////////////////////////////////////////////////////////
 //
@@ -28,6 +29,7 @@ int node_lineno = 1;
 tree_node::tree_node()
 {
     line_number = node_lineno;
+    shares = 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -47,3 +49,78 @@ tree_node *tree_node::set(tree_node *t) {
    line_number = t->line_number;
    return this;
 }
+
+///////////////////////////////////////////////////////////////////////////
+//
+// NodeArena
+//
+///////////////////////////////////////////////////////////////////////////
+thread_local NodeArena *NodeArena::in_use = NULL;
+
+// the arena of a thread with none in use; never released
+NodeArena *NodeArena::thread_arena()
+{
+    static thread_local NodeArena *arena = new NodeArena();
+    return arena;
+}
+
+void *NodeArena::allocate_block(size_t size)
+{
+    char *b;
+
+    // A node too big to leave much of a block over gets a block of its
+    // own, and the last ordinary block goes on being used.
+    if (size > block_size / 4) {
+	b = (char *) ::operator new(size);
+	blocks.push_back(b);
+	held += size;
+	return b;
+    }
+    b = (char *) ::operator new(block_size);
+    blocks.push_back(b);
+    held += block_size;
+    next = b + size;
+    left = block_size - size;
+    return b;
+}
+
+void NodeArena::adopt(NodeArena& a)
+{
+    std::lock_guard<std::mutex> lock(adopting);
+    blocks.insert(blocks.end(), a.blocks.begin(), a.blocks.end());
+    destroy.insert(destroy.end(), a.destroy.begin(), a.destroy.end());
+    held += a.held;
+    a.blocks.clear();
+    a.destroy.clear();
+    a.leaves.clear();
+    a.next = NULL;
+    a.left = 0;
+    a.held = 0;
+}
+
+void NodeArena::release()
+{
+    for (size_t i = destroy.size(); i-- > 0; )
+	destroy[i]->~tree_node();
+    for (size_t i = 0; i < blocks.size(); i++)
+	::operator delete(blocks[i]);
+    blocks.clear();
+    destroy.clear();
+    leaves.clear();
+    next = NULL;
+    left = 0;
+    held = 0;
+}
+
+tree_node *NodeArena::find_leaf(int kind, int value)
+{
+    Leaf l = { kind, value, node_lineno };
+    auto found = leaves.find(l);
+    return found == leaves.end() ? NULL : found->second;
+}
+
+void NodeArena::keep_leaf(int kind, int value, tree_node *t)
+{
+    Leaf l = { kind, value, t->get_line_number() };
+    leaves[l] = t;
+}
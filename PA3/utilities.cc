@@ -123,44 +123,53 @@ char *cool_token_to_string(int tok)
   }
 }
 
-void print_cool_token(int tok)
+//
+// The token tok with the value yylval, as the parser shows it in an error
+// message.
+//
+void print_cool_token(ostream& out, int tok, YYSTYPE& yylval)
 {
 
-  cerr << cool_token_to_string(tok);
+  out << cool_token_to_string(tok);
 
   switch (tok) {
   case (STR_CONST):
-    cerr << " = ";
-    cerr << " \"";
-    print_escaped_string(cerr, cool_yylval.symbol->get_string());
-    cerr << "\"";
+    out << " = ";
+    out << " \"";
+    print_escaped_string(out, yylval.symbol->get_string());
+    out << "\"";
 #ifdef CHECK_TABLES
-    stringtable.lookup_string(cool_yylval.symbol->get_string());
+    stringtable.lookup_string(yylval.symbol->get_string());
 #endif
     break;
   case (INT_CONST):
-    cerr << " = " << cool_yylval.symbol;
+    out << " = " << yylval.symbol;
 #ifdef CHECK_TABLES
-    inttable.lookup_string(cool_yylval.symbol->get_string());
+    inttable.lookup_string(yylval.symbol->get_string());
 #endif
     break;
   case (BOOL_CONST):
-    cerr << (cool_yylval.boolean ? " = true" : " = false");
+    out << (yylval.boolean ? " = true" : " = false");
     break;
   case (TYPEID):
   case (OBJECTID):
-    cerr << " = " << cool_yylval.symbol;
+    out << " = " << yylval.symbol;
 #ifdef CHECK_TABLES
-    idtable.lookup_string(cool_yylval.symbol->get_string());
+    idtable.lookup_string(yylval.symbol->get_string());
 #endif
     break;
   case (ERROR): 
-    cerr << " = ";
-    print_escaped_string(cerr, cool_yylval.error_msg);
+    out << " = ";
+    print_escaped_string(out, yylval.error_msg);
     break;
   }
 }
 
+void print_cool_token(int tok)
+{
+  print_cool_token(cerr, tok, cool_yylval);
+}
+
 // dump the token in format readable by the sceond phase token lexer
 void dump_cool_token(ostream& out, int lineno, int token, YYSTYPE yylval)
 {
@@ -169,7 +178,7 @@ void dump_cool_token(ostream& out, int lineno, int token, YYSTYPE yylval)
     switch (token) {
     case (STR_CONST):
 	out << " \"";
-	print_escaped_string(out, cool_yylval.symbol->get_string());
+	((StringEntryP) cool_yylval.symbol)->print_escaped(out);
 	out << "\"";
 #ifdef CHECK_TABLES
 	stringtable.lookup_string(cool_yylval.symbol->get_string());
@@ -0,0 +1,76 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _WALKSTACK_H_
+#define _WALKSTACK_H_
+
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  Walk Stacks
+//
+//  Expressions nest as deep as the program makes them: a chain
+//  a + b + c + ... is as deep as it is long, and so is a run of lets.
+//  The traversals that go down expressions (dump, dump_with_types,
+//  type_check, produce_code) therefore keep the expressions they have
+//  yet to finish on a WalkStack of their own rather than on the native
+//  stack, which stays the same depth however deep the tree is.
+//
+//  Each kind of expression has its part of a traversal split into
+//  stages, at the points where it used to call itself on a child.  A
+//  stage does its work and then pushes what comes next: the expression
+//  itself at its next stage, if it has more to do once the children are
+//  done, and then the children, last to be visited first.  The traversal
+//  pops one step at a time and runs that stage, until the stack is
+//  empty.  Whatever a stage has to hand to a later one (the type of a
+//  child, say) goes on a stack of the traversal's own.
+//
+//  A step also carries the indentation, for the dumps.
+//
+//  The hand-written parser (pratt.cc) builds expressions the same way:
+//  what it has yet to finish sits in a vector of frames, not on the
+//  native stack.
+//
+/////////////////////////////////////////////////////////////////////////
+
+template <class Node>
+struct WalkStep {
+  Node node;
+  int stage;
+  int n;
+};
+
+template <class Node>
+class WalkStack {
+private:
+  std::vector<WalkStep<Node> > steps;
+public:
+  void push(Node node, int stage = 0, int n = 0)
+  {
+    WalkStep<Node> s = { node, stage, n };
+    steps.push_back(s);
+  }
+
+  // Push the elements of list l, so that they are visited in order.
+  template <class List>
+  void push_list(List l, int n = 0)
+  {
+    for (int i = l->len() - 1; i >= 0; i--)
+      push(l->nth(i), 0, n);
+  }
+
+  bool pop(WalkStep<Node>& s)
+  {
+    if (steps.empty())
+      return false;
+    s = steps.back();
+    steps.pop_back();
+    return true;
+  }
+};
+
+#endif
@@ -130,7 +130,9 @@ class program_class : public Program_class {
 protected:
    Classes classes;
 public:
+   friend class TreeWalk;
    program_class(Classes a1) {
+      kind = NODE_program;
       classes = a1;
    }
    Program copy_Program();
@@ -153,7 +155,9 @@ protected:
    Features features;
    Symbol filename;
 public:
+   friend class TreeWalk;
    class__class(Symbol a1, Symbol a2, Features a3, Symbol a4) {
+      kind = NODE_class_;
       name = a1;
       parent = a2;
       features = a3;
@@ -179,7 +183,9 @@ protected:
    Symbol return_type;
    Expression expr;
 public:
+   friend class TreeWalk;
    method_class(Symbol a1, Formals a2, Symbol a3, Expression a4) {
+      kind = NODE_method;
       name = a1;
       formals = a2;
       return_type = a3;
@@ -204,7 +210,9 @@ protected:
    Symbol type_decl;
    Expression init;
 public:
+   friend class TreeWalk;
    attr_class(Symbol a1, Symbol a2, Expression a3) {
+      kind = NODE_attr;
       name = a1;
       type_decl = a2;
       init = a3;
@@ -227,7 +235,9 @@ protected:
    Symbol name;
    Symbol type_decl;
 public:
+   friend class TreeWalk;
    formal_class(Symbol a1, Symbol a2) {
+      kind = NODE_formal;
       name = a1;
       type_decl = a2;
    }
@@ -250,7 +260,9 @@ protected:
    Symbol type_decl;
    Expression expr;
 public:
+   friend class TreeWalk;
    branch_class(Symbol a1, Symbol a2, Expression a3) {
+      kind = NODE_branch;
       name = a1;
       type_decl = a2;
       expr = a3;
@@ -273,7 +285,9 @@ protected:
    Symbol name;
    Expression expr;
 public:
+   friend class TreeWalk;
    assign_class(Symbol a1, Expression a2) {
+      kind = NODE_assign;
       name = a1;
       expr = a2;
    }
@@ -297,7 +311,9 @@ protected:
    Symbol name;
    Expressions actual;
 public:
+   friend class TreeWalk;
    static_dispatch_class(Expression a1, Symbol a2, Symbol a3, Expressions a4) {
+      kind = NODE_static_dispatch;
       expr = a1;
       type_name = a2;
       name = a3;
@@ -322,7 +338,9 @@ protected:
    Symbol name;
    Expressions actual;
 public:
+   friend class TreeWalk;
    dispatch_class(Expression a1, Symbol a2, Expressions a3) {
+      kind = NODE_dispatch;
       expr = a1;
       name = a2;
       actual = a3;
@@ -346,7 +364,9 @@ protected:
    Expression then_exp;
    Expression else_exp;
 public:
+   friend class TreeWalk;
    cond_class(Expression a1, Expression a2, Expression a3) {
+      kind = NODE_cond;
       pred = a1;
       then_exp = a2;
       else_exp = a3;
@@ -369,7 +389,9 @@ protected:
    Expression pred;
    Expression body;
 public:
+   friend class TreeWalk;
    loop_class(Expression a1, Expression a2) {
+      kind = NODE_loop;
       pred = a1;
       body = a2;
    }
@@ -391,7 +413,9 @@ protected:
    Expression expr;
    Cases cases;
 public:
+   friend class TreeWalk;
    typcase_class(Expression a1, Cases a2) {
+      kind = NODE_typcase;
       expr = a1;
       cases = a2;
    }
@@ -412,7 +436,9 @@ class block_class : public Expression_class {
 protected:
    Expressions body;
 public:
+   friend class TreeWalk;
    block_class(Expressions a1) {
+      kind = NODE_block;
       body = a1;
    }
    Expression copy_Expression();
@@ -435,7 +461,9 @@ protected:
    Expression init;
    Expression body;
 public:
+   friend class TreeWalk;
    let_class(Symbol a1, Symbol a2, Expression a3, Expression a4) {
+      kind = NODE_let;
       identifier = a1;
       type_decl = a2;
       init = a3;
@@ -459,7 +487,9 @@ protected:
    Expression e1;
    Expression e2;
 public:
+   friend class TreeWalk;
    plus_class(Expression a1, Expression a2) {
+      kind = NODE_plus;
       e1 = a1;
       e2 = a2;
    }
@@ -481,7 +511,9 @@ protected:
    Expression e1;
    Expression e2;
 public:
+   friend class TreeWalk;
    sub_class(Expression a1, Expression a2) {
+      kind = NODE_sub;
       e1 = a1;
       e2 = a2;
    }
@@ -503,7 +535,9 @@ protected:
    Expression e1;
    Expression e2;
 public:
+   friend class TreeWalk;
    mul_class(Expression a1, Expression a2) {
+      kind = NODE_mul;
       e1 = a1;
       e2 = a2;
    }
@@ -525,7 +559,9 @@ protected:
    Expression e1;
    Expression e2;
 public:
+   friend class TreeWalk;
    divide_class(Expression a1, Expression a2) {
+      kind = NODE_divide;
       e1 = a1;
       e2 = a2;
    }
@@ -546,7 +582,9 @@ class neg_class : public Expression_class {
 protected:
    Expression e1;
 public:
+   friend class TreeWalk;
    neg_class(Expression a1) {
+      kind = NODE_neg;
       e1 = a1;
    }
    Expression copy_Expression();
@@ -567,7 +605,9 @@ protected:
    Expression e1;
    Expression e2;
 public:
+   friend class TreeWalk;
    lt_class(Expression a1, Expression a2) {
+      kind = NODE_lt;
       e1 = a1;
       e2 = a2;
    }
@@ -589,7 +629,9 @@ protected:
    Expression e1;
    Expression e2;
 public:
+   friend class TreeWalk;
    eq_class(Expression a1, Expression a2) {
+      kind = NODE_eq;
       e1 = a1;
       e2 = a2;
    }
@@ -611,7 +653,9 @@ protected:
    Expression e1;
    Expression e2;
 public:
+   friend class TreeWalk;
    leq_class(Expression a1, Expression a2) {
+      kind = NODE_leq;
       e1 = a1;
       e2 = a2;
    }
@@ -632,7 +676,9 @@ class comp_class : public Expression_class {
 protected:
    Expression e1;
 public:
+   friend class TreeWalk;
    comp_class(Expression a1) {
+      kind = NODE_comp;
       e1 = a1;
    }
    Expression copy_Expression();
@@ -652,7 +698,9 @@ class int_const_class : public Expression_class {
 protected:
    Symbol token;
 public:
+   friend class TreeWalk;
    int_const_class(Symbol a1) {
+      kind = NODE_int_const;
       token = a1;
    }
    Expression copy_Expression();
@@ -672,7 +720,9 @@ class bool_const_class : public Expression_class {
 protected:
    Boolean val;
 public:
+   friend class TreeWalk;
    bool_const_class(Boolean a1) {
+      kind = NODE_bool_const;
       val = a1;
    }
    Expression copy_Expression();
@@ -692,7 +742,9 @@ class string_const_class : public Expression_class {
 protected:
    Symbol token;
 public:
+   friend class TreeWalk;
    string_const_class(Symbol a1) {
+      kind = NODE_string_const;
       token = a1;
    }
    Expression copy_Expression();
@@ -712,7 +764,9 @@ class new__class : public Expression_class {
 protected:
    Symbol type_name;
 public:
+   friend class TreeWalk;
    new__class(Symbol a1) {
+      kind = NODE_new_;
       type_name = a1;
    }
    Expression copy_Expression();
@@ -732,7 +786,9 @@ class isvoid_class : public Expression_class {
 protected:
    Expression e1;
 public:
+   friend class TreeWalk;
    isvoid_class(Expression a1) {
+      kind = NODE_isvoid;
       e1 = a1;
    }
    Expression copy_Expression();
@@ -751,7 +807,9 @@ public:
 class no_expr_class : public Expression_class {
 protected:
 public:
+   friend class TreeWalk;
    no_expr_class() {
+      kind = NODE_no_expr;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
@@ -770,7 +828,9 @@ class object_class : public Expression_class {
 protected:
    Symbol name;
 public:
+   friend class TreeWalk;
    object_class(Symbol a1) {
+      kind = NODE_object;
       name = a1;
    }
    Expression copy_Expression();
@@ -786,6 +846,8 @@ public:
 
 
 // define the prototypes of the interface
+// (append_X(l1, l2) adds l2 to the end of l1 itself, and returns it;
+// see list_node::append in tree.h)
 Classes nil_Classes();
 Classes single_Classes(Class_);
 Classes append_Classes(Classes, Classes);
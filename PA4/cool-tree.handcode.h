@@ -9,6 +9,7 @@
 #include "cool.h"
 #include "stringtab.h"
 #include "symtab.h"
+#include "walkstack.h"
 #define yylineno curr_lineno;
 extern int yylineno;
 
@@ -26,6 +27,8 @@ typedef Program_class *Program;
 class Class__class;
 typedef Class__class *Class_;
 class ClassTable;
+class TypeCheck;
+class FlatBuilder;
 class Feature_class;
 typedef Feature_class *Feature;
 class Formal_class;
@@ -46,6 +49,9 @@ typedef Expressions_class *Expressions;
 typedef list_node<Case> Cases_class;
 typedef Cases_class *Cases;
 
+// see walkstack.h
+typedef WalkStack<Expression> ExpressionWalk;
+
 #define Program_EXTRAS                          \
 virtual void semant() = 0;			\
 virtual void dump_with_types(ostream&, int) = 0; 
@@ -54,13 +60,14 @@ virtual void dump_with_types(ostream&, int) = 0;
 
 #define program_EXTRAS                            \
 void semant();     				                        \
-void dump_with_types(ostream&, int);            
+void dump_with_types(ostream&, int);                              \
+void flatten(FlatBuilder&);
 
 #define Class__EXTRAS                             \
 virtual Symbol get_filename() = 0;                \
 virtual Symbol get_name() = 0;                    \
 virtual Symbol get_parent() = 0;                  \
-virtual Features get_features() = 0;              \
+virtual Features& get_features() = 0;             \
 virtual void dump_with_types(ostream&,int) = 0; 
 
 
@@ -68,8 +75,9 @@ virtual void dump_with_types(ostream&,int) = 0;
 Symbol get_filename() { return filename; }            \
 Symbol get_name() { return name; }                    \
 Symbol get_parent() { return parent; }                \
-Features get_features() { return features; }          \
-void dump_with_types(ostream&,int);                    
+Features& get_features() { return features; }         \
+void dump_with_types(ostream&,int);                   \
+void flatten(FlatBuilder&);
 
 
 #define Feature_EXTRAS                                \
@@ -80,20 +88,21 @@ virtual void dump_with_types(ostream&,int) = 0;
 
 
 #define Feature_SHARED_EXTRAS                                       \
-void dump_with_types(ostream&,int);    
+void dump_with_types(ostream&,int);                                 \
+void flatten(FlatBuilder&);
 
 #define method_EXTRAS                                               \
 Symbol get_name() { return name; }                                  \
 Formals get_formals() { return formals; }                           \
 Symbol get_return_type() { return return_type; }                    \
-Expression get_expr() { return expr; }                              \
+Expression& get_expr() { return expr; }                             \
 bool is_method() { return true; }                                   \
 bool is_attr() { return false; }
 
 #define attr_EXTRAS                                                 \
 Symbol get_name() { return name; }                                  \
 Symbol get_type_decl() { return type_decl; }                        \
-Expression get_init() { return init; }                              \
+Expression& get_init() { return init; }                             \
 bool is_method() { return false; }                                  \
 bool is_attr() { return true; }
 
@@ -109,106 +118,46 @@ virtual void dump_with_types(ostream&,int) = 0;
 #define formal_EXTRAS                           \
 Symbol get_name() { return name; }              \
 Symbol get_type_decl() { return type_decl; }    \
-void dump_with_types(ostream&,int);
+void dump_with_types(ostream&,int);             \
+void flatten(FlatBuilder&);
 
 
 #define Case_EXTRAS                             \
 virtual Symbol get_name() = 0;                  \
 virtual Symbol get_type_decl() = 0;             \
-virtual Expression get_expr() = 0;              \
-virtual void dump_with_types(ostream& ,int) = 0; 
+virtual Expression& get_expr() = 0;             \
+virtual void dump_with_types(ostream& ,int) = 0; \
+virtual Expression dump_head(ostream&, int) = 0; \
+virtual Expression dump_with_types_head(ostream&, int) = 0;
 
 
 #define branch_EXTRAS                                   \
 Symbol get_name() { return name; }                      \
 Symbol get_type_decl() { return type_decl; }            \
-Expression get_expr() { return expr; }                  \
-void dump_with_types(ostream& ,int);
+Expression& get_expr() { return expr; }                 \
+void dump_with_types(ostream& ,int);                    \
+Expression dump_head(ostream&, int);                    \
+Expression dump_with_types_head(ostream&, int);                 \
+void flatten(FlatBuilder&);
 
 
 #define Expression_EXTRAS                    \
 Symbol type;                                 \
 Symbol get_type() { return type; }           \
-Expression set_type(Symbol s) { type = s; return this; } \
-virtual Symbol type_check(ClassTable *classtable, Class_ current_class, \
-                          SymbolTable<Symbol, Symbol> *object_env) = 0; \
-virtual void dump_with_types(ostream&,int) = 0;  \
+Expression set_type(Symbol s)               \
+  { if (type == s) return this;             \
+    Expression e = is_shared() ? copy_Expression() : this; \
+    e->type = s; return e; }                \
+Symbol type_check(ClassTable *classtable, Class_ current_class, \
+                  SymbolTable<Symbol, Symbol> *object_env); \
+void dump_with_types(ostream&,int);          \
 void dump_type(ostream&, int);               \
 Expression_class() { type = (Symbol) NULL; }
 
 #define Expression_SHARED_EXTRAS           \
-void dump_with_types(ostream&,int); 
-
-#define assign_EXTRAS                                              \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define static_dispatch_EXTRAS                                     \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define dispatch_EXTRAS                                            \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define cond_EXTRAS                                                \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define loop_EXTRAS                                                \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define typcase_EXTRAS                                             \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define block_EXTRAS                                               \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define let_EXTRAS                                                 \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define plus_EXTRAS                                                \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define sub_EXTRAS                                                 \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define mul_EXTRAS                                                 \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define divide_EXTRAS                                              \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define neg_EXTRAS                                                 \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define lt_EXTRAS                                                  \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define eq_EXTRAS                                                  \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define leq_EXTRAS                                                 \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define comp_EXTRAS                                                \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define int_const_EXTRAS                                           \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define bool_const_EXTRAS                                          \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define string_const_EXTRAS                                        \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define new__EXTRAS                                                \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define isvoid_EXTRAS                                              \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define no_expr_EXTRAS                                             \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
-
-#define object_EXTRAS                                              \
-Symbol type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *);
+void type_check_step(TypeCheck&, int);     \
+void dump_step(ostream&, int, int, ExpressionWalk&); \
+void dump_with_types_step(ostream&, int, int, ExpressionWalk&); \
+void flatten(FlatBuilder&);
 
 #endif
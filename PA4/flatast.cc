@@ -0,0 +1,547 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  flatast.cc
+//
+//  Flattens the AST into a FlatAst, builds it again, and dumps it in its
+//  flat form (see flatast.h).
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include "flatast.h"
+#include "treewalk.h"
+
+extern int node_lineno;
+
+const uint32_t FlatAst::none;
+
+const char *const FlatAst::layout[NODE_KIND_COUNT] = {
+  "l",          // program
+  "sstL",       // class_: name, parent, filename, features
+  "slse",       // method
+  "sse",        // attr
+  "ss",         // formal
+  "sse",        // branch
+  "se",         // assign
+  "essL",       // static_dispatch: expr, type_name, name, actual
+  "esL",        // dispatch
+  "eee",        // cond
+  "ee",         // loop
+  "el",         // typcase
+  "l",          // block
+  "ssee",       // let
+  "ee", "ee", "ee", "ee",       // plus, sub, mul, divide
+  "e",          // neg
+  "ee", "ee", "ee",             // lt, eq, leq
+  "e",          // comp
+  "i",          // int_const
+  "b",          // bool_const
+  "t",          // string_const
+  "s",          // new_
+  "e",          // isvoid
+  "",           // no_expr
+  "s",          // object
+  ""            // list: shape, length, elements
+};
+
+const char *const FlatAst::name[NODE_KIND_COUNT] = {
+  "_program", "_class", "_method", "_attr", "_formal", "_branch",
+  "_assign", "_static_dispatch", "_dispatch", "_cond", "_loop",
+  "_typcase", "_block", "_let", "_plus", "_sub", "_mul", "_divide",
+  "_neg", "_lt", "_eq", "_leq", "_comp", "_int", "_bool", "_string",
+  "_new", "_isvoid", "_no_expr", "_object",
+  "list"
+};
+
+FlatAst::FlatAst(Program p)
+{
+  FlatBuilder(*this).run(p);
+}
+
+Symbol FlatAst::symbol(Id n, int i) const
+{
+  uint32_t x = operand(n, i);
+  if (x == none)
+    return NULL;
+  switch (layout[kind[n]][i]) {
+  case 'i': return inttable.lookup(x);
+  case 't': return stringtable.lookup(x);
+  default:  return idtable.lookup(x);
+  }
+}
+
+Symbol FlatAst::type_of(Id n) const
+{
+  return type[n] == none ? NULL : idtable.lookup(type[n]);
+}
+
+size_t FlatAst::bytes() const
+{
+  return kind.capacity() * sizeof(uint8_t)
+    + (line.capacity() + type.capacity() + first.capacity()
+       + operands.capacity()) * sizeof(uint32_t);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  Flattening
+//
+//  run() takes the pending nodes off a stack, last pushed first, and has
+//  each flatten itself, which pushes its children.  The children are
+//  turned around once pushed, so the first is flattened first and the
+//  nodes are numbered in the order of a depth-first walk.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+void FlatBuilder::run(Program p)
+{
+  Pending root = { p, &flatten_node, FlatAst::none };
+  pending.push_back(root);
+  while (!pending.empty()) {
+    Pending next = pending.back();
+    pending.pop_back();
+    if (next.slot != FlatAst::none)
+      ast.operands[next.slot] = ast.size();
+    size_t mark = pending.size();
+    next.flatten(next.node, *this);
+    std::reverse(pending.begin() + mark, pending.end());
+  }
+}
+
+void FlatBuilder::later(tree_node *t, Flatten f)
+{
+  Pending p = { t, f, (uint32_t) ast.operands.size() };
+  operand(FlatAst::none);
+  pending.push_back(p);
+}
+
+void FlatBuilder::flatten_node(tree_node *t, FlatBuilder& b)
+{
+  visit_node(t, [&](auto *x) { x->flatten(b); });
+}
+
+void FlatBuilder::node(tree_node *t)
+{
+  ast.kind.push_back(t->get_kind());
+  ast.line.push_back(t->get_line_number());
+  ast.type.push_back(FlatAst::none);
+  ast.first.push_back(ast.operands.size());
+}
+
+void FlatBuilder::expression(Expression e)
+{
+  node(e);
+  Symbol t = e->get_type();
+  if (t)
+    ast.type.back() = t->get_index();
+}
+
+void program_class::flatten(FlatBuilder& b)
+{
+  b.node(this);
+  b.list(classes);
+}
+
+void class__class::flatten(FlatBuilder& b)
+{
+  b.node(this);
+  b.symbol(name);
+  b.symbol(parent);
+  b.symbol(filename);
+  b.list(features);
+}
+
+void method_class::flatten(FlatBuilder& b)
+{
+  b.node(this);
+  b.symbol(name);
+  b.list(formals);
+  b.symbol(return_type);
+  b.child(expr);
+}
+
+void attr_class::flatten(FlatBuilder& b)
+{
+  b.node(this);
+  b.symbol(name);
+  b.symbol(type_decl);
+  b.child(init);
+}
+
+void formal_class::flatten(FlatBuilder& b)
+{
+  b.node(this);
+  b.symbol(name);
+  b.symbol(type_decl);
+}
+
+void branch_class::flatten(FlatBuilder& b)
+{
+  b.node(this);
+  b.symbol(name);
+  b.symbol(type_decl);
+  b.child(expr);
+}
+
+void assign_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.symbol(name);
+  b.child(expr);
+}
+
+void static_dispatch_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.child(expr);
+  b.symbol(type_name);
+  b.symbol(name);
+  b.list(actual);
+}
+
+void dispatch_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.child(expr);
+  b.symbol(name);
+  b.list(actual);
+}
+
+void cond_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.child(pred);
+  b.child(then_exp);
+  b.child(else_exp);
+}
+
+void loop_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.child(pred);
+  b.child(body);
+}
+
+void typcase_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.child(expr);
+  b.list(cases);
+}
+
+void block_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.list(body);
+}
+
+void let_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.symbol(identifier);
+  b.symbol(type_decl);
+  b.child(init);
+  b.child(body);
+}
+
+void plus_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.child(e1);
+  b.child(e2);
+}
+
+void sub_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.child(e1);
+  b.child(e2);
+}
+
+void mul_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.child(e1);
+  b.child(e2);
+}
+
+void divide_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.child(e1);
+  b.child(e2);
+}
+
+void neg_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.child(e1);
+}
+
+void lt_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.child(e1);
+  b.child(e2);
+}
+
+void eq_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.child(e1);
+  b.child(e2);
+}
+
+void leq_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.child(e1);
+  b.child(e2);
+}
+
+void comp_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.child(e1);
+}
+
+void int_const_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.symbol(token);
+}
+
+void bool_const_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.boolean(val);
+}
+
+void string_const_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.symbol(token);
+}
+
+void new__class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.symbol(type_name);
+}
+
+void isvoid_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.child(e1);
+}
+
+void no_expr_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+}
+
+void object_class::flatten(FlatBuilder& b)
+{
+  b.expression(this);
+  b.symbol(name);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  Building the tree
+//
+//  As the children of a node come after it, the nodes are built from the
+//  last to the first, and the children of each are there by the time it
+//  is.  A list is built along with the node it belongs to, which knows
+//  what kind of list it is.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+class TreeBuilder {
+  const FlatAst& ast;
+  std::vector<tree_node *> built;
+public:
+  TreeBuilder(const FlatAst& a) : ast(a), built(a.size(), NULL) { }
+
+  tree_node *run();
+  tree_node *build(FlatAst::Id n);
+
+  Expression e(FlatAst::Id n, int i)
+    { return (Expression) built[ast.child(n, i)]; }
+  Symbol s(FlatAst::Id n, int i) { return ast.symbol(n, i); }
+
+  template <class Elem>
+  list_node<Elem> *list(FlatAst::Id n, int i)
+  {
+    FlatAst::Id l = ast.child(n, i);
+    std::vector<Elem> elems(ast.len(l));
+    for (int k = 0; k < ast.len(l); k++)
+      elems[k] = (Elem) built[ast.nth(l, k)];
+    node_lineno = ast.line[l];
+    list_node<Elem> *result = list_node<Elem>::make(
+      (typename list_node<Elem>::Shape) ast.operand(l, 0), elems);
+    node_lineno = ast.line[n];
+    return result;
+  }
+};
+
+tree_node *TreeBuilder::run()
+{
+  int lineno = node_lineno;
+  for (FlatAst::Id n = ast.size(); n-- > 0; ) {
+    node_lineno = ast.line[n];
+    built[n] = build(n);
+    if (is_expression_kind(ast.kind[n]))
+      built[n] = ((Expression) built[n])->set_type(ast.type_of(n));
+  }
+  node_lineno = lineno;
+  return built.empty() ? NULL : built[0];
+}
+
+tree_node *TreeBuilder::build(FlatAst::Id n)
+{
+  switch (ast.kind[n]) {
+  case NODE_program:
+    return program(list<Class_>(n, 0));
+  case NODE_class_:
+    return class_(s(n, 0), s(n, 1), list<Feature>(n, 3), s(n, 2));
+  case NODE_method:
+    return method(s(n, 0), list<Formal>(n, 1), s(n, 2), e(n, 3));
+  case NODE_attr:
+    return attr(s(n, 0), s(n, 1), e(n, 2));
+  case NODE_formal:
+    return formal(s(n, 0), s(n, 1));
+  case NODE_branch:
+    return branch(s(n, 0), s(n, 1), e(n, 2));
+  case NODE_assign:
+    return assign(s(n, 0), e(n, 1));
+  case NODE_static_dispatch:
+    return static_dispatch(e(n, 0), s(n, 1), s(n, 2),
+                           list<Expression>(n, 3));
+  case NODE_dispatch:
+    return dispatch(e(n, 0), s(n, 1), list<Expression>(n, 2));
+  case NODE_cond:
+    return cond(e(n, 0), e(n, 1), e(n, 2));
+  case NODE_loop:
+    return loop(e(n, 0), e(n, 1));
+  case NODE_typcase:
+    return typcase(e(n, 0), list<Case>(n, 1));
+  case NODE_block:
+    return block(list<Expression>(n, 0));
+  case NODE_let:
+    return let(s(n, 0), s(n, 1), e(n, 2), e(n, 3));
+  case NODE_plus:   return plus(e(n, 0), e(n, 1));
+  case NODE_sub:    return sub(e(n, 0), e(n, 1));
+  case NODE_mul:    return mul(e(n, 0), e(n, 1));
+  case NODE_divide: return divide(e(n, 0), e(n, 1));
+  case NODE_neg:    return neg(e(n, 0));
+  case NODE_lt:     return lt(e(n, 0), e(n, 1));
+  case NODE_eq:     return eq(e(n, 0), e(n, 1));
+  case NODE_leq:    return leq(e(n, 0), e(n, 1));
+  case NODE_comp:   return comp(e(n, 0));
+  case NODE_int_const:
+    return int_const(s(n, 0));
+  case NODE_bool_const:
+    return bool_const(ast.operand(n, 0) != 0);
+  case NODE_string_const:
+    return string_const(s(n, 0));
+  case NODE_new_:
+    return new_(s(n, 0));
+  case NODE_isvoid:
+    return isvoid(e(n, 0));
+  case NODE_no_expr:
+    return no_expr();
+  case NODE_object:
+    return object(s(n, 0));
+  default:
+    return NULL;                // a list; see list()
+  }
+}
+
+}
+
+Program FlatAst::to_tree() const
+{
+  return (Program) TreeBuilder(*this).run();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  dump_with_types
+//
+//  Prints the program exactly as Program_class::dump_with_types does,
+//  going by the layout of each kind of node.  A step of the walk is a
+//  node and where it has got to: at stage 2i it dumps operand i, at
+//  stage 2i+1 it has finished the children of operand i and closes its
+//  parentheses, if any.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+void FlatAst::dump_with_types(ostream& stream, int n) const
+{
+  if (size() == 0)
+    return;
+  WalkStack<Id> walk;
+  walk.push(0, 0, n);
+  WalkStep<Id> s;
+  while (walk.pop(s)) {
+    Id node = s.node;
+    const char *ops = layout[kind[node]];
+    int stage = s.stage;
+    n = s.n;
+    if (stage == 0) {
+      stream << pad(n) << "#" << line[node] << "\n";
+      stream << pad(n) << name[kind[node]] << "\n";
+    }
+    for (;; stage++) {
+      int i = stage / 2;
+      if (ops[i] == '\0') {
+        if (is_expression_kind(kind[node])) {
+          Symbol t = type_of(node);
+          if (t)
+            stream << pad(n) << ": " << t << endl;
+          else
+            stream << pad(n) << ": _no_type" << endl;
+        }
+        break;
+      }
+      if (stage % 2 == 1) {
+        if (ops[i] == 'L')
+          stream << pad(n+2) << ")\n";
+        continue;
+      }
+      if (ops[i] == 's' || ops[i] == 'i') {
+        dump_Symbol(stream, n+2, symbol(node, i));
+        stage++;
+      } else if (ops[i] == 't') {
+        stream << pad(n+2) << "\"";
+        ((StringEntryP) symbol(node, i))->print_escaped(stream);
+        stream << "\"\n";
+        stage++;
+      } else if (ops[i] == 'b') {
+        stream << pad(n+2) << operand(node, i) << "\n";
+        stage++;
+      } else if (ops[i] == 'e') {
+        walk.push(node, stage + 1, n);
+        walk.push(child(node, i), 0, n+2);
+        break;
+      } else {
+        Id l = child(node, i);
+        if (ops[i] == 'L')
+          stream << pad(n+2) << "(\n";
+        walk.push(node, stage + 1, n);
+        for (int k = len(l) - 1; k >= 0; k--)
+          walk.push(nth(l, k), 0, n+2);
+        break;
+      }
+    }
+  }
+}
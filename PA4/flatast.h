@@ -0,0 +1,144 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _FLATAST_H_
+#define _FLATAST_H_
+
+#include <stdint.h>
+#include <vector>
+#include "cool-tree.h"
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  Flat ASTs
+//
+//  A FlatAst holds a whole program as a handful of parallel arrays
+//  instead of a tree of nodes, one entry per node:
+//
+//      kind[n]      what node n is, its NodeKind (one byte)
+//      line[n]      its line number
+//      type[n]      the index in idtable of its type, for an expression
+//      first[n]     where its operands start in operands
+//
+//  A node is named by its 32-bit index, its Id.  Its operands, in the
+//  order dump_with_types prints them, are described for each kind by
+//  a string in FlatAst::layout, one letter per operand:
+//
+//      e     a child node (its Id)
+//      l     a list, without parentheses in the dump
+//      L     a list, in parentheses in the dump
+//      s     a symbol of idtable (its index there)
+//      i     a symbol of inttable
+//      t     a symbol of stringtable
+//      b     a Boolean
+//
+//  A list is a node of its own, NODE_list, whose operands are its
+//  shape (see tree.h), its length, and the Ids of its elements.  A
+//  symbol that is NULL, like the type of an expression that has not
+//  been checked, is FlatAst::none.
+//
+//  The nodes are numbered in the order the tree is walked in, so the
+//  children of a node come after it, and a pass over the program is a
+//  pass along the arrays.  A node takes 13 bytes and 4 per operand,
+//  against a pointer to it, a vtable pointer, and 8 bytes a field for
+//  the node classes.
+//
+//      FlatAst(p)           flatten program p
+//      to_tree()            build the program again out of nodes
+//      dump_with_types()    print the program as its nodes would
+//
+//  Neither conversion calls itself on the children of a node; like
+//  the traversals of the tree (see walkstack.h), they go as deep as
+//  the program does without the native stack doing so.
+//
+//  No phase runs on a FlatAst yet; semant still checks the node
+//  classes.
+//
+/////////////////////////////////////////////////////////////////////////
+
+class FlatAst {
+public:
+  typedef uint32_t Id;
+  static const uint32_t none = 0xffffffff;
+
+  static const char *const layout[NODE_KIND_COUNT];
+  static const char *const name[NODE_KIND_COUNT];   // as dumped
+
+  std::vector<uint8_t> kind;
+  std::vector<uint32_t> line;
+  std::vector<uint32_t> type;
+  std::vector<uint32_t> first;
+  std::vector<uint32_t> operands;
+
+  FlatAst() { }
+  FlatAst(Program p);
+
+  Id size() const               { return (Id) kind.size(); }
+
+  uint32_t operand(Id n, int i) const { return operands[first[n] + i]; }
+  Id child(Id n, int i) const   { return operand(n, i); }
+  Symbol symbol(Id n, int i) const;     // operand i, an s, i or t
+  Symbol type_of(Id n) const;
+
+  // the elements of list l
+  int len(Id l) const           { return (int) operand(l, 1); }
+  Id nth(Id l, int i) const     { return operand(l, 2 + i); }
+
+  Program to_tree() const;
+  void dump_with_types(ostream& stream, int n) const;
+
+  size_t bytes() const;         // the size of the arrays
+};
+
+//
+// FlatBuilder flattens a program into a FlatAst.  Each node class has a
+// flatten method, reached by a switch on the node's kind (treewalk.h),
+// which adds the node, with node() or expression(), and then its
+// operands in the order of its layout; a child or list is only given a
+// place among the operands, and flattened after the node is done.
+//
+class FlatBuilder {
+private:
+  typedef void (*Flatten)(tree_node *, FlatBuilder&);
+  struct Pending {
+    tree_node *node;
+    Flatten flatten;
+    uint32_t slot;              // the operand to get its Id
+  };
+  FlatAst& ast;
+  std::vector<Pending> pending;
+
+  static void flatten_node(tree_node *t, FlatBuilder& b);
+
+  template <class Elem>
+  static void flatten_list(tree_node *t, FlatBuilder& b)
+  {
+    list_node<Elem> *l = static_cast<list_node<Elem> *>(t);
+    b.node(l);
+    b.operand(l->get_shape());
+    b.operand(l->len());
+    for (int i = 0; i < l->len(); i++)
+      b.child(l->nth(i));
+  }
+
+  void later(tree_node *t, Flatten f);
+public:
+  FlatBuilder(FlatAst& a) : ast(a) { }
+  void run(Program p);
+
+  void node(tree_node *t);
+  void expression(Expression e);
+  void operand(uint32_t x)     { ast.operands.push_back(x); }
+  void symbol(Symbol s)
+    { operand(s ? (uint32_t) s->get_index() : FlatAst::none); }
+  void boolean(Boolean b)      { operand(b ? 1 : 0); }
+
+  void child(tree_node *t)     { later(t, &flatten_node); }
+  template <class Elem>
+  void list(list_node<Elem> *l) { later(l, &flatten_list<Elem>); }
+};
+
+#endif
@@ -11,6 +11,8 @@ char *curr_filename;
 void handle_flags(int argc, char *argv[]);
 
 int main(int argc, char *argv[]) {
+  NodeArena arena;              // the nodes of this compilation
+  NodeArena::Use use(&arena);
   handle_flags(argc,argv);
   ast_yyparse();
   ast_root->semant();
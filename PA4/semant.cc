@@ -5,6 +5,7 @@
 #include <stdarg.h>
 #include <set>
 #include "semant.h"
+#include "treewalk.h"
 #include "utilities.h"
 
 
@@ -17,76 +18,59 @@ extern char *curr_filename;
 //
 // For convenience, a large number of symbols are predefined here.
 // These symbols include the primitive type and method names, as well
-// as fixed names used by the runtime system.
+// as fixed names used by the runtime system.  idtable holds them at
+// fixed indices from the start (see PredefSymbol in stringtab.h), so
+// these are plain array loads; nothing is hashed or interned.
 //
 //////////////////////////////////////////////////////////////////////
 static Symbol 
-    arg,
-    arg2,
-    Bool,
-    concat,
-    cool_abort,
-    copy,
-    Int,
-    in_int,
-    in_string,
-    IO,
-    length,
-    Main,
-    main_meth,
-    No_class,
-    No_type,
-    Object,
-    out_int,
-    out_string,
-    prim_slot,
-    self,
-    SELF_TYPE,
-    Str,
-    str_field,
-    substr,
-    type_name,
-    val;
-//
-// Initializing the predefined symbols.
-//
-static void initialize_constants(void)
-{
-    arg         = idtable.add_string("arg");
-    arg2        = idtable.add_string("arg2");
-    Bool        = idtable.add_string("Bool");
-    concat      = idtable.add_string("concat");
-    cool_abort  = idtable.add_string("abort");
-    copy        = idtable.add_string("copy");
-    Int         = idtable.add_string("Int");
-    in_int      = idtable.add_string("in_int");
-    in_string   = idtable.add_string("in_string");
-    IO          = idtable.add_string("IO");
-    length      = idtable.add_string("length");
-    Main        = idtable.add_string("Main");
-    main_meth   = idtable.add_string("main");
+    arg         = predef_symbol(PREDEF_arg),
+    arg2        = predef_symbol(PREDEF_arg2),
+    Bool        = predef_symbol(PREDEF_Bool),
+    concat      = predef_symbol(PREDEF_concat),
+    cool_abort  = predef_symbol(PREDEF_cool_abort),
+    copy        = predef_symbol(PREDEF_copy),
+    Int         = predef_symbol(PREDEF_Int),
+    in_int      = predef_symbol(PREDEF_in_int),
+    in_string   = predef_symbol(PREDEF_in_string),
+    IO          = predef_symbol(PREDEF_IO),
+    length      = predef_symbol(PREDEF_length),
+    Main        = predef_symbol(PREDEF_Main),
+    main_meth   = predef_symbol(PREDEF_main_meth),
     //   _no_class is a symbol that can't be the name of any 
     //   user-defined class.
-    No_class    = idtable.add_string("_no_class");
-    No_type     = idtable.add_string("_no_type");
-    Object      = idtable.add_string("Object");
-    out_int     = idtable.add_string("out_int");
-    out_string  = idtable.add_string("out_string");
-    prim_slot   = idtable.add_string("_prim_slot");
-    self        = idtable.add_string("self");
-    SELF_TYPE   = idtable.add_string("SELF_TYPE");
-    Str         = idtable.add_string("String");
-    str_field   = idtable.add_string("_str_field");
-    substr      = idtable.add_string("substr");
-    type_name   = idtable.add_string("type_name");
-    val         = idtable.add_string("_val");
+    No_class    = predef_symbol(PREDEF_No_class),
+    No_type     = predef_symbol(PREDEF_No_type),
+    Object      = predef_symbol(PREDEF_Object),
+    out_int     = predef_symbol(PREDEF_out_int),
+    out_string  = predef_symbol(PREDEF_out_string),
+    prim_slot   = predef_symbol(PREDEF_prim_slot),
+    self        = predef_symbol(PREDEF_self),
+    SELF_TYPE   = predef_symbol(PREDEF_SELF_TYPE),
+    Str         = predef_symbol(PREDEF_Str),
+    str_field   = predef_symbol(PREDEF_str_field),
+    substr      = predef_symbol(PREDEF_substr),
+    type_name   = predef_symbol(PREDEF_type_name),
+    val         = predef_symbol(PREDEF_val);
+
+//
+// Int, Bool and String are compared by value and cannot be inherited
+// from.
+//
+static bool is_basic_value_type(Symbol type) {
+    switch (predef_id(type)) {
+    case PREDEF_Int:
+    case PREDEF_Bool:
+    case PREDEF_Str:
+        return true;
+    default:
+        return false;
+    }
 }
 
 
 
 ClassTable::ClassTable(Classes classes) : semant_errors_(0) , error_stream_(cerr) {
-    class_table_ = new SymbolTable<Symbol, Class_>;
-    class_table_->enterscope();
     install_basic_classes();
     build_inheritance_graph(classes);
     check_inheritance(classes);
@@ -126,7 +110,7 @@ void ClassTable::install_basic_classes() {
 					       single_Features(method(type_name, nil_Formals(), Str, no_expr()))),
 			       single_Features(method(copy, nil_Formals(), SELF_TYPE, no_expr()))),
 	       filename);
-    class_table_->addid(Object, &Object_class_);
+    class_table_.insert(Object, Object_class_);
 
     // 
     // The IO class inherits from Object. Its methods are
@@ -148,7 +132,7 @@ void ClassTable::install_basic_classes() {
 					       single_Features(method(in_string, nil_Formals(), Str, no_expr()))),
 			       single_Features(method(in_int, nil_Formals(), Int, no_expr()))),
 	       filename);  
-    class_table_->addid(IO, &IO_class_);
+    class_table_.insert(IO, IO_class_);
 
     //
     // The Int class has no methods and only a single attribute, the
@@ -159,14 +143,14 @@ void ClassTable::install_basic_classes() {
 	       Object,
 	       single_Features(attr(val, prim_slot, no_expr())),
 	       filename);
-    class_table_->addid(Int, &Int_class_);
+    class_table_.insert(Int, Int_class_);
 
     //
     // Bool also has only the "val" slot.
     //
     Bool_class_ =
 	class_(Bool, Object, single_Features(attr(val, prim_slot, no_expr())),filename);
-    class_table_->addid(Bool, &Bool_class_);
+    class_table_.insert(Bool, Bool_class_);
 
     //
     // The class Str has a number of slots and operations:
@@ -196,7 +180,7 @@ void ClassTable::install_basic_classes() {
 						      Str, 
 						      no_expr()))),
 	       filename);
-    class_table_->addid(Str, &Str_class_);
+    class_table_.insert(Str, Str_class_);
 }
 
 void ClassTable::build_inheritance_graph(Classes classes) {
@@ -208,12 +192,11 @@ void ClassTable::build_inheritance_graph(Classes classes) {
             semant_error(c) << "Class name cannot be SELF_TYPE." << endl;
             continue;
         }
-        if (class_table_->probe(name) != NULL) {
+        if (class_table_.contains(name)) {
             semant_error(c) << "Redefinition of class " << name << endl;
             continue;
         }
-        Class_ *class_ptr = new Class_(c);
-        class_table_->addid(name, class_ptr);
+        class_table_.insert(name, c);
     }
 }
 
@@ -229,7 +212,7 @@ void ClassTable::check_class_inheritance(Class_ c) {
     Symbol name = c->get_name();
     Symbol parent = c->get_parent();
 
-    if (parent == SELF_TYPE || parent == Int || parent == Bool || parent == Str) {
+    if (parent == SELF_TYPE || is_basic_value_type(parent)) {
         semant_error(c) << "Class " << name << " cannot inherit class "
                         << parent << "." << endl;
         return;
@@ -432,7 +415,7 @@ method_class *ClassTable::lookup_method(Symbol class_name, Symbol method_name) {
 }
 
 Class_ ClassTable::lookup_class(Symbol class_name) {
-    Class_ *found = class_table_->lookup(class_name);
+    Class_ *found = class_table_.find(class_name);
     if (found == NULL) {
         return NULL;
     }
@@ -450,7 +433,7 @@ void ClassTable::check_features(Classes classes) {
 void ClassTable::check_class_features(Class_ c) {
     std::set<Symbol> attr_names;
     std::set<Symbol> method_names;
-    Features features = c->get_features();
+    Features features = own(c->get_features());
     for (int i = features->first(); features->more(i); i = features->next(i)) {
         Feature feature = features->nth(i);
         if (feature->is_attr()) {
@@ -554,7 +537,7 @@ void ClassTable::check_class_features(Class_ c) {
     }
 
     for (int i = features->first(); features->more(i); i = features->next(i)) {
-        Feature feature = features->nth(i);
+        Feature feature = features->own_nth(i);
         if (feature->is_attr()) {
             attr_class *attr = static_cast<attr_class*>(feature);
             Symbol name = attr->get_name();
@@ -565,7 +548,7 @@ void ClassTable::check_class_features(Class_ c) {
             if (object_env.lookup(name) == NULL) {
                 object_env.addid(name, new Symbol(type_decl));
             }
-            Expression init = attr->get_init();
+            Expression init = own(attr->get_init());
             Symbol init_type = init->type_check(this, c, &object_env);
             if (!is_subtype(init_type, type_decl, c)) {
                 semant_error(c) << "Inferred type " << init_type
@@ -584,7 +567,7 @@ void ClassTable::check_class_features(Class_ c) {
                 Symbol formal_type = formal->get_type_decl();
                 object_env.addid(formal_name, new Symbol(formal_type));
             }
-            Symbol body_type = method->get_expr()->type_check(this, c, &object_env);
+            Symbol body_type = own(method->get_expr())->type_check(this, c, &object_env);
             if (return_type == SELF_TYPE) {
                 if (body_type != SELF_TYPE) {
                     semant_error(c) << "Inferred return type " << body_type
@@ -603,28 +586,66 @@ void ClassTable::check_class_features(Class_ c) {
     }
 }
 
-static void check_dispatch_arguments(ClassTable *classtable,
-                                     Class_ current_class,
-                                     SymbolTable<Symbol, Symbol> *object_env,
-                                     method_class *method,
-                                     Expressions actuals,
-                                     Class_ error_class,
-                                     tree_node *error_node) {
+Symbol TypeCheck::run(Expression e) {
+    WalkStep<Expression> s;
+    walk.push(e);
+    while (walk.pop(s)) {
+        visit_expression(s.node, [&](auto *x) {
+            x->type_check_step(*this, s.stage);
+        });
+    }
+    return pop_type();
+}
+
+void TypeCheck::check_list(Expressions& l) {
+    own(l);
+    for (int i = l->first(); l->more(i); i = l->next(i)) {
+        l->own_nth(i);
+    }
+    walk.push_list(l);
+}
+
+Symbol Expression_class::type_check(ClassTable *classtable, Class_ current_class,
+                                    SymbolTable<Symbol, Symbol> *object_env) {
+    TypeCheck tc(classtable, current_class, object_env);
+    return tc.run(this);
+}
+
+// Look up the method a dispatch calls and push it on tc.methods, for
+// check_dispatch_arguments.  Returns NULL if there is no such method.
+static method_class *find_dispatch_method(TypeCheck &tc, Expression e,
+                                          Symbol dispatch_type, Symbol name) {
+    method_class *method = tc.classtable->lookup_method(dispatch_type, name);
+    if (method == NULL) {
+        tc.semant_error(e) << "Dispatch to undefined method " << name << "." << endl;
+        return NULL;
+    }
+    tc.methods.push_back(method);
+    return method;
+}
+
+// The actuals of a dispatch to the method on top of tc.methods are
+// checked one a stage, from stage `first': each stage checks the type of
+// the actual before against its formal and then starts on the next.
+// Returns true once there are none left, or none to check because there
+// are not as many as the method has formals.
+static bool check_dispatch_arguments(TypeCheck &tc, Expression e,
+                                     Expressions& actuals, int first, int stage) {
+    method_class *method = tc.methods.back();
     Formals formals = method->get_formals();
-    if (actuals->len() != formals->len()) {
-        classtable->semant_error(error_class->get_filename(), error_node)
+    int i = stage - first;
+    if (i == 0 && actuals->len() != formals->len()) {
+        tc.semant_error(e)
             << "Method " << method->get_name()
             << " called with wrong number of arguments." << endl;
-        return;
+        return true;
     }
-    int len = formals->len();
-    for (int i = 0; i < len; i++) {
-        Expression actual = actuals->nth(i);
-        Formal formal = formals->nth(i);
-        Symbol actual_type = actual->type_check(classtable, current_class, object_env);
+    if (i > 0) {
+        Formal formal = formals->nth(i - 1);
+        Symbol actual_type = tc.pop_type();
         Symbol formal_type = formal->get_type_decl();
-        if (!classtable->is_subtype(actual_type, formal_type, current_class)) {
-            classtable->semant_error(error_class->get_filename(), error_node)
+        if (!tc.classtable->is_subtype(actual_type, formal_type, tc.current_class)) {
+            tc.semant_error(e)
                 << "In call of method " << method->get_name()
                 << ", type " << actual_type
                 << " of parameter " << formal->get_name()
@@ -632,327 +653,431 @@ static void check_dispatch_arguments(ClassTable *classtable,
                 << formal_type << "." << endl;
         }
     }
+    if (i == actuals->len()) {
+        return true;
+    }
+    tc.resume(e, stage + 1);
+    tc.check_nth(actuals, i);
+    return false;
 }
 
-Symbol assign_class::type_check(ClassTable *classtable, Class_ current_class,
-                                SymbolTable<Symbol, Symbol> *object_env) {
-    if (name == self) {
-        classtable->semant_error(current_class->get_filename(), this)
-            << "Cannot assign to 'self'." << endl;
-        return set_type(Object)->get_type();
-    }
-    Symbol *decl_type = object_env->lookup(name);
-    if (decl_type == NULL) {
-        classtable->semant_error(current_class->get_filename(), this)
-            << "Assignment to undeclared variable " << name << "." << endl;
-        return set_type(Object)->get_type();
-    }
-    Symbol expr_type = expr->type_check(classtable, current_class, object_env);
-    if (!classtable->is_subtype(expr_type, *decl_type, current_class)) {
-        classtable->semant_error(current_class->get_filename(), this)
+void assign_class::type_check_step(TypeCheck &tc, int stage) {
+    if (stage == 0) {
+        if (name == self) {
+            tc.semant_error(this) << "Cannot assign to 'self'." << endl;
+            tc.result(this, Object);
+            return;
+        }
+        if (tc.object_env->lookup(name) == NULL) {
+            tc.semant_error(this)
+                << "Assignment to undeclared variable " << name << "." << endl;
+            tc.result(this, Object);
+            return;
+        }
+        tc.resume(this, 1);
+        tc.check(expr);
+        return;
+    }
+    Symbol *decl_type = tc.object_env->lookup(name);
+    Symbol expr_type = tc.pop_type();
+    if (!tc.classtable->is_subtype(expr_type, *decl_type, tc.current_class)) {
+        tc.semant_error(this)
             << "Type " << expr_type
             << " of assigned expression does not conform to declared type "
             << *decl_type << " of identifier " << name << "." << endl;
     }
-    return set_type(expr_type)->get_type();
+    tc.result(this, expr_type);
 }
 
-Symbol static_dispatch_class::type_check(ClassTable *classtable, Class_ current_class,
-                                         SymbolTable<Symbol, Symbol> *object_env) {
-    Symbol expr_type = expr->type_check(classtable, current_class, object_env);
-    if (!classtable->is_subtype(expr_type, type_name, current_class)) {
-        classtable->semant_error(current_class->get_filename(), this)
-            << "Expression type " << expr_type
-            << " does not conform to declared static dispatch type "
-            << type_name << "." << endl;
+void static_dispatch_class::type_check_step(TypeCheck &tc, int stage) {
+    if (stage == 0) {
+        tc.resume(this, 1);
+        tc.check(expr);
+        return;
     }
-    Symbol dispatch_type = type_name;
-    if (dispatch_type == SELF_TYPE) {
-        dispatch_type = current_class->get_name();
+    if (stage == 1) {
+        Symbol expr_type = tc.pop_type();
+        if (!tc.classtable->is_subtype(expr_type, type_name, tc.current_class)) {
+            tc.semant_error(this)
+                << "Expression type " << expr_type
+                << " does not conform to declared static dispatch type "
+                << type_name << "." << endl;
+        }
+        Symbol dispatch_type = type_name;
+        if (dispatch_type == SELF_TYPE) {
+            dispatch_type = tc.current_class->get_name();
+        }
+        if (find_dispatch_method(tc, this, dispatch_type, name) == NULL) {
+            tc.result(this, Object);
+            return;
+        }
     }
-    method_class *method = classtable->lookup_method(dispatch_type, name);
-    if (method == NULL) {
-        classtable->semant_error(current_class->get_filename(), this)
-            << "Dispatch to undefined method " << name << "." << endl;
-        return set_type(Object)->get_type();
+    if (!check_dispatch_arguments(tc, this, actual, 1, stage)) {
+        return;
     }
-    check_dispatch_arguments(classtable, current_class, object_env, method, actual,
-                             current_class, this);
+    method_class *method = tc.methods.back();
+    tc.methods.pop_back();
     Symbol return_type = method->get_return_type();
     if (return_type == SELF_TYPE) {
-        return set_type(type_name)->get_type();
+        tc.result(this, type_name);
+        return;
     }
-    return set_type(return_type)->get_type();
+    tc.result(this, return_type);
 }
 
-Symbol dispatch_class::type_check(ClassTable *classtable, Class_ current_class,
-                                  SymbolTable<Symbol, Symbol> *object_env) {
-    Symbol expr_type = expr->type_check(classtable, current_class, object_env);
-    Symbol dispatch_type = expr_type;
-    if (dispatch_type == SELF_TYPE) {
-        dispatch_type = current_class->get_name();
+// The type of expr stays on the type stack under the actuals' until the
+// end, for a method that returns SELF_TYPE.
+void dispatch_class::type_check_step(TypeCheck &tc, int stage) {
+    if (stage == 0) {
+        tc.resume(this, 1);
+        tc.check(expr);
+        return;
     }
-    method_class *method = classtable->lookup_method(dispatch_type, name);
-    if (method == NULL) {
-        classtable->semant_error(current_class->get_filename(), this)
-            << "Dispatch to undefined method " << name << "." << endl;
-        return set_type(Object)->get_type();
+    if (stage == 1) {
+        Symbol expr_type = tc.pop_type();
+        Symbol dispatch_type = expr_type;
+        if (dispatch_type == SELF_TYPE) {
+            dispatch_type = tc.current_class->get_name();
+        }
+        if (find_dispatch_method(tc, this, dispatch_type, name) == NULL) {
+            tc.result(this, Object);
+            return;
+        }
+        tc.push_type(expr_type);
     }
-    check_dispatch_arguments(classtable, current_class, object_env, method, actual,
-                             current_class, this);
+    if (!check_dispatch_arguments(tc, this, actual, 1, stage)) {
+        return;
+    }
+    method_class *method = tc.methods.back();
+    tc.methods.pop_back();
+    Symbol expr_type = tc.pop_type();
     Symbol return_type = method->get_return_type();
     if (return_type == SELF_TYPE) {
-        return set_type(expr_type)->get_type();
+        tc.result(this, expr_type);
+        return;
     }
-    return set_type(return_type)->get_type();
+    tc.result(this, return_type);
 }
 
-Symbol cond_class::type_check(ClassTable *classtable, Class_ current_class,
-                              SymbolTable<Symbol, Symbol> *object_env) {
-    Symbol pred_type = pred->type_check(classtable, current_class, object_env);
-    if (pred_type != Bool) {
-        classtable->semant_error(current_class->get_filename(), this)
-            << "Predicate of 'if' does not have type Bool." << endl;
+void cond_class::type_check_step(TypeCheck &tc, int stage) {
+    if (stage == 0) {
+        tc.resume(this, 1);
+        tc.check(pred);
+        return;
+    }
+    if (stage == 1) {
+        if (tc.pop_type() != Bool) {
+            tc.semant_error(this)
+                << "Predicate of 'if' does not have type Bool." << endl;
+        }
+        tc.resume(this, 2);
+        tc.check(else_exp);
+        tc.check(then_exp);
+        return;
     }
-    Symbol then_type = then_exp->type_check(classtable, current_class, object_env);
-    Symbol else_type = else_exp->type_check(classtable, current_class, object_env);
-    return set_type(classtable->lub(then_type, else_type, current_class))->get_type();
+    Symbol else_type = tc.pop_type();
+    Symbol then_type = tc.pop_type();
+    tc.result(this, tc.classtable->lub(then_type, else_type, tc.current_class));
 }
 
-Symbol loop_class::type_check(ClassTable *classtable, Class_ current_class,
-                              SymbolTable<Symbol, Symbol> *object_env) {
-    Symbol pred_type = pred->type_check(classtable, current_class, object_env);
-    if (pred_type != Bool) {
-        classtable->semant_error(current_class->get_filename(), this)
-            << "Loop condition does not have type Bool." << endl;
+void loop_class::type_check_step(TypeCheck &tc, int stage) {
+    if (stage == 0) {
+        tc.resume(this, 1);
+        tc.check(pred);
+        return;
     }
-    body->type_check(classtable, current_class, object_env);
-    return set_type(Object)->get_type();
+    if (stage == 1) {
+        if (tc.pop_type() != Bool) {
+            tc.semant_error(this)
+                << "Loop condition does not have type Bool." << endl;
+        }
+        tc.resume(this, 2);
+        tc.check(body);
+        return;
+    }
+    tc.pop_type();
+    tc.result(this, Object);
 }
 
-Symbol typcase_class::type_check(ClassTable *classtable, Class_ current_class,
-                                 SymbolTable<Symbol, Symbol> *object_env) {
-    expr->type_check(classtable, current_class, object_env);
-    std::set<Symbol> branch_types;
-    Symbol result_type = No_type;
-    Cases cases_list = cases;
-    for (int i = cases_list->first(); cases_list->more(i); i = cases_list->next(i)) {
+// Stage 1 + i comes back from the body of the branch before branch i,
+// if there was one, and starts on the next branch with a body to check.
+// The types of the branches seen so far are on top of tc.case_types, and
+// the lub of their bodies' types on the type stack.
+void typcase_class::type_check_step(TypeCheck &tc, int stage) {
+    if (stage == 0) {
+        tc.resume(this, 1);
+        tc.check(expr);
+        return;
+    }
+    Cases cases_list = own(cases);
+    if (stage == 1) {
+        tc.pop_type();
+        tc.case_types.push_back(std::set<Symbol>());
+        tc.push_type(No_type);
+    } else {
+        Symbol body_type = tc.pop_type();
+        Symbol result_type = tc.pop_type();
+        tc.object_env->exitscope();
+        if (result_type == No_type) {
+            result_type = body_type;
+        } else {
+            result_type = tc.classtable->lub(result_type, body_type, tc.current_class);
+        }
+        tc.push_type(result_type);
+    }
+    std::set<Symbol> &branch_types = tc.case_types.back();
+    for (int i = stage - 1; cases_list->more(i); i = cases_list->next(i)) {
         Case branch = cases_list->nth(i);
         Symbol branch_type = branch->get_type_decl();
         if (branch_type == SELF_TYPE) {
-            classtable->semant_error(current_class->get_filename(), this)
+            tc.semant_error(this)
                 << "Case branch type cannot be SELF_TYPE." << endl;
             continue;
         }
         if (branch_types.count(branch_type) != 0) {
-            classtable->semant_error(current_class->get_filename(), this)
+            tc.semant_error(this)
                 << "Duplicate branch " << branch_type
                 << " in case statement." << endl;
         }
         branch_types.insert(branch_type);
-        if (classtable->lookup_class(branch_type) == NULL) {
-            classtable->semant_error(current_class->get_filename(), this)
+        if (tc.classtable->lookup_class(branch_type) == NULL) {
+            tc.semant_error(this)
                 << "Case branch type " << branch_type
                 << " is undefined." << endl;
         }
-        object_env->enterscope();
-        object_env->addid(branch->get_name(), new Symbol(branch_type));
-        Symbol body_type = branch->get_expr()->type_check(classtable, current_class, object_env);
-        object_env->exitscope();
-        if (result_type == No_type) {
-            result_type = body_type;
-        } else {
-            result_type = classtable->lub(result_type, body_type, current_class);
-        }
+        tc.object_env->enterscope();
+        tc.object_env->addid(branch->get_name(), new Symbol(branch_type));
+        tc.resume(this, i + 2);
+        tc.check(cases_list->own_nth(i)->get_expr());
+        return;
     }
-    return set_type(result_type)->get_type();
+    tc.case_types.pop_back();
+    tc.result(this, tc.pop_type());
 }
 
-Symbol block_class::type_check(ClassTable *classtable, Class_ current_class,
-                               SymbolTable<Symbol, Symbol> *object_env) {
+// Each of the expressions leaves its type; the block's is the last's.
+void block_class::type_check_step(TypeCheck &tc, int stage) {
+    if (stage == 0) {
+        tc.resume(this, 1);
+        tc.check_list(body);
+        return;
+    }
     Symbol last_type = No_type;
-    for (int i = body->first(); body->more(i); i = body->next(i)) {
-        Expression expr = body->nth(i);
-        last_type = expr->type_check(classtable, current_class, object_env);
-    }
-    return set_type(last_type)->get_type();
-}
-
-Symbol let_class::type_check(ClassTable *classtable, Class_ current_class,
-                             SymbolTable<Symbol, Symbol> *object_env) {
-    if (identifier == self) {
-        classtable->semant_error(current_class->get_filename(), this)
-            << "'self' cannot be bound in a 'let' expression." << endl;
-    }
-    if (type_decl == SELF_TYPE) {
-        classtable->semant_error(current_class->get_filename(), this)
-            << "'SELF_TYPE' cannot be the declared type of a 'let' identifier."
-            << endl;
-    } else if (classtable->lookup_class(type_decl) == NULL) {
-        classtable->semant_error(current_class->get_filename(), this)
-            << "Let variable " << identifier
-            << " declared with undefined type " << type_decl << "." << endl;
-    }
-    Symbol init_type = init->type_check(classtable, current_class, object_env);
-    if (!classtable->is_subtype(init_type, type_decl, current_class)) {
-        classtable->semant_error(current_class->get_filename(), this)
-            << "Inferred type " << init_type
-            << " of initialization of " << identifier
-            << " does not conform to declared type "
-            << type_decl << "." << endl;
-    }
-    object_env->enterscope();
-    object_env->addid(identifier, new Symbol(type_decl));
-    Symbol body_type = body->type_check(classtable, current_class, object_env);
-    object_env->exitscope();
-    return set_type(body_type)->get_type();
-}
-
-static Symbol arithmetic_check(Expression e1, Expression e2,
-                               ClassTable *classtable,
-                               Class_ current_class,
-                               SymbolTable<Symbol, Symbol> *object_env,
-                               tree_node *error_node,
-                               const char *op_name) {
-    Symbol t1 = e1->type_check(classtable, current_class, object_env);
-    Symbol t2 = e2->type_check(classtable, current_class, object_env);
+    for (int i = 0; i < body->len(); i++) {
+        Symbol t = tc.pop_type();
+        if (i == 0) {
+            last_type = t;
+        }
+    }
+    tc.result(this, last_type);
+}
+
+void let_class::type_check_step(TypeCheck &tc, int stage) {
+    if (stage == 0) {
+        if (identifier == self) {
+            tc.semant_error(this)
+                << "'self' cannot be bound in a 'let' expression." << endl;
+        }
+        if (type_decl == SELF_TYPE) {
+            tc.semant_error(this)
+                << "'SELF_TYPE' cannot be the declared type of a 'let' identifier."
+                << endl;
+        } else if (tc.classtable->lookup_class(type_decl) == NULL) {
+            tc.semant_error(this)
+                << "Let variable " << identifier
+                << " declared with undefined type " << type_decl << "." << endl;
+        }
+        tc.resume(this, 1);
+        tc.check(init);
+        return;
+    }
+    if (stage == 1) {
+        Symbol init_type = tc.pop_type();
+        if (!tc.classtable->is_subtype(init_type, type_decl, tc.current_class)) {
+            tc.semant_error(this)
+                << "Inferred type " << init_type
+                << " of initialization of " << identifier
+                << " does not conform to declared type "
+                << type_decl << "." << endl;
+        }
+        tc.object_env->enterscope();
+        tc.object_env->addid(identifier, new Symbol(type_decl));
+        tc.resume(this, 2);
+        tc.check(body);
+        return;
+    }
+    tc.object_env->exitscope();
+    tc.result(this, tc.pop_type());
+}
+
+// Both operands of a binary operator are checked in one stage, and come
+// back with e2's type on top.
+static void check_operands(TypeCheck &tc, Expression e,
+                           Expression& e1, Expression& e2) {
+    tc.resume(e, 1);
+    tc.check(e2);
+    tc.check(e1);
+}
+
+static void arithmetic_step(TypeCheck &tc, int stage, Expression e,
+                            Expression& e1, Expression& e2,
+                            const char *op_name) {
+    if (stage == 0) {
+        check_operands(tc, e, e1, e2);
+        return;
+    }
+    Symbol t2 = tc.pop_type();
+    Symbol t1 = tc.pop_type();
     if (t1 != Int || t2 != Int) {
-        classtable->semant_error(current_class->get_filename(), error_node)
+        tc.semant_error(e)
             << "Non-Int arguments: " << op_name << "." << endl;
     }
-    return Int;
+    tc.result(e, Int);
 }
 
-Symbol plus_class::type_check(ClassTable *classtable, Class_ current_class,
-                              SymbolTable<Symbol, Symbol> *object_env) {
-    return set_type(arithmetic_check(e1, e2, classtable, current_class,
-                                     object_env, this, "+"))->get_type();
+void plus_class::type_check_step(TypeCheck &tc, int stage) {
+    arithmetic_step(tc, stage, this, e1, e2, "+");
 }
 
-Symbol sub_class::type_check(ClassTable *classtable, Class_ current_class,
-                             SymbolTable<Symbol, Symbol> *object_env) {
-    return set_type(arithmetic_check(e1, e2, classtable, current_class,
-                                     object_env, this, "-"))->get_type();
+void sub_class::type_check_step(TypeCheck &tc, int stage) {
+    arithmetic_step(tc, stage, this, e1, e2, "-");
 }
 
-Symbol mul_class::type_check(ClassTable *classtable, Class_ current_class,
-                             SymbolTable<Symbol, Symbol> *object_env) {
-    return set_type(arithmetic_check(e1, e2, classtable, current_class,
-                                     object_env, this, "*"))->get_type();
+void mul_class::type_check_step(TypeCheck &tc, int stage) {
+    arithmetic_step(tc, stage, this, e1, e2, "*");
 }
 
-Symbol divide_class::type_check(ClassTable *classtable, Class_ current_class,
-                                SymbolTable<Symbol, Symbol> *object_env) {
-    return set_type(arithmetic_check(e1, e2, classtable, current_class,
-                                     object_env, this, "/"))->get_type();
+void divide_class::type_check_step(TypeCheck &tc, int stage) {
+    arithmetic_step(tc, stage, this, e1, e2, "/");
 }
 
-Symbol neg_class::type_check(ClassTable *classtable, Class_ current_class,
-                             SymbolTable<Symbol, Symbol> *object_env) {
-    Symbol t1 = e1->type_check(classtable, current_class, object_env);
+void neg_class::type_check_step(TypeCheck &tc, int stage) {
+    if (stage == 0) {
+        tc.resume(this, 1);
+        tc.check(e1);
+        return;
+    }
+    Symbol t1 = tc.pop_type();
     if (t1 != Int) {
-        classtable->semant_error(current_class->get_filename(), this)
+        tc.semant_error(this)
             << "Argument of '~' has type " << t1
             << " instead of Int." << endl;
     }
-    return set_type(Int)->get_type();
+    tc.result(this, Int);
 }
 
-Symbol lt_class::type_check(ClassTable *classtable, Class_ current_class,
-                            SymbolTable<Symbol, Symbol> *object_env) {
-    Symbol t1 = e1->type_check(classtable, current_class, object_env);
-    Symbol t2 = e2->type_check(classtable, current_class, object_env);
+void lt_class::type_check_step(TypeCheck &tc, int stage) {
+    if (stage == 0) {
+        check_operands(tc, this, e1, e2);
+        return;
+    }
+    Symbol t2 = tc.pop_type();
+    Symbol t1 = tc.pop_type();
     if (t1 != Int || t2 != Int) {
-        classtable->semant_error(current_class->get_filename(), this)
+        tc.semant_error(this)
             << "Non-Int arguments: <." << endl;
     }
-    return set_type(Bool)->get_type();
+    tc.result(this, Bool);
 }
 
-Symbol leq_class::type_check(ClassTable *classtable, Class_ current_class,
-                             SymbolTable<Symbol, Symbol> *object_env) {
-    Symbol t1 = e1->type_check(classtable, current_class, object_env);
-    Symbol t2 = e2->type_check(classtable, current_class, object_env);
+void leq_class::type_check_step(TypeCheck &tc, int stage) {
+    if (stage == 0) {
+        check_operands(tc, this, e1, e2);
+        return;
+    }
+    Symbol t2 = tc.pop_type();
+    Symbol t1 = tc.pop_type();
     if (t1 != Int || t2 != Int) {
-        classtable->semant_error(current_class->get_filename(), this)
+        tc.semant_error(this)
             << "Non-Int arguments: <=." << endl;
     }
-    return set_type(Bool)->get_type();
+    tc.result(this, Bool);
 }
 
-Symbol eq_class::type_check(ClassTable *classtable, Class_ current_class,
-                            SymbolTable<Symbol, Symbol> *object_env) {
-    Symbol t1 = e1->type_check(classtable, current_class, object_env);
-    Symbol t2 = e2->type_check(classtable, current_class, object_env);
-    if ((t1 == Int || t1 == Bool || t1 == Str ||
-         t2 == Int || t2 == Bool || t2 == Str) && t1 != t2) {
-        classtable->semant_error(current_class->get_filename(), this)
+void eq_class::type_check_step(TypeCheck &tc, int stage) {
+    if (stage == 0) {
+        check_operands(tc, this, e1, e2);
+        return;
+    }
+    Symbol t2 = tc.pop_type();
+    Symbol t1 = tc.pop_type();
+    if ((is_basic_value_type(t1) || is_basic_value_type(t2)) && t1 != t2) {
+        tc.semant_error(this)
             << "Illegal comparison with a basic type." << endl;
     }
-    return set_type(Bool)->get_type();
+    tc.result(this, Bool);
 }
 
-Symbol comp_class::type_check(ClassTable *classtable, Class_ current_class,
-                              SymbolTable<Symbol, Symbol> *object_env) {
-    Symbol t1 = e1->type_check(classtable, current_class, object_env);
+void comp_class::type_check_step(TypeCheck &tc, int stage) {
+    if (stage == 0) {
+        tc.resume(this, 1);
+        tc.check(e1);
+        return;
+    }
+    Symbol t1 = tc.pop_type();
     if (t1 != Bool) {
-        classtable->semant_error(current_class->get_filename(), this)
+        tc.semant_error(this)
             << "Argument of 'not' has type " << t1
             << " instead of Bool." << endl;
     }
-    return set_type(Bool)->get_type();
+    tc.result(this, Bool);
 }
 
-Symbol int_const_class::type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *) {
-    return set_type(Int)->get_type();
+void int_const_class::type_check_step(TypeCheck &tc, int) {
+    tc.result(this, Int);
 }
 
-Symbol bool_const_class::type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *) {
-    return set_type(Bool)->get_type();
+void bool_const_class::type_check_step(TypeCheck &tc, int) {
+    tc.result(this, Bool);
 }
 
-Symbol string_const_class::type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *) {
-    return set_type(Str)->get_type();
+void string_const_class::type_check_step(TypeCheck &tc, int) {
+    tc.result(this, Str);
 }
 
-Symbol new__class::type_check(ClassTable *classtable, Class_ current_class,
-                              SymbolTable<Symbol, Symbol> *) {
+void new__class::type_check_step(TypeCheck &tc, int) {
     if (type_name == SELF_TYPE) {
-        return set_type(SELF_TYPE)->get_type();
+        tc.result(this, SELF_TYPE);
+        return;
     }
-    if (classtable->lookup_class(type_name) == NULL) {
-        classtable->semant_error(current_class->get_filename(), this)
+    if (tc.classtable->lookup_class(type_name) == NULL) {
+        tc.semant_error(this)
             << "'new' used with undefined class " << type_name << "." << endl;
-        return set_type(Object)->get_type();
+        tc.result(this, Object);
+        return;
     }
-    return set_type(type_name)->get_type();
+    tc.result(this, type_name);
 }
 
-Symbol isvoid_class::type_check(ClassTable *classtable, Class_ current_class,
-                                SymbolTable<Symbol, Symbol> *object_env) {
-    e1->type_check(classtable, current_class, object_env);
-    return set_type(Bool)->get_type();
+void isvoid_class::type_check_step(TypeCheck &tc, int stage) {
+    if (stage == 0) {
+        tc.resume(this, 1);
+        tc.check(e1);
+        return;
+    }
+    tc.pop_type();
+    tc.result(this, Bool);
 }
 
-Symbol no_expr_class::type_check(ClassTable *, Class_, SymbolTable<Symbol, Symbol> *) {
-    return set_type(No_type)->get_type();
+void no_expr_class::type_check_step(TypeCheck &tc, int) {
+    tc.result(this, No_type);
 }
 
-Symbol object_class::type_check(ClassTable *classtable, Class_ current_class,
-                                SymbolTable<Symbol, Symbol> *object_env) {
+void object_class::type_check_step(TypeCheck &tc, int) {
     if (name == self) {
-        return set_type(SELF_TYPE)->get_type();
+        tc.result(this, SELF_TYPE);
+        return;
     }
-    Symbol *type = object_env->lookup(name);
+    Symbol *type = tc.object_env->lookup(name);
     if (type == NULL) {
-        classtable->semant_error(current_class->get_filename(), this)
+        tc.semant_error(this)
             << "Undeclared identifier " << name << "." << endl;
-        return set_type(Object)->get_type();
+        tc.result(this, Object);
+        return;
     }
-    return set_type(*type)->get_type();
+    tc.result(this, *type);
 }
 
-
 ////////////////////////////////////////////////////////////////////
 //
 // semant_error is an overloaded function for reporting errors
@@ -1000,9 +1125,32 @@ ostream& ClassTable::semant_error()
      errors. Part 2) can be done in a second stage, when you want
      to build mycoolc.
  */
+
+// With -s, the checked program is searched for the first expression
+// left without a type (see treewalk.h).
+class FindUntyped : public TreeVisitor {
+public:
+    Expression found;
+    FindUntyped() : found(NULL) { }
+
+    WalkAction pre(tree_node *t) {
+        if (!is_expression_kind(t->get_kind()))
+            return WALK_ON;
+        Expression e = static_cast<Expression>(t);
+        if (e->get_type() != NULL)
+            return WALK_ON;
+        found = e;
+        return WALK_STOP;
+    }
+};
+
 void program_class::semant()
 {
-    initialize_constants();
+    // Types are set on the classes' expressions in place, so the
+    // classes are made the program's own first (see own() in tree.h).
+    own(classes);
+    for (int i = classes->first(); classes->more(i); i = classes->next(i))
+        classes->own_nth(i);
 
     /* ClassTable constructor may do some semantic analysis */
     ClassTable *classtable = new ClassTable(classes);
@@ -1011,4 +1159,11 @@ void program_class::semant()
 	    cerr << "Compilation halted due to static semantic errors." << endl;
 	    exit(1);
     }
+
+    if (semant_debug) {
+        FindUntyped untyped;
+        if (!walk_tree(this, untyped))
+            cerr << "Expression at line " << untyped.found->get_line_number()
+                 << " has no type." << endl;
+    }
 }
@@ -3,9 +3,12 @@
 
 #include <assert.h>
 #include <iostream>  
+#include <set>
+#include <vector>
 #include "cool-tree.h"
 #include "stringtab.h"
 #include "symtab.h"
+#include "symbolmap.h"
 #include "list.h"
 
 #define TRUE 1
@@ -23,7 +26,7 @@ class ClassTable {
  private:
   int semant_errors_;
   ostream& error_stream_;
-  SymbolTable<Symbol, Class_> *class_table_;
+  SymbolMap<Class_> class_table_;   // class name -> class, by symbol index
   Class_ Object_class_;
   Class_ IO_class_;
   Class_ Int_class_;
@@ -50,5 +53,42 @@ class ClassTable {
   Symbol lub(Symbol a, Symbol b, Class_ current_class);
 };
 
+// One type_check of an expression, walked without recursing (see
+// walkstack.h).  A stage asks for a child to be checked with check(),
+// which comes back with the child's type on top of the type stack, and
+// finishes its expression with result().  Children checked in one stage
+// are checked in the reverse of the order they were asked for.
+//
+// Setting a type changes the expression, so check() is given the slot
+// the child is held in and own()s it first (see tree.h): an expression
+// shared with another tree, or a leaf shared under -L, is checked as a
+// copy of its own.  The expression run() starts from is the caller's to
+// own.
+class TypeCheck {
+ private:
+  ExpressionWalk walk;
+  std::vector<Symbol> types;
+ public:
+  ClassTable *classtable;
+  Class_ current_class;
+  SymbolTable<Symbol, Symbol> *object_env;
+  // what the dispatches and cases under way have still to use
+  std::vector<method_class *> methods;
+  std::vector<std::set<Symbol> > case_types;
+
+  TypeCheck(ClassTable *ct, Class_ c, SymbolTable<Symbol, Symbol> *env)
+    : classtable(ct), current_class(c), object_env(env) { }
+  Symbol run(Expression e);
+  void check(Expression& e) { walk.push(own(e)); }
+  void check_nth(Expressions& l, int n) { walk.push(own(l)->own_nth(n)); }
+  void check_list(Expressions& l);
+  void resume(Expression e, int stage) { walk.push(e, stage); }
+  void push_type(Symbol t) { types.push_back(t); }
+  Symbol pop_type() { Symbol t = types.back(); types.pop_back(); return t; }
+  void result(Expression e, Symbol t) { push_type(e->set_type(t)->get_type()); }
+  ostream& semant_error(tree_node *t)
+    { return classtable->semant_error(current_class->get_filename(), t); }
+};
+
 
 #endif
@@ -0,0 +1,135 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _TREEWALK_H_
+#define _TREEWALK_H_
+
+#include "cool-tree.h"
+#include "walkstack.h"
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  Tree Walks
+//
+//  Every node carries its NodeKind (see tree.h), and a pass goes from a
+//  node to the code for its kind with a switch on it, rather than with
+//  a virtual function in each node class for each pass.
+//
+//      visit_expression(e, f)  calls f(x), where x is e as a pointer to
+//                              its own class (assign_class *, ...)
+//      visit_node(t, f)        the same for a node of any kind but a
+//                              list, for which f is not called
+//
+//  f is normally a generic lambda, so each case of the switch is a
+//  direct call on the node's class:
+//
+//      visit_expression(e, [&](auto *x) { x->type_check_step(tc, stage); });
+//
+//  walk_tree(t, v) walks the tree below node t in order, calling the
+//  hooks of visitor v on each node:
+//
+//      WalkAction pre(tree_node *)    before the node's children
+//      WalkAction post(tree_node *)   after them
+//
+//  A hook returns WALK_ON to go on, WALK_SKIP (from pre) to leave out
+//  the node's children, or WALK_STOP to end the walk there, in which
+//  case walk_tree returns false.  A visitor derives from TreeVisitor,
+//  whose hooks do nothing, and hides those it wants.  The hooks are
+//  called directly, not through virtual functions.  Lists are not
+//  nodes of the walk: the elements of a list are children of the node
+//  that holds it, so t must not be a list.  Like the other traversals,
+//  walk_tree keeps the nodes it has yet to finish on a WalkStack.
+//
+/////////////////////////////////////////////////////////////////////////
+
+enum WalkAction { WALK_ON, WALK_SKIP, WALK_STOP };
+
+typedef WalkStack<tree_node *> TreeWalkStack;
+
+class TreeWalk {
+public:
+  // push the children of t, the first last, so it is visited first
+  // (defined in cool-tree.cc)
+  static void push_children(tree_node *t, TreeWalkStack& walk);
+};
+
+class TreeVisitor {
+public:
+  WalkAction pre(tree_node *)  { return WALK_ON; }
+  WalkAction post(tree_node *) { return WALK_ON; }
+};
+
+template <class F>
+inline void visit_expression(Expression e, F f)
+{
+  switch (e->get_kind()) {
+  case NODE_assign:          f(static_cast<assign_class *>(e)); break;
+  case NODE_static_dispatch: f(static_cast<static_dispatch_class *>(e)); break;
+  case NODE_dispatch:        f(static_cast<dispatch_class *>(e)); break;
+  case NODE_cond:            f(static_cast<cond_class *>(e)); break;
+  case NODE_loop:            f(static_cast<loop_class *>(e)); break;
+  case NODE_typcase:         f(static_cast<typcase_class *>(e)); break;
+  case NODE_block:           f(static_cast<block_class *>(e)); break;
+  case NODE_let:             f(static_cast<let_class *>(e)); break;
+  case NODE_plus:            f(static_cast<plus_class *>(e)); break;
+  case NODE_sub:             f(static_cast<sub_class *>(e)); break;
+  case NODE_mul:             f(static_cast<mul_class *>(e)); break;
+  case NODE_divide:          f(static_cast<divide_class *>(e)); break;
+  case NODE_neg:             f(static_cast<neg_class *>(e)); break;
+  case NODE_lt:              f(static_cast<lt_class *>(e)); break;
+  case NODE_eq:              f(static_cast<eq_class *>(e)); break;
+  case NODE_leq:             f(static_cast<leq_class *>(e)); break;
+  case NODE_comp:            f(static_cast<comp_class *>(e)); break;
+  case NODE_int_const:       f(static_cast<int_const_class *>(e)); break;
+  case NODE_bool_const:      f(static_cast<bool_const_class *>(e)); break;
+  case NODE_string_const:    f(static_cast<string_const_class *>(e)); break;
+  case NODE_new_:            f(static_cast<new__class *>(e)); break;
+  case NODE_isvoid:          f(static_cast<isvoid_class *>(e)); break;
+  case NODE_no_expr:         f(static_cast<no_expr_class *>(e)); break;
+  case NODE_object:          f(static_cast<object_class *>(e)); break;
+  default:                   break;
+  }
+}
+
+template <class F>
+inline void visit_node(tree_node *t, F f)
+{
+  switch (t->get_kind()) {
+  case NODE_program:         f(static_cast<program_class *>(t)); break;
+  case NODE_class_:          f(static_cast<class__class *>(t)); break;
+  case NODE_method:          f(static_cast<method_class *>(t)); break;
+  case NODE_attr:            f(static_cast<attr_class *>(t)); break;
+  case NODE_formal:          f(static_cast<formal_class *>(t)); break;
+  case NODE_branch:          f(static_cast<branch_class *>(t)); break;
+  case NODE_list:            break;
+  default:
+    visit_expression(static_cast<Expression>(t), f);
+  }
+}
+
+template <class Visitor>
+bool walk_tree(tree_node *t, Visitor& v)
+{
+  TreeWalkStack walk;
+  walk.push(t);
+  WalkStep<tree_node *> s;
+  while (walk.pop(s)) {
+    if (s.stage == 1) {
+      if (v.post(s.node) == WALK_STOP)
+        return false;
+      continue;
+    }
+    WalkAction a = v.pre(s.node);
+    if (a == WALK_STOP)
+      return false;
+    walk.push(s.node, 1);
+    if (a != WALK_SKIP)
+      TreeWalk::push_children(s.node, walk);
+  }
+  return true;
+}
+
+#endif
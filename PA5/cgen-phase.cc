@@ -18,6 +18,8 @@ void handle_flags(int argc, char *argv[]);
 
 int main(int argc, char *argv[]) {
   int firstfile_index;
+  NodeArena arena;              // the nodes of this compilation
+  NodeArena::Use use(&arena);
 
   handle_flags(argc,argv);
   firstfile_index = optind;
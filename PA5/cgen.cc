@@ -5,13 +5,195 @@
 
 #include "cgen.h"
 #include "cgen_gc.h"
+#include "treewalk.h"
 
 extern void emit_string_constant(ostream& str, char* s);
 extern int cgen_debug;
 
+//
+// The basic class and runtime names come straight from idtable's
+// predefined block (see PredefSymbol in stringtab.h).
+//
+Symbol No_class = predef_symbol(PREDEF_No_class);
+static Symbol
+    self      = predef_symbol(PREDEF_self),
+    SELF_TYPE = predef_symbol(PREDEF_SELF_TYPE),
+    Object    = predef_symbol(PREDEF_Object),
+    IO        = predef_symbol(PREDEF_IO),
+    Int       = predef_symbol(PREDEF_Int),
+    Str       = predef_symbol(PREDEF_Str),
+    Bool      = predef_symbol(PREDEF_Bool),
+    Main      = predef_symbol(PREDEF_Main),
+    prim_slot = predef_symbol(PREDEF_prim_slot);
+
 static int global_label_cursor = 0;
 CgenClassTable* active_codegen_table = nullptr;
 
+static char *gc_init_names[] =
+  { "_NoGC_Init", "_GenGC_Init", "_ScnGC_Init" };
+static char *gc_collect_names[] =
+  { "_NoGC_Collect", "_GenGC_Collect", "_ScnGC_Collect" };
+
+//  BoolConst is a class that implements code generation for operations
+//  on the two booleans, which are given global names here.
+BoolConst falsebool(FALSE);
+BoolConst truebool(TRUE);
+
+//******************************************************************
+// 汇编指令的输出函数 (与课程框架的 emit_* 相同)
+//******************************************************************
+
+static void emit_load(char *dest_reg, int offset, char *source_reg, ostream& s)
+{
+  s << LW << dest_reg << " " << offset * WORD_SIZE << "(" << source_reg << ")" 
+    << endl;
+}
+
+static void emit_store(char *source_reg, int offset, char *dest_reg, ostream& s)
+{
+  s << SW << source_reg << " " << offset * WORD_SIZE << "(" << dest_reg << ")"
+      << endl;
+}
+
+static void emit_load_imm(char *dest_reg, int val, ostream& s)
+{ s << LI << dest_reg << " " << val << endl; }
+
+static void emit_load_address(char *dest_reg, char *address, ostream& s)
+{ s << LA << dest_reg << " " << address << endl; }
+
+static void emit_partial_load_address(char *dest_reg, ostream& s)
+{ s << LA << dest_reg << " "; }
+
+static void emit_load_bool(char *dest, const BoolConst& b, ostream& s)
+{
+  emit_partial_load_address(dest,s);
+  b.code_ref(s);
+  s << endl;
+}
+
+static void emit_load_string(char *dest, StringEntry *str, ostream& s)
+{
+  emit_partial_load_address(dest,s);
+  str->code_ref(s);
+  s << endl;
+}
+
+static void emit_load_int(char *dest, IntEntry *i, ostream& s)
+{
+  emit_partial_load_address(dest,s);
+  i->code_ref(s);
+  s << endl;
+}
+
+static void emit_move(char *dest_reg, char *source_reg, ostream& s)
+{ s << MOVE << dest_reg << " " << source_reg << endl; }
+
+static void emit_neg(char *dest, char *src1, ostream& s)
+{ s << NEG << dest << " " << src1 << endl; }
+
+static void emit_add(char *dest, char *src1, char *src2, ostream& s)
+{ s << ADD << dest << " " << src1 << " " << src2 << endl; }
+
+static void emit_addu(char *dest, char *src1, char *src2, ostream& s)
+{ s << ADDU << dest << " " << src1 << " " << src2 << endl; }
+
+static void emit_addiu(char *dest, char *src1, int imm, ostream& s)
+{ s << ADDIU << dest << " " << src1 << " " << imm << endl; }
+
+static void emit_div(char *dest, char *src1, char *src2, ostream& s)
+{ s << DIV << dest << " " << src1 << " " << src2 << endl; }
+
+static void emit_mul(char *dest, char *src1, char *src2, ostream& s)
+{ s << MUL << dest << " " << src1 << " " << src2 << endl; }
+
+static void emit_sub(char *dest, char *src1, char *src2, ostream& s)
+{ s << SUB << dest << " " << src1 << " " << src2 << endl; }
+
+static void emit_sll(char *dest, char *src1, int num, ostream& s)
+{ s << SLL << dest << " " << src1 << " " << num << endl; }
+
+static void emit_jalr(char *dest, ostream& s)
+{ s << JALR << "\t" << dest << endl; }
+
+static void emit_jal(char *address,ostream &s)
+{ s << JAL << address << endl; }
+
+static void emit_return(ostream& s)
+{ s << RET << endl; }
+
+static void emit_gc_assign(ostream& s)
+{ s << JAL << "_GenGC_Assign" << endl; }
+
+static void emit_disptable_ref(Symbol sym, ostream& s)
+{  s << sym << DISPTAB_SUFFIX; }
+
+static void emit_init_ref(Symbol sym, ostream& s)
+{ s << sym << CLASSINIT_SUFFIX; }
+
+static void emit_label_ref(int l, ostream &s)
+{ s << "label" << l; }
+
+static void emit_protobj_ref(Symbol sym, ostream& s)
+{ s << sym << PROTOBJ_SUFFIX; }
+
+static void emit_method_ref(Symbol classname, Symbol methodname, ostream& s)
+{ s << classname << METHOD_SEP << methodname; }
+
+static void emit_label_def(int l, ostream &s)
+{
+  emit_label_ref(l,s);
+  s << ":" << endl;
+}
+
+static void emit_beq(char *src1, char *src2, int label, ostream &s)
+{
+  s << BEQ << src1 << " " << src2 << " ";
+  emit_label_ref(label,s);
+  s << endl;
+}
+
+static void emit_bne(char *src1, char *src2, int label, ostream &s)
+{
+  s << BNE << src1 << " " << src2 << " ";
+  emit_label_ref(label,s);
+  s << endl;
+}
+
+static void emit_bleq(char *src1, char *src2, int label, ostream &s)
+{
+  s << BLEQ << src1 << " " << src2 << " ";
+  emit_label_ref(label,s);
+  s << endl;
+}
+
+static void emit_blt(char *src1, char *src2, int label, ostream &s)
+{
+  s << BLT << src1 << " " << src2 << " ";
+  emit_label_ref(label,s);
+  s << endl;
+}
+
+static void emit_blti(char *src1, int imm, int label, ostream &s)
+{
+  s << BLT << src1 << " " << imm << " ";
+  emit_label_ref(label,s);
+  s << endl;
+}
+
+static void emit_bgti(char *src1, int imm, int label, ostream &s)
+{
+  s << BGT << src1 << " " << imm << " ";
+  emit_label_ref(label,s);
+  s << endl;
+}
+
+static void emit_branch(int l, ostream& s)
+{
+  s << BRANCH;
+  emit_label_ref(l,s);
+  s << endl;
+}
+
 
 #define INST_PUSH(reg, s) { emit_store(reg, 0, SP, s); emit_addiu(SP, SP, -4, s); }
 #define INST_POP(reg, s)  { emit_addiu(SP, SP, 4, s); emit_load(reg, 0, SP, s); }
@@ -37,7 +219,7 @@ AddressDescriptor TranslationContext::resolve_symbol_address(Symbol sym) {
 
     // 3. 优先级：回退至类属性 (基于 SELF/S0 寻址)
     // 标记为无效以通知调用者去属性表查找
-    return AddressDescriptor(nullptr, -1);
+    return AddressDescriptor();
 }
 
 
@@ -80,7 +262,78 @@ void method_class::produce_code(ostream& s, CgenNode* host_class) {
     emit_return(s);
 }
 
-void object_class::produce_code(ostream& s, TranslationContext& context) {
+//******************************************************************
+// 表达式翻译: 显式栈遍历 (见 walkstack.h)
+// 每个表达式的 code_step 在原先递归调用子表达式之处分为若干阶段;
+// label 为该表达式在阶段之间需要保留的标号
+//******************************************************************
+void CodeWalk::run(Expression e) {
+    WalkStep<Expression> step;
+    code(e);
+    while (_walk.pop(step)) {
+        // 按节点种类 switch 分派, 不经虚函数 (见 treewalk.h)
+        visit_expression(step.node, [&](auto *x) {
+            x->code_step(*this, step.stage, step.n);
+        });
+    }
+}
+
+void Expression_class::produce_code(ostream& s, TranslationContext& context) {
+    CodeWalk walk(s, context);
+    walk.run(this);
+}
+
+// 二元运算的操作数: 先求值 e1 并压栈, 再求值 e2; 两者完成后返回 true
+static bool code_operands(CodeWalk& w, Expression e, Expression e1, Expression e2, int stage) {
+    if (stage == 0) {
+        w.resume(e, 1);
+        w.code(e1);
+        return false;
+    }
+    if (stage == 1) {
+        emit_store(ACC, 0, SP, w.s);
+        emit_addiu(SP, SP, -4, w.s);
+        w.resume(e, 2);
+        w.code(e2);
+        return false;
+    }
+    return true;
+}
+
+// 方法在 type 类分派表中的偏移; 基本类已安装, 类型检查过的程序中 type 总在类表中
+static int dispatch_offset(Symbol type, Symbol name) {
+    CgenNodeP nd = active_codegen_table->lookup(type);
+    assert(nd != NULL);
+    int offset = nd->resolve_method_offset(name);
+    assert(offset >= 0);
+    return offset;
+}
+
+// 分派的操作数: 第 i 阶段压入第 i-1 个实参并求值第 i 个, 实参之后求值调用对象;
+// 全部完成后返回 true
+static bool code_dispatch_operands(CodeWalk& w, Expression e, Expressions actual,
+                                   Expression expr, int stage) {
+    int len = actual->len();
+    if (stage > 0 && stage <= len) {
+        // 压栈操作改变了当前的栈顶指针位置
+        emit_store(ACC, 0, SP, w.s);
+        emit_addiu(SP, SP, -4, w.s);
+    }
+    if (stage < len) {
+        w.resume(e, stage + 1);
+        w.code(actual->nth(stage));
+        return false;
+    }
+    if (stage == len) {
+        w.resume(e, len + 1);
+        w.code(expr);
+        return false;
+    }
+    return true;
+}
+
+void object_class::code_step(CodeWalk& w, int, int) {
+    ostream& s = w.s;
     // 处理 self 特殊情况
     if (name == self) {
         emit_move(ACC, SELF, s);
@@ -88,14 +341,14 @@ void object_class::produce_code(ostream& s, TranslationContext& context) {
     }
 
     // 调用解耦后的地址解算器
-    AddressDescriptor addr = context.resolve_symbol_address(name);
+    AddressDescriptor addr = w.context.resolve_symbol_address(name);
 
     if (addr.is_valid) {
         // 加载局部变量或参数
         emit_load(ACC, addr.offset, (char*)addr.base_reg, s);
     } else {
         // 处理类属性访问逻辑
-        int attr_offset = context.get_class_context()->resolve_attribute_offset(name);
+        int attr_offset = w.context.get_class_context()->resolve_attribute_offset(name);
         // 属性相对于 SELF 的偏移通常从 3 开始（0:Tag, 1:Size, 2:DispTab）
         emit_load(ACC, attr_offset + 3, SELF, s);
     }
@@ -104,26 +357,31 @@ void object_class::produce_code(ostream& s, TranslationContext& context) {
 //******************************************************************
 // 赋值表达式逻辑实现
 //******************************************************************
-void assign_class::produce_code(ostream& s, TranslationContext& context) {
+void assign_class::code_step(CodeWalk& w, int stage, int) {
+    ostream& s = w.s;
     // 首先计算右侧表达式的值，结果存入 $a0
-    expr->produce_code(s, context);
+    if (stage == 0) {
+        w.resume(this, 1);
+        w.code(expr);
+        return;
+    }
 
     // 解析左侧标识符的存储位置
-    AddressDescriptor addr = context.resolve_symbol_address(name);
+    AddressDescriptor addr = w.context.resolve_symbol_address(name);
 
     if (addr.is_valid) {
         // 存储至局部变量或参数空间
         emit_store(ACC, addr.offset, (char*)addr.base_reg, s);
     } else {
         // 存储至类属性空间
-        int attr_offset = context.get_class_context()->resolve_attribute_offset(name);
+        int attr_offset = w.context.get_class_context()->resolve_attribute_offset(name);
         emit_store(ACC, attr_offset + 3, SELF, s);
-    }
 
-    // 处理垃圾回收观察者（若启用）
-    if (Z_GC_CHECK) {
-        emit_addiu(A1, SELF, (attr_offset + 3) * 4, s);
-        emit_jal("_GenGC_Assign", s);
+        // 处理垃圾回收观察者（若启用）
+        if (cgen_Memmgr == GC_GENGC) {
+            emit_addiu(A1, SELF, (attr_offset + 3) * 4, s);
+            emit_gc_assign(s);
+        }
     }
 }
 
@@ -132,17 +390,13 @@ void assign_class::produce_code(ostream& s, TranslationContext& context) {
 //******************************************************************
 
 
-void dispatch_class::produce_code(ostream& s, TranslationContext& context) {
+void dispatch_class::code_step(CodeWalk& w, int stage, int) {
+    ostream& s = w.s;
     // 1. 将实参从左至右依次求值并压栈
-    for (int i = 0; i < actual->len(); ++i) {
-        actual->nth(i)->produce_code(s, context);
-        // 压栈操作改变了当前的栈顶指针位置
-        emit_store(ACC, 0, SP, s);
-        emit_addiu(SP, SP, -4, s);
-    }
-
     // 2. 求值调用对象 (Receiver)
-    expr->produce_code(s, context);
+    if (!code_dispatch_operands(w, this, actual, expr, stage)) {
+        return;
+    }
 
     // 3. 运行时异常检查：确保调用对象非空 (Void Check)
     int ok_label = global_label_cursor++;
@@ -160,56 +414,71 @@ void dispatch_class::produce_code(ostream& s, TranslationContext& context) {
     // 查找方法在虚表中的偏移量
     Symbol rec_type = expr->get_type();
     if (rec_type == SELF_TYPE) {
-        rec_type = context.get_class_context()->get_name();
+        rec_type = w.context.get_class_context()->get_name();
     }
     
-    int method_offset = context.get_class_context()->resolve_method_offset(name);
+    // 按接收者的静态类型查表
+    int method_offset = dispatch_offset(rec_type, name);
     emit_load(T1, method_offset, T1, s);
     emit_jalr(T1, s);
 }
 
 //******************************************************************
 // 条件分支逻辑实现
+// label 为 else 分支标号, 结束标号紧随其后
 //******************************************************************
-void cond_class::code(ostream& s, TranslationContext& context) {
-    int else_branch = global_label_cursor++;
-    int end_branch = global_label_cursor++;
-
-    // 1. 计算谓词逻辑
-    pred->produce_code(s, context);
-    
-    // 载入布尔对象的原始值 (位于偏移 3 处)
-    emit_load(T1, 3, ACC, s);
-    
-    // 若为 false (0)，跳转至 else 分支
-    emit_beq(T1, ZERO, else_branch, s);
-
-    // 2. Then 分支逻辑
-    then_exp->produce_code(s, context);
-    emit_branch(end_branch, s);
-
-    // 3. Else 分支逻辑
-    emit_label_def(else_branch, s);
-    else_exp->produce_code(s, context);
-
-    // 4. 结束标记
-    emit_label_def(end_branch, s);
+void cond_class::code_step(CodeWalk& w, int stage, int label) {
+    ostream& s = w.s;
+    int else_branch = label;
+    int end_branch = label + 1;
+
+    switch (stage) {
+    case 0:
+        else_branch = global_label_cursor++;
+        end_branch = global_label_cursor++;
+
+        // 1. 计算谓词逻辑
+        w.resume(this, 1, else_branch);
+        w.code(pred);
+        break;
+
+    case 1:
+        // 载入布尔对象的原始值 (位于偏移 3 处)
+        emit_load(T1, 3, ACC, s);
+        
+        // 若为 false (0)，跳转至 else 分支
+        emit_beq(T1, ZERO, else_branch, s);
+
+        // 2. Then 分支逻辑
+        w.resume(this, 2, else_branch);
+        w.code(then_exp);
+        break;
+
+    case 2:
+        emit_branch(end_branch, s);
+
+        // 3. Else 分支逻辑
+        emit_label_def(else_branch, s);
+        w.resume(this, 3, else_branch);
+        w.code(else_exp);
+        break;
+
+    default:
+        // 4. 结束标记
+        emit_label_def(end_branch, s);
+    }
 }
 
 //******************************************************************
 // 静态分派逻辑实现
 //******************************************************************
-void static_dispatch_class::produce_code(ostream& s, TranslationContext& context) {
-    // 参数压栈
-    for (int i = 0; i < actual->len(); ++i) {
-        actual->nth(i)->produce_code(s, context);
-        emit_store(ACC, 0, SP, s);
-        emit_addiu(SP, SP, -4, s);
+void static_dispatch_class::code_step(CodeWalk& w, int stage, int) {
+    ostream& s = w.s;
+    // 参数压栈, 求值调用者
+    if (!code_dispatch_operands(w, this, actual, expr, stage)) {
+        return;
     }
 
-    // 求值调用者
-    expr->produce_code(s, context);
-
     // 空对象检查
     int ok_label = global_label_cursor++;
     emit_bne(ACC, ZERO, ok_label, s);
@@ -220,10 +489,10 @@ void static_dispatch_class::produce_code(ostream& s, TranslationContext& context
     emit_label_def(ok_label, s);
     
     // 静态分派直接查指定类的虚表
-    std::string disp_tab_name = std::string(type_name->get_string()) + "_dispatch_tab";
+    std::string disp_tab_name = std::string(type_name->get_string()) + DISPTAB_SUFFIX;
     emit_load_address(T1, (char*)disp_tab_name.c_str(), s);
     
-    int method_offset = context.get_class_context()->resolve_method_offset(name);
+    int method_offset = dispatch_offset(type_name, name);
     emit_load(T1, method_offset, T1, s);
     emit_jalr(T1, s);
 }
@@ -231,56 +500,79 @@ void static_dispatch_class::produce_code(ostream& s, TranslationContext& context
 //******************************************************************
 // Let 表达式逻辑实现
 //******************************************************************
-void let_class::produce_code(ostream& s, TranslationContext& context) {
-    // 1. 初始化局部变量
-    if (init->get_type() != nullptr) {
-        init->produce_code(s, context);
-    } else {
+void let_class::code_step(CodeWalk& w, int stage, int) {
+    ostream& s = w.s;
+    if (stage == 0) {
+        // 1. 初始化局部变量
+        if (init->get_kind() != NODE_no_expr) {
+            w.resume(this, 1);
+            w.code(init);
+            return;
+        }
         // 默认初始化：根据类型载入原型常量
         if (type_decl == Int) {
             emit_load_int(ACC, inttable.lookup_string("0"), s);
         } else if (type_decl == Str) {
             emit_load_string(ACC, stringtable.lookup_string(""), s);
         } else if (type_decl == Bool) {
-            emit_load_bool(ACC, BoolConst(false), s);
+            emit_load_bool(ACC, falsebool, s);
         } else {
             emit_move(ACC, ZERO, s);
         }
+        stage = 1;
     }
 
-    // 2. 将初始值压栈并注册到当前作用域
-    emit_store(ACC, 0, SP, s);
-    emit_addiu(SP, SP, -4, s);
-    
-    context.enter_block();
-    context.register_local(identifier);
+    if (stage == 1) {
+        // 2. 将初始值压栈并注册到当前作用域
+        emit_store(ACC, 0, SP, s);
+        emit_addiu(SP, SP, -4, s);
+        
+        w.context.enter_block();
+        w.context.register_local(identifier);
 
-    // 3. 在包含新变量的环境下计算主体表达式
-    body->produce_code(s, context);
+        // 3. 在包含新变量的环境下计算主体表达式
+        w.resume(this, 2);
+        w.code(body);
+        return;
+    }
 
     // 4. 恢复栈指针并退出作用域
-    context.exit_block();
+    w.context.exit_block();
     emit_addiu(SP, SP, 4, s);
 }
 
 //******************************************************************
 // 循环逻辑实现
+// label 为循环起始标号, 结束标号紧随其后
 //******************************************************************
-void loop_class::produce_code(ostream& s, TranslationContext& context) {
-    int start_label = global_label_cursor++;
-    int exit_label = global_label_cursor++;
+void loop_class::code_step(CodeWalk& w, int stage, int label) {
+    ostream& s = w.s;
+    int start_label = label;
+    int exit_label = label + 1;
 
-    emit_label_def(start_label, s);
+    if (stage == 0) {
+        start_label = global_label_cursor++;
+        exit_label = global_label_cursor++;
 
-    // 计算循环判定条件
-    pred->produce_code(s, context);
-    emit_load(T1, 3, ACC, s);
-    
-    // 若条件为 false 则跳出
-    emit_beq(T1, ZERO, exit_label, s);
+        emit_label_def(start_label, s);
+
+        // 计算循环判定条件
+        w.resume(this, 1, start_label);
+        w.code(pred);
+        return;
+    }
 
-    // 执行循环体
-    body->produce_code(s, context);
+    if (stage == 1) {
+        emit_load(T1, 3, ACC, s);
+        
+        // 若条件为 false 则跳出
+        emit_beq(T1, ZERO, exit_label, s);
+
+        // 执行循环体
+        w.resume(this, 2, start_label);
+        w.code(body);
+        return;
+    }
     
     // 回到循环起始点
     emit_branch(start_label, s);
@@ -290,19 +582,91 @@ void loop_class::produce_code(ostream& s, TranslationContext& context) {
     emit_move(ACC, ZERO, s);
 }
 
+//******************************************************************
+// 分支选择逻辑实现
+// 分支按类型的 class tag 从大到小检查: tag 按继承树先序编号,
+// 子类的 tag 大于祖先, 故最具体的分支先匹配.
+// label 为结束标号, 第 i 个分支不匹配时跳至 label + 1 + i;
+// 第 i 个分支体在阶段 2 + i 生成
+//******************************************************************
+static std::vector<branch_class *> sorted_branches(Cases cases) {
+    std::vector<branch_class *> branches;
+    for (int i = cases->first(); cases->more(i); i = cases->next(i)) {
+        branches.push_back(static_cast<branch_class *>(cases->nth(i)));
+    }
+    std::stable_sort(branches.begin(), branches.end(),
+                     [](branch_class *a, branch_class *b) {
+        return active_codegen_table->GetClassTag(a->type_decl) >
+               active_codegen_table->GetClassTag(b->type_decl);
+    });
+    return branches;
+}
+
+void typcase_class::code_step(CodeWalk& w, int stage, int label) {
+    ostream& s = w.s;
+    int end_label = label;
+    int n = cases->len();
+
+    if (stage == 0) {
+        w.resume(this, 1);
+        w.code(expr);
+        return;
+    }
+
+    if (stage == 1) {
+        end_label = global_label_cursor;
+        global_label_cursor += n + 2;
+
+        // 对 Void 分支选择报错
+        int ok_label = end_label + n + 1;
+        emit_bne(ACC, ZERO, ok_label, s);
+        emit_load_address(ACC, "str_const0", s);
+        emit_load_imm(T1, line_number, s);
+        emit_jal("_case_abort2", s);
+        emit_label_def(ok_label, s);
+        emit_load(T2, 0, ACC, s);           // T2: 对象的 class tag
+    } else {
+        // 上一分支体结束: 弹出其绑定的变量并跳至结束
+        w.context.exit_block();
+        emit_addiu(SP, SP, 4, s);
+        emit_branch(end_label, s);
+        emit_label_def(end_label + stage - 1, s);
+    }
+
+    int i = stage - 1;
+    if (i < n) {
+        branch_class *b = sorted_branches(cases)[i];
+        CgenNodeP nd = active_codegen_table->lookup(b->type_decl);
+        emit_blti(T2, nd->GetClassTag(), end_label + 1 + i, s);
+        emit_bgti(T2, nd->GetLastTag(), end_label + 1 + i, s);
+
+        emit_store(ACC, 0, SP, s);
+        emit_addiu(SP, SP, -4, s);
+        w.context.enter_block();
+        w.context.register_local(b->name);
+
+        w.resume(this, stage + 1, end_label);
+        w.code(b->expr);
+        return;
+    }
+
+    // 没有分支匹配
+    emit_jal("_case_abort", s);
+    emit_label_def(end_label, s);
+}
+
 //******************************************************************
 // 算术运算逻辑实现 (加、减、乘、除)
 //******************************************************************
 
 
-void plus_class::produce_code(ostream& s, TranslationContext& context) {
+void plus_class::code_step(CodeWalk& w, int stage, int) {
+    ostream& s = w.s;
     // 1. 求值左操作数并压栈
-    e1->produce_code(s, context);
-    emit_store(ACC, 0, SP, s);
-    emit_addiu(SP, SP, -4, s);
-
     // 2. 求值右操作数
-    e2->produce_code(s, context);
+    if (!code_operands(w, this, e1, e2, stage)) {
+        return;
+    }
 
     // 3. 复制左操作数对象（Cool 要求运算返回新对象）
     emit_jal("Object.copy", s);
@@ -317,12 +681,11 @@ void plus_class::produce_code(ostream& s, TranslationContext& context) {
     emit_store(T2, 3, ACC, s);  // 将结果存回新对象的原始值字段
 }
 
-void sub_class::produce_code(ostream& s, TranslationContext& context) {
-    e1->produce_code(s, context);
-    emit_store(ACC, 0, SP, s);
-    emit_addiu(SP, SP, -4, s);
-
-    e2->produce_code(s, context);
+void sub_class::code_step(CodeWalk& w, int stage, int) {
+    ostream& s = w.s;
+    if (!code_operands(w, this, e1, e2, stage)) {
+        return;
+    }
     emit_jal("Object.copy", s);
     
     emit_addiu(SP, SP, 4, s);
@@ -334,12 +697,11 @@ void sub_class::produce_code(ostream& s, TranslationContext& context) {
     emit_store(T2, 3, ACC, s);
 }
 
-void mul_class::produce_code(ostream& s, TranslationContext& context) {
-    e1->produce_code(s, context);
-    emit_store(ACC, 0, SP, s);
-    emit_addiu(SP, SP, -4, s);
-
-    e2->produce_code(s, context);
+void mul_class::code_step(CodeWalk& w, int stage, int) {
+    ostream& s = w.s;
+    if (!code_operands(w, this, e1, e2, stage)) {
+        return;
+    }
     emit_jal("Object.copy", s);
     
     emit_addiu(SP, SP, 4, s);
@@ -351,12 +713,11 @@ void mul_class::produce_code(ostream& s, TranslationContext& context) {
     emit_store(T2, 3, ACC, s);
 }
 
-void divide_class::produce_code(ostream& s, TranslationContext& context) {
-    e1->produce_code(s, context);
-    emit_store(ACC, 0, SP, s);
-    emit_addiu(SP, SP, -4, s);
-
-    e2->produce_code(s, context);
+void divide_class::code_step(CodeWalk& w, int stage, int) {
+    ostream& s = w.s;
+    if (!code_operands(w, this, e1, e2, stage)) {
+        return;
+    }
     emit_jal("Object.copy", s);
     
     emit_addiu(SP, SP, 4, s);
@@ -371,22 +732,19 @@ void divide_class::produce_code(ostream& s, TranslationContext& context) {
 //******************************************************************
 // 语句块逻辑实现
 //******************************************************************
-void block_class::produce_code(ostream& s, TranslationContext& context) {
+void block_class::code_step(CodeWalk& w, int, int) {
     // 依次计算每个表达式，最后一个表达式的值保留在 $a0 中作为结果
-    for (int i = body->first(); body->more(i); i = body->next(i)) {
-        body->nth(i)->produce_code(s, context);
-    }
+    w.code_list(body);
 }
 
 //******************************************************************
 // 关系运算逻辑实现 (LT, EQ, LEQ)
 //******************************************************************
-void lt_class::produce_code(ostream& s, TranslationContext& context) {
-    e1->produce_code(s, context);
-    emit_store(ACC, 0, SP, s);
-    emit_addiu(SP, SP, -4, s);
-    
-    e2->produce_code(s, context);
+void lt_class::code_step(CodeWalk& w, int stage, int) {
+    ostream& s = w.s;
+    if (!code_operands(w, this, e1, e2, stage)) {
+        return;
+    }
     emit_addiu(SP, SP, 4, s);
     emit_load(T1, 0, SP, s);    // T1: e1_obj
     emit_load(T1, 3, T1, s);    // T1: e1_val
@@ -403,12 +761,30 @@ void lt_class::produce_code(ostream& s, TranslationContext& context) {
     emit_label_def(end_label, s);
 }
 
-void eq_class::produce_code(ostream& s, TranslationContext& context) {
-    e1->produce_code(s, context);
-    emit_store(ACC, 0, SP, s);
-    emit_addiu(SP, SP, -4, s);
+void leq_class::code_step(CodeWalk& w, int stage, int) {
+    ostream& s = w.s;
+    if (!code_operands(w, this, e1, e2, stage)) {
+        return;
+    }
+    emit_addiu(SP, SP, 4, s);
+    emit_load(T1, 0, SP, s);    // T1: e1_obj
+    emit_load(T1, 3, T1, s);    // T1: e1_val
+    emit_load(T2, 3, ACC, s);   // T2: e2_val
+    
+    int true_label = global_label_cursor++;
+    
+    emit_load_bool(ACC, BoolConst(true), s);
+    emit_bleq(T1, T2, true_label, s);
+    emit_load_bool(ACC, BoolConst(false), s);
     
-    e2->produce_code(s, context);
+    emit_label_def(true_label, s);
+}
+
+void eq_class::code_step(CodeWalk& w, int stage, int) {
+    ostream& s = w.s;
+    if (!code_operands(w, this, e1, e2, stage)) {
+        return;
+    }
     emit_addiu(SP, SP, 4, s);
     emit_load(T1, 0, SP, s);    // T1: e1_obj
     emit_move(T2, ACC, s);      // T2: e2_obj
@@ -428,28 +804,38 @@ void eq_class::produce_code(ostream& s, TranslationContext& context) {
 //******************************************************************
 // 常量加载与一元运算
 //******************************************************************
-void int_const_class::produce_code(ostream& s, TranslationContext& context) {
-    emit_load_int(ACC, inttable.lookup_string(token->get_string()), s);
+void int_const_class::code_step(CodeWalk& w, int, int) {
+    emit_load_int(ACC, inttable.lookup_string(token->get_string()), w.s);
 }
 
-void string_const_class::produce_code(ostream& s, TranslationContext& context) {
-    emit_load_string(ACC, stringtable.lookup_string(token->get_string()), s);
+void string_const_class::code_step(CodeWalk& w, int, int) {
+    emit_load_string(ACC, stringtable.lookup_string(token->get_string()), w.s);
 }
 
-void bool_const_class::produce_code(ostream& s, TranslationContext& context) {
-    emit_load_bool(ACC, BoolConst(val), s);
+void bool_const_class::code_step(CodeWalk& w, int, int) {
+    emit_load_bool(ACC, BoolConst(val), w.s);
 }
 
-void neg_class::produce_code(ostream& s, TranslationContext& context) {
-    e1->produce_code(s, context);
+void neg_class::code_step(CodeWalk& w, int stage, int) {
+    ostream& s = w.s;
+    if (stage == 0) {
+        w.resume(this, 1);
+        w.code(e1);
+        return;
+    }
     emit_jal("Object.copy", s);
     emit_load(T1, 3, ACC, s);
     emit_neg(T1, T1, s);
     emit_store(T1, 3, ACC, s);
 }
 
-void comp_class::produce_code(ostream& s, TranslationContext& context) {
-    e1->produce_code(s, context);
+void comp_class::code_step(CodeWalk& w, int stage, int) {
+    ostream& s = w.s;
+    if (stage == 0) {
+        w.resume(this, 1);
+        w.code(e1);
+        return;
+    }
     emit_load(T1, 3, ACC, s);   // 载入 Bool 的原始值
     int true_label = global_label_cursor++;
     
@@ -463,7 +849,8 @@ void comp_class::produce_code(ostream& s, TranslationContext& context) {
 //******************************************************************
 // 对象实例化与空值检查
 //******************************************************************
-void new__class::produce_code(ostream& s, TranslationContext& context) {
+void new__class::code_step(CodeWalk& w, int, int) {
+    ostream& s = w.s;
     if (type_name == SELF_TYPE) {
         // 动态实例化当前类
         emit_load(T1, 0, SELF, s);          // 载入 class tag
@@ -488,8 +875,13 @@ void new__class::produce_code(ostream& s, TranslationContext& context) {
     }
 }
 
-void isvoid_class::produce_code(ostream& s, TranslationContext& context) {
-    e1->produce_code(s, context);
+void isvoid_class::code_step(CodeWalk& w, int stage, int) {
+    ostream& s = w.s;
+    if (stage == 0) {
+        w.resume(this, 1);
+        w.code(e1);
+        return;
+    }
     int true_label = global_label_cursor++;
     
     emit_move(T1, ACC, s);
@@ -500,8 +892,470 @@ void isvoid_class::produce_code(ostream& s, TranslationContext& context) {
     emit_label_def(true_label, s);
 }
 
-void no_expr_class::produce_code(ostream& s, TranslationContext& context) {
-    emit_move(ACC, ZERO, s); // 返回 Void
+void no_expr_class::code_step(CodeWalk& w, int, int) {
+    emit_move(ACC, ZERO, w.s); // 返回 Void
+}
+
+//******************************************************************
+// 常量池: 字符串与整数常量的数据定义
+// 字符串的 .ascii/.byte 编码在入表时已生成 (见 stringtab.h), 此处直接写出
+//******************************************************************
+
+void StringEntry::code_ref(ostream& s) {
+    s << STRCONST_PREFIX << index;
+}
+
+void StringEntry::code_def(ostream& s, int stringclasstag) {
+    IntEntryP lensym = inttable.add_int(len);
+
+    s << WORD << "-1" << endl;                       // eye catcher
+    code_ref(s);  s << LABEL
+      << WORD << stringclasstag << endl              // tag
+      << WORD << (DEFAULT_OBJFIELDS + STRING_SLOTS + (len + 4) / 4) << endl
+      << WORD << STRINGNAME << DISPTAB_SUFFIX << endl;
+    s << WORD;  lensym->code_ref(s);  s << endl;     // 字符串长度
+    code_string(s);                                  // 预编码的字符串内容
+    s << ALIGN;
+}
+
+void StrTable::code_string_table(ostream& s, int stringclasstag) {
+    for (int i = first(); more(i); i = next(i))
+        lookup(i)->code_def(s, stringclasstag);
+}
+
+void IntEntry::code_ref(ostream& s) {
+    s << INTCONST_PREFIX << index;
+}
+
+void IntEntry::code_def(ostream& s, int intclasstag) {
+    s << WORD << "-1" << endl;
+    code_ref(s);  s << LABEL
+      << WORD << intclasstag << endl
+      << WORD << (DEFAULT_OBJFIELDS + INT_SLOTS) << endl
+      << WORD << INTNAME << DISPTAB_SUFFIX << endl
+      << WORD << value << endl;                      // 入表时已解析的值
+}
+
+void IntTable::code_string_table(ostream& s, int intclasstag) {
+    for (int i = first(); more(i); i = next(i))
+        lookup(i)->code_def(s, intclasstag);
+}
+
+//******************************************************************
+// CgenNode 元数据查询: 均为按符号下标的数组访问, 未找到时返回 -1
+//******************************************************************
+
+int CgenNode::resolve_attribute_offset(Symbol sym) {
+    int *idx = m_attrib_idx_tab.find(sym);
+    return idx ? *idx : -1;
+}
+
+int CgenNode::resolve_method_offset(Symbol sym) {
+    std::pair<Symbol, int> *entry = m_method_idx_tab.find(sym);
+    return entry ? entry->second : -1;
+}
+
+//******************************************************************
+// 类表与偏移表的建立
+// 子类先继承父类的属性与方法偏移, 再追加自己的属性,
+// 重定义的方法沿用父类的分派表槽位.
+// 类按继承树先序编号 (class tag), 故一个类及其全部子孙的 tag
+// 恰为 [GetClassTag(), GetLastTag()] (分支选择据此判断)
+//******************************************************************
+
+CgenNode::CgenNode(Class_ nd, Basicness bstatus, CgenClassTableP ct) :
+    class__class((const class__class &) *nd),
+    parentnd(NULL), children(NULL), basic_status(bstatus),
+    m_class_tag(-1), m_last_tag(-1), m_attrib_count(0), m_method_count(0) {
+    stringtable.add_string(name->get_string());
+}
+
+void CgenNode::add_child(CgenNodeP child) {
+    children = new List<CgenNode>(child, children);
+}
+
+void CgenNode::layout(int& next_tag) {
+    m_class_tag = next_tag++;
+    if (parentnd != NULL) {
+        m_attrib_idx_tab = parentnd->m_attrib_idx_tab;
+        m_method_idx_tab = parentnd->m_method_idx_tab;
+        m_attrib_count = parentnd->m_attrib_count;
+        m_method_count = parentnd->m_method_count;
+        m_attribs = parentnd->m_attribs;
+        m_methods = parentnd->m_methods;
+    }
+    for (int i = features->first(); features->more(i); i = features->next(i)) {
+        Feature f = features->nth(i);
+        if (f->is_method_node()) {
+            method_class *m = static_cast<method_class *>(f);
+            int slot = resolve_method_offset(m->name);
+            if (slot < 0) {
+                slot = m_method_count++;
+                m_methods.push_back(m->name);
+            }
+            SetMethodOffset(m->name, name, slot);
+        } else {
+            attr_class *a = static_cast<attr_class *>(f);
+            SetAttribOffset(a->name, m_attrib_count++);
+            m_attribs.push_back(a);
+        }
+    }
+    for (List<CgenNode> *l = children; l != NULL; l = l->tl()) {
+        l->hd()->layout(next_tag);
+    }
+    m_last_tag = next_tag - 1;
+}
+
+//
+// 基本类 Object, IO, Int, Bool, String 的方法由运行时提供, 这里只建立
+// 它们的特征, 以便计算偏移并生成原型对象与分派表.
+// 其中 _prim_slot 类型的属性为运行时所用的原始值槽位.
+//
+void CgenClassTable::install_basic_classes() {
+    Symbol filename = stringtable.add_string("<basic class>");
+    Symbol arg = predef_symbol(PREDEF_arg), arg2 = predef_symbol(PREDEF_arg2);
+
+    // Object: abort(), type_name(), copy()
+    install_class(
+        new CgenNode(
+            class_(Object, No_class,
+                   append_Features(
+                       append_Features(
+                           single_Features(method(predef_symbol(PREDEF_cool_abort), nil_Formals(), Object, no_expr())),
+                           single_Features(method(predef_symbol(PREDEF_type_name), nil_Formals(), Str, no_expr()))),
+                       single_Features(method(predef_symbol(PREDEF_copy), nil_Formals(), SELF_TYPE, no_expr()))),
+                   filename),
+            Basic, this));
+
+    // IO: out_string(Str), out_int(Int), in_string(), in_int()
+    install_class(
+        new CgenNode(
+            class_(IO, Object,
+                   append_Features(
+                       append_Features(
+                           append_Features(
+                               single_Features(method(predef_symbol(PREDEF_out_string), single_Formals(formal(arg, Str)),
+                                                      SELF_TYPE, no_expr())),
+                               single_Features(method(predef_symbol(PREDEF_out_int), single_Formals(formal(arg, Int)),
+                                                      SELF_TYPE, no_expr()))),
+                           single_Features(method(predef_symbol(PREDEF_in_string), nil_Formals(), Str, no_expr()))),
+                       single_Features(method(predef_symbol(PREDEF_in_int), nil_Formals(), Int, no_expr()))),
+                   filename),
+            Basic, this));
+
+    // Int: 一个原始值槽位
+    install_class(
+        new CgenNode(
+            class_(Int, Object,
+                   single_Features(attr(predef_symbol(PREDEF_val), prim_slot, no_expr())),
+                   filename),
+            Basic, this));
+
+    // Bool: 同 Int
+    install_class(
+        new CgenNode(
+            class_(Bool, Object,
+                   single_Features(attr(predef_symbol(PREDEF_val), prim_slot, no_expr())),
+                   filename),
+            Basic, this));
+
+    // String: 长度 (Int) 与字符内容; length(), concat(Str), substr(Int, Int)
+    install_class(
+        new CgenNode(
+            class_(Str, Object,
+                   append_Features(
+                       append_Features(
+                           append_Features(
+                               append_Features(
+                                   single_Features(attr(predef_symbol(PREDEF_val), Int, no_expr())),
+                                   single_Features(attr(predef_symbol(PREDEF_str_field), prim_slot, no_expr()))),
+                               single_Features(method(predef_symbol(PREDEF_length), nil_Formals(), Int, no_expr()))),
+                           single_Features(method(predef_symbol(PREDEF_concat),
+                                                  single_Formals(formal(arg, Str)),
+                                                  Str,
+                                                  no_expr()))),
+                       single_Features(method(predef_symbol(PREDEF_substr),
+                                              append_Formals(single_Formals(formal(arg, Int)),
+                                                             single_Formals(formal(arg2, Int))),
+                                              Str,
+                                              no_expr()))),
+                   filename),
+            Basic, this));
+}
+
+void CgenClassTable::install_class(CgenNodeP nd) {
+    Symbol name = nd->get_name();
+    if (lookup(name) != NULL) {
+        return;
+    }
+    nds = new List<CgenNode>(nd, nds);
+    m_class_nodes.push_back(nd);
+    AddClass(name, nd);
+}
+
+void CgenClassTable::install_classes(Classes cs) {
+    for (int i = cs->first(); cs->more(i); i = cs->next(i)) {
+        install_class(new CgenNode(cs->nth(i), NotBasic, this));
+    }
+}
+
+void CgenClassTable::build_inheritance_tree() {
+    for (CgenNodeP nd : m_class_nodes) {
+        CgenNodeP parent = lookup(nd->get_parent());
+        if (parent != NULL) {
+            nd->set_parentnd(parent);
+            parent->add_child(nd);
+        }
+    }
+}
+
+CgenNodeP CgenClassTable::root() {
+    return lookup(Object);
+}
+
+CgenClassTable::CgenClassTable(Classes classes, ostream& s) : nds(NULL), str(s) {
+    active_codegen_table = this;
+    install_basic_classes();
+    install_classes(classes);
+    build_inheritance_tree();
+    // 自根类向下计算偏移并编号; 没有父类的类各自作为根
+    int next_tag = 0;
+    for (CgenNodeP nd : m_class_nodes) {
+        if (nd->get_parentnd() == NULL) {
+            nd->layout(next_tag);
+        }
+    }
+    // 此后 m_class_nodes 按 class tag 排列, 与 class_nameTab/class_objTab 一致
+    std::sort(m_class_nodes.begin(), m_class_nodes.end(),
+              [](CgenNodeP a, CgenNodeP b) { return a->GetClassTag() < b->GetClassTag(); });
+    for (CgenNodeP nd : m_class_nodes) {
+        m_class_tags.insert(nd->get_name(), nd->GetClassTag());
+    }
+    stringclasstag = GetClassTag(Str);
+    intclasstag = GetClassTag(Int);
+    boolclasstag = GetClassTag(Bool);
+    code();
+}
+
+void program_class::cgen(ostream& os) {
+    CgenClassTable *codegen_classtable = new CgenClassTable(classes, os);
+    (void) codegen_classtable;
+    os << "\n# end of generated code\n";
+}
+
+//******************************************************************
+// 全局数据与常量 (与课程框架相同)
+//******************************************************************
+
+BoolConst::BoolConst(int i) : val(i) { assert(i == 0 || i == 1); }
+
+void BoolConst::code_ref(ostream& s) const {
+    s << BOOLCONST_PREFIX << val;
+}
+
+void BoolConst::code_def(ostream& s, int boolclasstag) {
+    s << WORD << "-1" << endl;
+    code_ref(s);  s << LABEL
+      << WORD << boolclasstag << endl
+      << WORD << (DEFAULT_OBJFIELDS + BOOL_SLOTS) << endl
+      << WORD << BOOLNAME << DISPTAB_SUFFIX << endl
+      << WORD << val << endl;
+}
+
+void CgenClassTable::code_global_data() {
+    str << "\t.data\n" << ALIGN;
+    // 运行时需要引用的全局名
+    str << GLOBAL << CLASSNAMETAB << endl;
+    str << GLOBAL; emit_protobj_ref(Main, str);  str << endl;
+    str << GLOBAL; emit_protobj_ref(Int, str);   str << endl;
+    str << GLOBAL; emit_protobj_ref(Str, str);   str << endl;
+    str << GLOBAL; falsebool.code_ref(str);      str << endl;
+    str << GLOBAL; truebool.code_ref(str);       str << endl;
+    str << GLOBAL << INTTAG << endl;
+    str << GLOBAL << BOOLTAG << endl;
+    str << GLOBAL << STRINGTAG << endl;
+
+    // 运行时据此识别基本类的对象
+    str << INTTAG << LABEL << WORD << intclasstag << endl;
+    str << BOOLTAG << LABEL << WORD << boolclasstag << endl;
+    str << STRINGTAG << LABEL << WORD << stringclasstag << endl;
+}
+
+void CgenClassTable::code_global_text() {
+    str << GLOBAL << HEAP_START << endl
+        << HEAP_START << LABEL
+        << WORD << 0 << endl
+        << "\t.text" << endl
+        << GLOBAL;
+    emit_init_ref(Main, str);
+    str << endl << GLOBAL;
+    emit_init_ref(Int, str);
+    str << endl << GLOBAL;
+    emit_init_ref(Str, str);
+    str << endl << GLOBAL;
+    emit_init_ref(Bool, str);
+    str << endl << GLOBAL;
+    emit_method_ref(Main, predef_symbol(PREDEF_main_meth), str);
+    str << endl;
+}
+
+void CgenClassTable::code_bools(int boolclasstag) {
+    falsebool.code_def(str, boolclasstag);
+    truebool.code_def(str, boolclasstag);
+}
+
+void CgenClassTable::code_select_gc() {
+    // 选择垃圾回收器
+    str << GLOBAL << "_MemMgr_INITIALIZER" << endl;
+    str << "_MemMgr_INITIALIZER:" << endl;
+    str << WORD << gc_init_names[cgen_Memmgr] << endl;
+    str << GLOBAL << "_MemMgr_COLLECTOR" << endl;
+    str << "_MemMgr_COLLECTOR:" << endl;
+    str << WORD << gc_collect_names[cgen_Memmgr] << endl;
+    str << GLOBAL << "_MemMgr_TEST" << endl;
+    str << "_MemMgr_TEST:" << endl;
+    str << WORD << (cgen_Memmgr_Test == GC_TEST) << endl;
+}
+
+void CgenClassTable::code_constants() {
+    // 属性的默认值要用到空串与 0
+    stringtable.add_string("");
+    inttable.add_string("0");
+
+    stringtable.code_string_table(str, stringclasstag);
+    inttable.code_string_table(str, intclasstag);
+    code_bools(boolclasstag);
+}
+
+//******************************************************************
+// 类辅助表: 均按 class tag 顺序 (m_class_nodes 的顺序) 生成
+//******************************************************************
+
+void CgenClassTable::code_class_nameTab() {
+    str << CLASSNAMETAB << LABEL;
+    for (CgenNodeP nd : m_class_nodes) {
+        str << WORD;
+        stringtable.lookup_string(nd->get_name()->get_string())->code_ref(str);
+        str << endl;
+    }
+}
+
+void CgenClassTable::code_class_objTab() {
+    str << CLASSOBJTAB << LABEL;
+    for (CgenNodeP nd : m_class_nodes) {
+        str << WORD;  emit_protobj_ref(nd->get_name(), str);  str << endl;
+        str << WORD;  emit_init_ref(nd->get_name(), str);     str << endl;
+    }
+}
+
+void CgenClassTable::code_dispatchTabs() {
+    for (CgenNodeP nd : m_class_nodes) {
+        nd->code_dispatch_table(str);
+    }
+}
+
+void CgenClassTable::code_protObjs() {
+    for (CgenNodeP nd : m_class_nodes) {
+        nd->code_prototype(str);
+    }
+}
+
+void CgenClassTable::code_class_inits() {
+    for (CgenNodeP nd : m_class_nodes) {
+        nd->code_init(str);
+    }
+}
+
+// 基本类的方法由运行时提供
+void CgenClassTable::code_class_methods() {
+    for (CgenNodeP nd : m_class_nodes) {
+        if (!nd->basic()) {
+            nd->code_methods(str);
+        }
+    }
+}
+
+void CgenNode::code_dispatch_table(ostream& s) {
+    emit_disptable_ref(name, s);  s << LABEL;
+    for (Symbol m : m_methods) {
+        s << WORD;
+        emit_method_ref(m_method_idx_tab.find(m)->first, m, s);
+        s << endl;
+    }
+}
+
+void CgenNode::code_prototype(ostream& s) {
+    s << WORD << "-1" << endl;                       // eye catcher
+    emit_protobj_ref(name, s);  s << LABEL
+      << WORD << m_class_tag << endl
+      << WORD << (DEFAULT_OBJFIELDS + m_attrib_count) << endl
+      << WORD;  emit_disptable_ref(name, s);  s << endl;
+    // 属性的默认值: Int/String/Bool 为各自的常量, 其余 (含原始值槽位) 为 0
+    for (attr_class *a : m_attribs) {
+        s << WORD;
+        if (a->type_decl == Int) {
+            inttable.lookup_string("0")->code_ref(s);
+        } else if (a->type_decl == Str) {
+            stringtable.lookup_string("")->code_ref(s);
+        } else if (a->type_decl == Bool) {
+            falsebool.code_ref(s);
+        } else {
+            s << EMPTYSLOT;
+        }
+        s << endl;
+    }
+}
+
+// 初始化函数: 先调用父类的初始化, 再依次求值本类属性的初值
+void CgenNode::code_init(ostream& s) {
+    emit_init_ref(name, s);  s << LABEL;
+    emit_addiu(SP, SP, -12, s);
+    emit_store(FP, 3, SP, s);
+    emit_store(SELF, 2, SP, s);
+    emit_store(RA, 1, SP, s);
+    emit_addiu(FP, SP, 4, s);
+    emit_move(SELF, ACC, s);
+
+    if (parentnd != NULL) {
+        std::string parent_init = std::string(parentnd->get_name()->get_string()) + CLASSINIT_SUFFIX;
+        emit_jal((char*)parent_init.c_str(), s);
+    }
+    TranslationContext context(this);
+    for (int i = features->first(); features->more(i); i = features->next(i)) {
+        Feature f = features->nth(i);
+        if (f->is_method_node()) {
+            continue;
+        }
+        attr_class *a = static_cast<attr_class *>(f);
+        if (a->init->get_kind() == NODE_no_expr) {
+            continue;
+        }
+        a->init->produce_code(s, context);
+        int attr_offset = resolve_attribute_offset(a->name);
+        emit_store(ACC, attr_offset + 3, SELF, s);
+        if (cgen_Memmgr == GC_GENGC) {
+            emit_addiu(A1, SELF, (attr_offset + 3) * 4, s);
+            emit_gc_assign(s);
+        }
+    }
+
+    emit_move(ACC, SELF, s);
+    emit_load(FP, 3, SP, s);
+    emit_load(SELF, 2, SP, s);
+    emit_load(RA, 1, SP, s);
+    emit_addiu(SP, SP, 12, s);
+    emit_return(s);
+}
+
+void CgenNode::code_methods(ostream& s) {
+    for (int i = features->first(); features->more(i); i = features->next(i)) {
+        Feature f = features->nth(i);
+        if (f->is_method_node()) {
+            method_class *m = static_cast<method_class *>(f);
+            emit_method_ref(name, m->name, s);  s << LABEL;
+            m->produce_code(s, this);
+        }
+    }
 }
 
 //******************************************************************
@@ -532,5 +1386,3 @@ void CgenClassTable::code() {
     code_class_inits();
     code_class_methods();
 }
-
-
@@ -9,6 +9,7 @@
 #include "emit.h"
 #include "cool-tree.h"
 #include "symtab.h"
+#include "symbolmap.h"
 
 enum Basicness { Basic, NotBasic };
 #define TRUE 1
@@ -73,7 +74,28 @@ public:
     CgenNode* get_class_context() { return _current_class; }
 };
 
-class CgenClassTable : public SymbolTable<Symbol, CgenNode> {
+/**
+ * @brief 表达式翻译的显式栈遍历 (见 walkstack.h)
+ * 同一阶段内 code() 的子表达式按压入的逆序生成
+ */
+class CodeWalk {
+private:
+    ExpressionWalk _walk;
+
+public:
+    ostream& s;
+    TranslationContext& context;
+
+    CodeWalk(ostream& str, TranslationContext& ctx) : s(str), context(ctx) {}
+
+    void run(Expression e);
+    void code(Expression e) { _walk.push(e); }
+    void code_list(Expressions l) { _walk.push_list(l); }
+    // 子表达式生成完毕后以 stage 回到 e, label 随之带回
+    void resume(Expression e, int stage, int label = 0) { _walk.push(e, stage, label); }
+};
+
+class CgenClassTable {
 private:
     List<CgenNode> *nds;
     ostream& str;
@@ -81,7 +103,9 @@ private:
     int intclasstag;
     int boolclasstag;
     std::vector<CgenNode*> m_class_nodes;
-    std::map<Symbol, int> m_class_tags;
+    // 按符号下标直接索引的侧表 (见 symbolmap.h)
+    SymbolMap<CgenNodeP> m_class_by_name;
+    SymbolMap<int> m_class_tags;
 
     void code_global_data();
     void code_global_text();
@@ -95,13 +119,28 @@ private:
     void code_class_inits();
     void code_class_methods();
 
+    void install_basic_classes();
+    void install_class(CgenNodeP nd);
+    void install_classes(Classes cs);
+    void build_inheritance_tree();
+
 public:
     CgenClassTable(Classes, ostream& str);
     void code();
     CgenNodeP root();
     
     std::vector<CgenNode*> GetClassNodes() { return m_class_nodes; }
-    int GetClassTag(Symbol class_name) { return m_class_tags[class_name]; }
+    int GetClassTag(Symbol class_name) {
+        int *tag = m_class_tags.find(class_name);
+        return tag ? *tag : -1;
+    }
+
+    void AddClass(Symbol name, CgenNodeP nd) { m_class_by_name.insert(name, nd); }
+    CgenNodeP lookup(Symbol name) {
+        CgenNodeP *nd = m_class_by_name.find(name);
+        return nd ? *nd : NULL;
+    }
+    CgenNodeP probe(Symbol name) { return lookup(name); }
 };
 
 class CgenNode : public class__class {
@@ -110,8 +149,13 @@ private:
     List<CgenNode> *children;                  
     Basicness basic_status;                    
     int m_class_tag;
-    std::map<Symbol, int> m_attrib_idx_tab;
-    std::map<Symbol, std::pair<Symbol, int>> m_method_idx_tab;
+    int m_last_tag;                                       // 子孙中最大的 class tag
+    int m_attrib_count;                                   // 含继承的属性个数
+    int m_method_count;                                   // 分派表长度
+    SymbolMap<int> m_attrib_idx_tab;                      // 属性名 -> 对象内偏移
+    SymbolMap<std::pair<Symbol, int>> m_method_idx_tab;   // 方法名 -> (定义类, 分派表偏移)
+    std::vector<attr_class*> m_attribs;                   // 对象内偏移 -> 属性
+    std::vector<Symbol> m_methods;                        // 分派表偏移 -> 方法名
 
 public:
     CgenNode(Class_ c, Basicness bstatus, CgenClassTableP class_table);
@@ -120,16 +164,36 @@ public:
     List<CgenNode> *get_children() { return children; }
     void set_parentnd(CgenNodeP p) { parentnd = p; }
     CgenNodeP get_parentnd() { return parentnd; }
+    int basic() { return (basic_status == Basic); }
     
     int GetClassTag() { return m_class_tag; }
-    void SetClassTag(int tag) { m_class_tag = tag; }
+    int GetLastTag() { return m_last_tag; }
 
     // 提供给 TranslationContext 使用的元数据访问接口
     int resolve_attribute_offset(Symbol sym);
     int resolve_method_offset(Symbol sym);
+    void SetAttribOffset(Symbol sym, int idx) { m_attrib_idx_tab.insert(sym, idx); }
+    void SetMethodOffset(Symbol sym, Symbol owner, int idx) {
+        m_method_idx_tab.insert(sym, std::make_pair(owner, idx));
+    }
+    // 继承父类的偏移表并加入本类的特征, 再递归到子类 (父类须先完成);
+    // 本类与子孙按先序自 next_tag 起编号
+    void layout(int& next_tag);
     
+    void code_dispatch_table(ostream& s);
+    void code_prototype(ostream& s);
     void code_init(ostream& s);
     void code_methods(ostream& s);
 };
 
+class BoolConst 
+{
+ private: 
+  int val;
+ public:
+  BoolConst(int);
+  void code_def(ostream&, int boolclasstag);
+  void code_ref(ostream&) const;
+};
+
 #endif
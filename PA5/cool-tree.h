@@ -12,6 +12,7 @@
 #include <vector>
 
 class TranslationContext;
+class CgenNode;
 
 // ---------------------------------------------------------------------
 // 基础 Phylum 定义：Program
@@ -105,6 +106,49 @@ public:
 #endif
 };
 
+// ---------------------------------------------------------------------
+// 程序与类节点：program_class, class__class
+// ---------------------------------------------------------------------
+class program_class : public Program_class {
+public:
+   Classes classes;
+public:
+   friend class TreeWalk;
+   program_class(Classes a1) {
+      kind = NODE_program;
+      classes = a1;
+   }
+   Program copy_Program();
+   void dump(ostream& stream, int n);
+
+#ifdef program_EXTRAS
+   program_EXTRAS
+#endif
+};
+
+class class__class : public Class__class {
+public:
+   Symbol name;
+   Symbol parent;
+   Features features;
+   Symbol filename;
+public:
+   friend class TreeWalk;
+   class__class(Symbol a1, Symbol a2, Features a3, Symbol a4) {
+      kind = NODE_class_;
+      name = a1;
+      parent = a2;
+      features = a3;
+      filename = a4;
+   }
+   Class_ copy_Class_();
+   void dump(ostream& stream, int n);
+
+#ifdef class__EXTRAS
+   class__EXTRAS
+#endif
+};
+
 // ---------------------------------------------------------------------
 // 核心逻辑：method_class (方法节点)
 // ---------------------------------------------------------------------
@@ -117,7 +161,9 @@ public:
    Expression expr;
 public:
    method_class(Symbol a1, Formals a2, Symbol a3, Expression a4) :
-     name(a1), formals(a2), return_type(a3), expr(a4) {}
+     name(a1), formals(a2), return_type(a3), expr(a4) {
+      kind = NODE_method;
+   }
 
    Feature copy_Feature();
    void dump(ostream& stream, int n);
@@ -130,16 +176,12 @@ public:
     * 包括固定的 FP, SELF, RA (12字节) 以及所有参数压栈空间
     */
    int calculate_activation_record_size() {
-      int formal_count = 0;
-      for (int i = formals->first(); formals->more(i); i = formals->next(i)) {
-          formal_count++;
-      }
       // 3个固定寄存器槽位 (12 bytes) + 参数数量 * 4
-      return 12 + (formal_count * 4);
+      return 12 + (formals->len() * 4);
    }
 
    // 配合 TranslationContext 的新生成接口
-   void emit_mips_asm(ostream& stream, CgenNode* host_class);
+   void produce_code(ostream& stream, CgenNode* host_class);
 
 #ifdef Feature_SHARED_EXTRAS
    Feature_SHARED_EXTRAS
@@ -159,6 +201,7 @@ public:
    Expression init;
 public:
    attr_class(Symbol a1, Symbol a2, Expression a3) {
+      kind = NODE_attr;
       name = a1;
       type_decl = a2;
       init = a3;
@@ -175,6 +218,49 @@ public:
 #endif
 };
 
+// ---------------------------------------------------------------------
+// 形参与 case 分支：formal_class, branch_class
+// ---------------------------------------------------------------------
+class formal_class : public Formal_class {
+public:
+   Symbol name;
+   Symbol type_decl;
+public:
+   friend class TreeWalk;
+   formal_class(Symbol a1, Symbol a2) {
+      kind = NODE_formal;
+      name = a1;
+      type_decl = a2;
+   }
+   Formal copy_Formal();
+   void dump(ostream& stream, int n);
+
+#ifdef formal_EXTRAS
+   formal_EXTRAS
+#endif
+};
+
+class branch_class : public Case_class {
+public:
+   Symbol name;
+   Symbol type_decl;
+   Expression expr;
+public:
+   friend class TreeWalk;
+   branch_class(Symbol a1, Symbol a2, Expression a3) {
+      kind = NODE_branch;
+      name = a1;
+      type_decl = a2;
+      expr = a3;
+   }
+   Case copy_Case();
+   void dump(ostream& stream, int n);
+
+#ifdef branch_EXTRAS
+   branch_EXTRAS
+#endif
+};
+
 // ---------------------------------------------------------------------
 // 表达式子类：assign_class (赋值)
 // ---------------------------------------------------------------------
@@ -184,17 +270,12 @@ public:
    Expression expr;
 public:
    assign_class(Symbol a1, Expression a2) {
+      kind = NODE_assign;
       name = a1;
       expr = a2;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   
-   /**
-    * @brief 翻译赋值逻辑
-    * 222
-    */
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -215,6 +296,7 @@ public:
    Expressions actual;
 public:
    static_dispatch_class(Expression a1, Symbol a2, Symbol a3, Expressions a4) {
+      kind = NODE_static_dispatch;
       expr = a1;
       type_name = a2;
       name = a3;
@@ -222,7 +304,6 @@ public:
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -242,18 +323,13 @@ public:
    Expressions actual;
 public:
    dispatch_class(Expression a1, Symbol a2, Expressions a3) {
+      kind = NODE_dispatch;
       expr = a1;
       name = a2;
       actual = a3;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   
-   /**
-    * @brief 翻译分派逻辑
-    * 222
-    */
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -273,18 +349,13 @@ public:
    Expression else_exp;
 public:
    cond_class(Expression a1, Expression a2, Expression a3) {
+      kind = NODE_cond;
       pred = a1;
       then_exp = a2;
       else_exp = a3;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   
-   /**
-    * @brief 条件跳转生成
-    * 使用独立的 label 生成器
-    */
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -303,12 +374,12 @@ public:
    Expression body;
 public:
    loop_class(Expression a1, Expression a2) {
+      kind = NODE_loop;
       pred = a1;
       body = a2;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -327,12 +398,12 @@ public:
    Cases cases;
 public:
    typcase_class(Expression a1, Cases a2) {
+      kind = NODE_typcase;
       expr = a1;
       cases = a2;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -350,11 +421,11 @@ public:
    Expressions body;
 public:
    block_class(Expressions a1) {
+      kind = NODE_block;
       body = a1;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -375,6 +446,7 @@ public:
    Expression body;
 public:
    let_class(Symbol a1, Symbol a2, Expression a3, Expression a4) {
+      kind = NODE_let;
       identifier = a1;
       type_decl = a2;
       init = a3;
@@ -383,11 +455,6 @@ public:
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   /**
-    * @brief 翻译 Let 绑定
-    * 111
-    */
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -406,12 +473,12 @@ public:
    Expression e2;
 public:
    plus_class(Expression a1, Expression a2) {
+      kind = NODE_plus;
       e1 = a1;
       e2 = a2;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -427,12 +494,12 @@ public:
    Expression e2;
 public:
    sub_class(Expression a1, Expression a2) {
+      kind = NODE_sub;
       e1 = a1;
       e2 = a2;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -448,12 +515,12 @@ public:
    Expression e2;
 public:
    mul_class(Expression a1, Expression a2) {
+      kind = NODE_mul;
       e1 = a1;
       e2 = a2;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -469,12 +536,12 @@ public:
    Expression e2;
 public:
    divide_class(Expression a1, Expression a2) {
+      kind = NODE_divide;
       e1 = a1;
       e2 = a2;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -489,11 +556,11 @@ public:
    Expression e1;
 public:
    neg_class(Expression a1) {
+      kind = NODE_neg;
       e1 = a1;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -509,12 +576,12 @@ public:
    Expression e2;
 public:
    lt_class(Expression a1, Expression a2) {
+      kind = NODE_lt;
       e1 = a1;
       e2 = a2;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -530,12 +597,12 @@ public:
    Expression e2;
 public:
    eq_class(Expression a1, Expression a2) {
+      kind = NODE_eq;
       e1 = a1;
       e2 = a2;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -551,12 +618,12 @@ public:
    Expression e2;
 public:
    leq_class(Expression a1, Expression a2) {
+      kind = NODE_leq;
       e1 = a1;
       e2 = a2;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -571,11 +638,11 @@ public:
    Expression e1;
 public:
    comp_class(Expression a1) {
+      kind = NODE_comp;
       e1 = a1;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -591,11 +658,11 @@ public:
    Symbol token;
 public:
    int_const_class(Symbol a1) {
+      kind = NODE_int_const;
       token = a1;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -610,11 +677,11 @@ public:
    Boolean val;
 public:
    bool_const_class(Boolean a1) {
+      kind = NODE_bool_const;
       val = a1;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -629,11 +696,11 @@ public:
    Symbol token;
 public:
    string_const_class(Symbol a1) {
+      kind = NODE_string_const;
       token = a1;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -648,16 +715,12 @@ public:
    Symbol name;
 public:
    object_class(Symbol a1) {
+      kind = NODE_object;
       name = a1;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
 
-   /**
-    * @brief 翻译变量加载逻辑
-    * 111
-    */
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -672,11 +735,11 @@ public:
    Symbol type_name;
 public:
    new__class(Symbol a1) {
+      kind = NODE_new_;
       type_name = a1;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -691,11 +754,11 @@ public:
    Expression e1;
 public:
    isvoid_class(Expression a1) {
+      kind = NODE_isvoid;
       e1 = a1;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -707,15 +770,11 @@ public:
 
 class no_expr_class : public Expression_class {
 public:
-   no_expr_class() {}
+   no_expr_class() {
+      kind = NODE_no_expr;
+   }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
-   
-   /**
-    * @brief 空表达式生成
-    * 111
-    */
-   void produce_code(ostream& s, CodeGenManager& manager);
 
 #ifdef Expression_SHARED_EXTRAS
    Expression_SHARED_EXTRAS
@@ -745,4 +804,35 @@ Expression let(Symbol, Symbol, Expression, Expression);
 Expression plus(Expression, Expression);
 Expression sub(Expression, Expression);
 Expression mul(Expression, Expression);
-Expression divide(Expression, Expression
+Expression divide(Expression, Expression);
+Expression neg(Expression);
+Expression lt(Expression, Expression);
+Expression eq(Expression, Expression);
+Expression leq(Expression, Expression);
+Expression comp(Expression);
+Expression int_const(Symbol);
+Expression bool_const(Boolean);
+Expression string_const(Symbol);
+Expression new_(Symbol);
+Expression isvoid(Expression);
+Expression no_expr();
+Expression object(Symbol);
+
+Classes nil_Classes();
+Classes single_Classes(Class_);
+Classes append_Classes(Classes, Classes);
+Features nil_Features();
+Features single_Features(Feature);
+Features append_Features(Features, Features);
+Formals nil_Formals();
+Formals single_Formals(Formal);
+Formals append_Formals(Formals, Formals);
+Expressions nil_Expressions();
+Expressions single_Expressions(Expression);
+Expressions append_Expressions(Expressions, Expressions);
+Cases nil_Cases();
+Cases single_Cases(Case);
+Cases append_Cases(Cases, Cases);
+
+#endif
+
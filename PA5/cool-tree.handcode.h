@@ -5,12 +5,14 @@
 #include "tree.h"
 #include "cool.h"
 #include "stringtab.h"
+#include "walkstack.h"
 
 // 宏定义：同步当前行号
 #define yylineno curr_lineno;
 extern int yylineno;
 
-class CodeGenManager; 
+class TranslationContext;
+class CodeWalk;
 
 inline Boolean copy_Boolean(Boolean b) { return b; }
 inline void assert_Boolean(Boolean) {}
@@ -46,6 +48,9 @@ typedef Expressions_class *Expressions;
 typedef list_node<Case> Cases_class;
 typedef Cases_class *Cases;
 
+// see walkstack.h
+typedef WalkStack<Expression> ExpressionWalk;
+
 // Program 扩展：核心生成入口
 #define Program_EXTRAS                          \
 virtual void cgen(ostream&) = 0;                \
@@ -68,40 +73,45 @@ Symbol get_parent() { return parent; }          \
 Symbol get_filename() { return filename; }      \
 void dump_with_types(ostream&, int);            
 
-// Feature 扩展：区分属性与方法声明
+// Feature 扩展 (属性与方法由 cool-tree.h 中的 is_method_node 区分)
 #define Feature_EXTRAS                                        \
-virtual void dump_with_types(ostream&, int) = 0;              \
-virtual bool is_method_decl() const = 0;                      
+virtual void dump_with_types(ostream&, int) = 0;
 
 #define Feature_SHARED_EXTRAS                                 \
-void dump_with_types(ostream&, int);                          \
-bool is_method_decl() const; 
+void dump_with_types(ostream&, int);
 
 // Formal 扩展
 #define Formal_EXTRAS                                         \
+virtual Symbol get_name() = 0;                                \
 virtual void dump_with_types(ostream&, int) = 0;
 
 #define formal_EXTRAS                                         \
+Symbol get_name() { return name; }                            \
 void dump_with_types(ostream&, int);
 
 // Case 扩展
 #define Case_EXTRAS                                           \
-virtual void dump_with_types(ostream&, int) = 0;
+virtual void dump_with_types(ostream&, int) = 0;              \
+virtual Expression dump_with_types_head(ostream&, int) = 0;
 
 #define branch_EXTRAS                                         \
-void dump_with_types(ostream&, int);
+void dump_with_types(ostream&, int);                          \
+Expression dump_with_types_head(ostream&, int);
 
 #define Expression_EXTRAS                                     \
 Symbol type;                                                  \
 Symbol get_type() { return type; }                            \
-Expression set_type(Symbol s) { type = s; return this; }      \
-virtual void produce_code(ostream&, CodeGenManager&) = 0;     \
-virtual void dump_with_types(ostream&, int) = 0;              \
+Expression set_type(Symbol s)               \
+  { if (type == s) return this;             \
+    Expression e = is_shared() ? copy_Expression() : this; \
+    e->type = s; return e; }                \
+void produce_code(ostream&, TranslationContext&);             \
+void dump_with_types(ostream&, int);                          \
 void dump_type(ostream&, int);                                \
 Expression_class() { type = (Symbol) NULL; }
 
 #define Expression_SHARED_EXTRAS                              \
-void produce_code(ostream&, CodeGenManager&);                 \
-void dump_with_types(ostream&, int); 
+void code_step(CodeWalk&, int, int);                          \
+void dump_with_types_step(ostream&, int, int, ExpressionWalk&); 
 
 #endif
@@ -5,6 +5,9 @@
 #include "copyright.h"
 
 #include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
 #include "stringtab_functions.h"
 #include "stringtab.h"
 
@@ -18,10 +21,51 @@ template class StringTable<IdEntry>;
 template class StringTable<StringEntry>;
 template class StringTable<IntEntry>;
 
-Entry::Entry(char *s, int l, int i) : len(l), index(i) {
-  str = new char [len+1];
-  strncpy(str, s, len);
-  str[len] = '\0';
+//
+// The entry refers to s directly; StringTable has already copied the
+// text into its arena right behind the entry.
+//
+Entry::Entry(char *s, int l, int i) : str(s), len(l), index(i), hash(0) { }
+
+//
+// Start a new block big enough for n bytes.  Requests larger than a
+// quarter block get a block of their own, linked behind the current
+// one so the rest of the current block stays in use.
+//
+void *StringArena::refill(size_t n)
+{
+  size_t hdr = (sizeof(Block) + ALIGN - 1) & ~(size_t) (ALIGN - 1);
+
+  if (n > BLOCK_SIZE / 4) {
+    Block *b = (Block *) malloc(hdr + n);
+    assert(b != NULL);
+    if (blocks) {
+      b->next = blocks->next;
+      blocks->next = b;
+    } else {
+      b->next = NULL;
+      blocks = b;
+    }
+    return (char *) b + hdr;
+  }
+
+  Block *b = (Block *) malloc(BLOCK_SIZE);
+  assert(b != NULL);
+  b->next = blocks;
+  blocks = b;
+  cur = (char *) b + hdr + n;
+  limit = (char *) b + BLOCK_SIZE;
+  return (char *) b + hdr;
+}
+
+void StringArena::release()
+{
+  while (blocks) {
+    Block *next = blocks->next;
+    free(blocks);
+    blocks = next;
+  }
+  cur = limit = NULL;
 }
 
 int Entry::equal_string(char *string, int length) const
@@ -70,9 +114,178 @@ void dump_Symbol(ostream& s, int n, Symbol sym)
   s << pad(n) << sym << endl;
 }
 
-StringEntry::StringEntry(char *s, int l, int i) : Entry(s,l,i) { }
+StringEntry::StringEntry(char *s, int l, int i) :
+  Entry(s,l,i), dump_str(NULL), dump_len(0), asm_str(NULL), asm_len(0) { }
 IdEntry::IdEntry(char *s, int l, int i) : Entry(s,l,i) { }
-IntEntry::IntEntry(char *s, int l, int i) : Entry(s,l,i) { }
+IntEntry::IntEntry(char *s, int l, int i) :
+  Entry(s,l,i), value(0), overflow(false) { }
+
+//
+// Append the n characters at t to out (if there is an out) at position
+// pos, and return the new position.
+//
+static int put(char *out, int pos, const char *t, int n)
+{
+  if (out)
+    memcpy(out + pos, t, n);
+  return pos + n;
+}
+
+//
+// Escape s the way print_escaped_string does: backslash escapes for
+// \\, \", \n, \t, \b and \f, three octal digits for anything else
+// that is not printable.
+//
+int escape_dump_string(const char *s, int len, char *out)
+{
+  int pos = 0;
+  for (int i = 0; i < len; i++) {
+    char c = s[i];
+    switch (c) {
+    case '\\' : pos = put(out, pos, "\\\\", 2); break;
+    case '\"' : pos = put(out, pos, "\\\"", 2); break;
+    case '\n' : pos = put(out, pos, "\\n", 2); break;
+    case '\t' : pos = put(out, pos, "\\t", 2); break;
+    case '\b' : pos = put(out, pos, "\\b", 2); break;
+    case '\f' : pos = put(out, pos, "\\f", 2); break;
+    default:
+      if (isprint(c))
+	pos = put(out, pos, &c, 1);
+      else {
+	unsigned char u = (unsigned char) c;
+	char oct[4] = { '\\', (char) ('0' + (u >> 6)),
+			(char) ('0' + ((u >> 3) & 7)), (char) ('0' + (u & 7)) };
+	pos = put(out, pos, oct, 4);
+      }
+      break;
+    }
+  }
+  return pos;
+}
+
+//
+// Encode s the way emit_string_constant does: runs of plain characters
+// in .ascii directives, backslashes and non-ASCII characters as .byte
+// directives, and a terminating .byte 0.
+//
+int encode_asm_string(const char *s, int len, char *out)
+{
+  static const char ascii_open[] = "\t.ascii\t\"";
+  static const char ascii_close[] = "\"\n";
+  static const char byte_dir[] = "\t.byte\t";
+  int pos = 0;
+  bool ascii = false;
+
+  for (int i = 0; i < len; i++) {
+    unsigned char c = (unsigned char) s[i];
+    const char *esc = NULL;
+    switch (c) {
+    case '\n': esc = "\\n"; break;
+    case '\t': esc = "\\t"; break;
+    case '"' : esc = "\\\""; break;
+    case '\\': break;
+    default:
+      if (c >= ' ' && c < 128) {
+	if (!ascii) { pos = put(out, pos, ascii_open, sizeof(ascii_open) - 1); ascii = true; }
+	char ch = (char) c;
+	pos = put(out, pos, &ch, 1);
+	continue;
+      }
+      break;
+    }
+    if (esc) {
+      if (!ascii) { pos = put(out, pos, ascii_open, sizeof(ascii_open) - 1); ascii = true; }
+      pos = put(out, pos, esc, 2);
+    } else {
+      if (ascii) { pos = put(out, pos, ascii_close, sizeof(ascii_close) - 1); ascii = false; }
+      char num[8];
+      int n = snprintf(num, sizeof(num), "%d\n", c);
+      pos = put(out, pos, byte_dir, sizeof(byte_dir) - 1);
+      pos = put(out, pos, num, n);
+    }
+  }
+  if (ascii)
+    pos = put(out, pos, ascii_close, sizeof(ascii_close) - 1);
+  return put(out, pos, "\t.byte\t0\t\n", 10);
+}
+
+//
+// Both encodings are measured first and then written into the arena,
+// each followed by a '\0'.
+//
+void StringEntry::precompute(StringArena& arena)
+{
+  dump_len = escape_dump_string(str, len, NULL);
+  asm_len = encode_asm_string(str, len, NULL);
+  dump_str = (char *) arena.alloc(dump_len + asm_len + 2);
+  asm_str = dump_str + dump_len + 1;
+  escape_dump_string(str, len, dump_str);
+  dump_str[dump_len] = '\0';
+  encode_asm_string(str, len, asm_str);
+  asm_str[asm_len] = '\0';
+}
+
+//
+// The text is an optional '-' and decimal digits: what the lexer
+// matches as {DIGIT}+, or what add_int wrote.
+//
+void IntEntry::precompute(StringArena& arena)
+{
+  int i = 0;
+  bool negative = (len > 0 && str[0] == '-');
+  if (negative)
+    i++;
+
+  unsigned low = 0;              // the value modulo 2^32
+  unsigned long long v = 0;      // the value, until it is clearly too big
+  for (; i < len && str[i] >= '0' && str[i] <= '9'; i++) {
+    low = low * 10 + (str[i] - '0');
+    if (v <= 0x80000000ull)
+      v = v * 10 + (str[i] - '0');
+  }
+
+  overflow = v > (negative ? 0x80000000ull : 0x7fffffffull);
+  value = (int) (negative ? 0u - low : low);
+}
+
+//
+// The predefined symbols, in PredefSymbol order.  Their hashes are
+// computed by the compiler.
+//
+#define PREDEF(s) { s, sizeof(s) - 1, hash_string(s, sizeof(s) - 1) }
+
+constexpr PredefEntry predefined_symbols[PREDEF_COUNT] = {
+  PREDEF("arg"),
+  PREDEF("arg2"),
+  PREDEF("Bool"),
+  PREDEF("concat"),
+  PREDEF("abort"),
+  PREDEF("copy"),
+  PREDEF("Int"),
+  PREDEF("in_int"),
+  PREDEF("in_string"),
+  PREDEF("IO"),
+  PREDEF("length"),
+  PREDEF("Main"),
+  PREDEF("main"),
+  //   _no_class is a symbol that can't be the name of any
+  //   user-defined class.
+  PREDEF("_no_class"),
+  PREDEF("_no_type"),
+  PREDEF("Object"),
+  PREDEF("out_int"),
+  PREDEF("out_string"),
+  PREDEF("_prim_slot"),
+  PREDEF("self"),
+  PREDEF("SELF_TYPE"),
+  PREDEF("String"),
+  PREDEF("_str_field"),
+  PREDEF("substr"),
+  PREDEF("type_name"),
+  PREDEF("_val"),
+};
+
+#undef PREDEF
 
 IdTable idtable;
 IntTable inttable;
@@ -0,0 +1,394 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _STRINGTAB_H_
+#define _STRINGTAB_H_
+
+#include <assert.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+
+#include "list.h" // list template
+#include "cool-io.h"
+
+class Entry;
+typedef Entry* Symbol;
+
+extern ostream& operator<<(ostream& s, const Entry& sym);
+extern ostream& operator<<(ostream& s, Symbol sym);
+
+//
+// hash_string computes the hash stored in every Entry.  This is 32-bit
+// FNV-1a; it is cheap for the short identifiers that make up most of a
+// table and spreads well enough for linear probing.  It is constexpr so
+// the hashes of the predefined symbols are computed by the compiler.
+//
+constexpr unsigned hash_string(const char *s, int len)
+{
+  unsigned h = 2166136261u;
+  for (int i = 0; i < len; i++) {
+    h ^= (unsigned char) s[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  Predefined Symbols
+//
+//  The names of the basic classes, their methods and attributes, and the
+//  fixed names used by the runtime system.  They are entered into idtable
+//  before anything else, from a table built at compile time, so the
+//  symbol for PREDEF_x always has index PREDEF_x.  predef_symbol fetches
+//  one with an array load, and predef_id maps a symbol back to its
+//  PredefSymbol so callers can switch on it.
+//
+/////////////////////////////////////////////////////////////////////////
+
+enum PredefSymbol {
+  PREDEF_arg,
+  PREDEF_arg2,
+  PREDEF_Bool,
+  PREDEF_concat,
+  PREDEF_cool_abort,
+  PREDEF_copy,
+  PREDEF_Int,
+  PREDEF_in_int,
+  PREDEF_in_string,
+  PREDEF_IO,
+  PREDEF_length,
+  PREDEF_Main,
+  PREDEF_main_meth,
+  PREDEF_No_class,
+  PREDEF_No_type,
+  PREDEF_Object,
+  PREDEF_out_int,
+  PREDEF_out_string,
+  PREDEF_prim_slot,
+  PREDEF_self,
+  PREDEF_SELF_TYPE,
+  PREDEF_Str,
+  PREDEF_str_field,
+  PREDEF_substr,
+  PREDEF_type_name,
+  PREDEF_val,
+  PREDEF_COUNT          // not a symbol; also returned by predef_id
+};
+
+struct PredefEntry {
+  const char *name;
+  int len;
+  unsigned hash;
+};
+
+// defined in stringtab.cc, indexed by PredefSymbol
+extern const PredefEntry predefined_symbols[PREDEF_COUNT];
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  String Arena
+//
+//  StringArena is a bump-pointer allocator owned by each shard of a
+//  string table.  Every entry is placed in the arena together with its
+//  text, header first and characters immediately after, so interning a
+//  string costs no individual heap allocation and symbols created
+//  together sit together in memory.  Nothing is freed piecemeal; all
+//  blocks are released at once when the owning table is destroyed.
+//
+/////////////////////////////////////////////////////////////////////////
+
+class StringArena {
+private:
+  enum { ALIGN = 8, BLOCK_SIZE = 64 * 1024 };
+  struct Block { Block *next; };   // header at the start of each block
+  Block *blocks;                   // every block, most recent first
+  char *cur;                       // next free byte of the current block
+  char *limit;                     // end of the current block
+  void *refill(size_t n);
+public:
+  constexpr StringArena() : blocks(NULL), cur(NULL), limit(NULL) { }
+  ~StringArena() { release(); }
+  StringArena(const StringArena&) = delete;
+  StringArena& operator=(const StringArena&) = delete;
+
+  // n bytes aligned for any Entry; valid until release()
+  void *alloc(size_t n)
+  {
+    n = (n + ALIGN - 1) & ~(size_t) (ALIGN - 1);
+    if ((size_t) (limit - cur) < n)
+      return refill(n);
+    void *p = cur;
+    cur += n;
+    return p;
+  }
+
+  void release();  // free every block at once
+};
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  String Table Entries
+//
+/////////////////////////////////////////////////////////////////////////
+
+class Entry {
+protected:
+  char *str;     // the string
+  int  len;      // the length of the string (without trailing \0)
+  int index;     // a unique index for each string
+  unsigned hash; // hash_string(str, len), filled in by the string table
+public:
+  // s is not copied: it must hold len characters plus a '\0' and live
+  // as long as the entry.  StringTable passes text in its arena.
+  Entry(char *s, int l, int i);
+
+  // is string argument equal to the str of this Entry?
+  int equal_string(char *s, int len) const;
+
+  // is the integer argument equal to the index of this Entry?
+  bool equal_index(int ind) const           { return ind == index; }
+
+  ostream& print(ostream& s) const;
+
+  // Return the str and len components of the Entry.
+  char *get_string() const;
+  int get_len() const;
+  int get_index() const                     { return index; }
+  unsigned get_hash() const                 { return hash; }
+
+  // Called once by the string table when the entry is created, to
+  // compute anything derived from the text.  Subclasses that keep
+  // derived data hide this; extra storage comes from arena.
+  void precompute(StringArena& arena)       { }
+
+  template <class Elem> friend class StringTable;
+};
+
+//
+// There are three kinds of string table entries:
+//   a true string, an string representation of an identifier, and
+//   a string representation of an integer.
+//
+// Having separate tables is convenient for code generation.  Different
+// data definitions are generated for string constants (StringEntry) and
+// integer  constants (IntEntry).  Identifiers (IdEntry) don't produce
+// static data definitions.
+//
+// code_def and code_ref are used by the code to produce definitions and
+// references (respectively) to constants.
+//
+// String and integer constants are encoded once, when they are first
+// interned, rather than every time they are printed or emitted:
+//
+//   StringEntry keeps the string escaped as the lexer and AST dumps
+//   show it (print_escaped_string in utilities.cc), and as the
+//   .ascii/.byte lines of its MIPS data (emit_string_constant in
+//   cgen_supp.cc), so either is written with one write().
+//
+//   IntEntry keeps the value of its decimal text.  A literal that does
+//   not fit in 32 bits is flagged; its value is then the low 32 bits.
+//
+class StringEntry : public Entry {
+protected:
+  char *dump_str;   // escaped for token and AST dumps, without quotes
+  int dump_len;
+  char *asm_str;    // .ascii/.byte directives, ending with .byte 0
+  int asm_len;
+public:
+  void code_def(ostream& str, int stringclasstag);
+  void code_ref(ostream& str);
+  StringEntry(char *s, int l, int);
+  void precompute(StringArena& arena);
+
+  void print_escaped(ostream& s) const      { s.write(dump_str, dump_len); }
+  void code_string(ostream& s) const        { s.write(asm_str, asm_len); }
+  const char *get_escaped() const           { return dump_str; }
+  int get_escaped_len() const               { return dump_len; }
+};
+
+class IdEntry : public Entry {
+public:
+  IdEntry(char *s, int l, int);
+};
+
+class IntEntry: public Entry {
+protected:
+  int value;
+  bool overflow;    // the text does not fit in an int
+public:
+  void code_def(ostream& str, int intclasstag);
+  void code_ref(ostream& str);
+  IntEntry(char *s, int l, int);
+  void precompute(StringArena& arena);
+
+  int get_value() const                     { return value; }
+  bool overflowed() const                   { return overflow; }
+};
+
+// The encoders behind StringEntry.  Each writes the encoding of the len
+// characters at s to out, if out is not NULL, and returns its length.
+int escape_dump_string(const char *s, int len, char *out);
+int encode_asm_string(const char *s, int len, char *out);
+
+typedef StringEntry *StringEntryP;
+typedef IdEntry *IdEntryP;
+typedef IntEntry *IntEntryP;
+
+//////////////////////////////////////////////////////////////////////////
+//
+//  String Tables
+//
+//  A string table may be used by several threads at once (for example
+//  lexers working on different files).  Symbols are never moved or
+//  freed while the table exists, so pointer equality between symbols
+//  keeps working whichever thread interned them.
+//
+//  Strings are found through an open-addressing hash index (linear
+//  probing, power-of-two size, kept at most half full) split into
+//  NSHARDS shards by the top bits of the hash.  Looking a string up
+//  takes no lock: a shard's slots are read with acquire loads, and an
+//  entry is only published into a slot once it is complete.  Adding a
+//  string that is not present takes the lock of its shard alone, looks
+//  again, and inserts.  A shard that fills up builds a larger index and
+//  publishes it with one pointer store; the old one is kept until the
+//  table is destroyed, since a reader may still be probing it.  Each
+//  shard allocates its entries and their text from its own StringArena.
+//
+//  Indices come from one atomic counter, so they stay dense.  Entry i is
+//  kept in a segmented array whose segments never move, and lookup(i)
+//  is two loads.  Iterating over (or printing) a table while other
+//  threads are adding to it is not supported.
+//
+//  The constructor is constexpr so the global tables below are
+//  initialized statically, before any other file's static initializers
+//  (for example self_sym in cool.y) can add strings to them.  A table
+//  may be given predefined strings; they are installed at indices
+//  0..n-1 with their precomputed hashes the first time the table is
+//  used, whichever file (or thread) gets there first.
+//
+//////////////////////////////////////////////////////////////////////////
+
+template <class Elem>
+class StringTable
+{
+protected:
+   enum {
+     SHARD_BITS = 4,
+     NSHARDS = 1 << SHARD_BITS,
+     SEG0_BITS = 6,             // segment k holds 64 << k entries
+     NSEGS = 25                 // room for 64 * (2^25 - 1) entries
+   };
+
+   // One generation of a shard's hash index.
+   struct Slots {
+     int size;                  // a power of two
+     Slots *older;              // retired generations, freed with the table
+     std::atomic<Elem *> slot[1];   // really size of them; NULL if empty
+   };
+
+   struct Shard {
+     std::mutex lock;           // held while inserting
+     std::atomic<Slots *> slots;
+     int count;                 // entries in this shard
+     StringArena arena;         // storage for the entries and their text
+     constexpr Shard() : slots(NULL), count(0) { }
+   };
+
+   struct Segment {
+     std::atomic<std::atomic<Elem *> *> cells;   // NULL until needed
+     constexpr Segment() : cells(NULL) { }
+   };
+
+   Shard shards[NSHARDS];
+   Segment segments[NSEGS];
+   std::atomic<int> index;      // the next index
+   std::atomic<bool> installed; // are the predefined strings in?
+   std::mutex install_lock;
+   const PredefEntry *predef;   // strings that own the first indices
+   int npredef;
+
+   static Shard& shard_of(Shard *s, unsigned h)
+     { return s[h >> (32 - SHARD_BITS)]; }
+   static Slots *new_slots(int size);
+   std::atomic<Elem *> &entry_ref(int i);
+   Elem *find(Shard& sh, char *s, int len, unsigned h);
+   Elem *insert(Shard& sh, char *s, int len, unsigned h);
+   Elem *intern(char *s, int len, unsigned h);
+   void install_predefined();
+   void ready()
+     { if (!installed.load(std::memory_order_acquire)) install_predefined(); }
+public:
+   constexpr StringTable(const PredefEntry *p = NULL, int n = 0) :
+      shards(), segments(), index(0), installed(n == 0),
+      predef(p), npredef(n) { }
+   ~StringTable();
+   StringTable(const StringTable&) = delete;
+   StringTable& operator=(const StringTable&) = delete;
+   // The following methods each add a string to the string table.
+   // Only one copy of each string is maintained.
+   // Returns a pointer to the string table entry with the string.
+
+   // add the prefix of s of length maxchars
+   Elem *add_string(char *s, int maxchars);
+
+   // add the (null terminated) string s
+   Elem *add_string(char *s);
+
+   // add the string representation of an integer
+   Elem *add_int(int i);
+
+
+   // An iterator.
+   int first();       // first index
+   int more(int i);   // are there more indices?
+   int next(int i);   // next index
+
+   Elem *lookup(int index);      // lookup an element using its index
+   Elem *lookup_string(char *s); // lookup an element using its string
+
+   void print();  // print the entire table; for debugging
+
+};
+
+class IdTable : public StringTable<IdEntry>
+{
+public:
+   constexpr IdTable() :
+      StringTable<IdEntry>(predefined_symbols, PREDEF_COUNT) { }
+};
+
+class StrTable : public StringTable<StringEntry>
+{
+public:
+   void code_string_table(ostream&, int classtag);
+};
+
+class IntTable : public StringTable<IntEntry>
+{
+public:
+   void code_string_table(ostream&, int classtag);
+};
+
+extern IdTable idtable;
+extern IntTable inttable;
+extern StrTable stringtable;
+
+inline Symbol predef_symbol(PredefSymbol p)
+{
+   return idtable.lookup(p);
+}
+
+// the PredefSymbol for sym, or PREDEF_COUNT if sym is not predefined
+inline PredefSymbol predef_id(Symbol sym)
+{
+   int i = sym->get_index();
+   if (i < PREDEF_COUNT && idtable.lookup(i) == sym)
+      return (PredefSymbol) i;
+   return PREDEF_COUNT;
+}
+#endif
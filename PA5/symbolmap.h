@@ -0,0 +1,81 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _SYMBOLMAP_H_
+#define _SYMBOLMAP_H_
+
+#include <vector>
+#include "stringtab.h"
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  Symbol Maps
+//
+//  A SymbolMap<T> associates a T with symbols of one string table.  The
+//  index every Entry carries is dense (0, 1, 2, ... in insertion order),
+//  so the map is just an array indexed by sym->get_index() and every
+//  operation is a bounds check and a load.  The array grows on demand
+//  to the largest index stored.
+//
+//  Indices are only unique within a table; all keys of one map must
+//  come from the same table, normally idtable (class, method and
+//  attribute names).
+//
+/////////////////////////////////////////////////////////////////////////
+
+template <class T>
+class SymbolMap {
+private:
+  std::vector<T> values;
+  std::vector<char> present;   // present[i] iff index i has a value
+
+  void reserve_index(int i)
+  {
+    if (i >= (int) values.size()) {
+      values.resize(i + 1);
+      present.resize(i + 1, 0);
+    }
+  }
+public:
+  // the value for sym, or NULL if there is none
+  T *find(Symbol sym)
+  {
+    int i = sym->get_index();
+    return i < (int) present.size() && present[i] ? &values[i] : NULL;
+  }
+
+  const T *find(Symbol sym) const
+  {
+    int i = sym->get_index();
+    return i < (int) present.size() && present[i] ? &values[i] : NULL;
+  }
+
+  bool contains(Symbol sym) const { return find(sym) != NULL; }
+
+  // the value for sym, inserting a default-constructed one if needed
+  T& operator[](Symbol sym)
+  {
+    int i = sym->get_index();
+    reserve_index(i);
+    present[i] = 1;
+    return values[i];
+  }
+
+  void insert(Symbol sym, const T& value) { (*this)[sym] = value; }
+
+  void erase(Symbol sym)
+  {
+    int i = sym->get_index();
+    if (i < (int) present.size()) {
+      present[i] = 0;
+      values[i] = T();
+    }
+  }
+
+  void clear() { values.clear(); present.clear(); }
+};
+
+#endif
@@ -0,0 +1,446 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef TREE_H
+#define TREE_H
+///////////////////////////////////////////////////////////////////////////
+//
+// file: tree.h
+//
+// This file defines the basic class of tree node and list
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "stringtab.h"
+extern char *pad(int);
+#include "cool-io.h"
+
+class tree_node;
+
+/////////////////////////////////////////////////////////////////////
+//
+//  NodeArena
+//
+//   Tree nodes are not allocated one by one, but carved out of large
+//   blocks belonging to a NodeArena, so the nodes of one compilation
+//   lie together in memory and are freed together.  Nodes are never
+//   deleted one at a time.
+//
+//   A thread allocates its nodes from the arena it has in use, made so
+//   by a NodeArena::Use for as long as that is in scope; a thread with
+//   none uses an arena of its own that is never released, which is
+//   what became of every node before there were arenas.
+//
+//       allocate(size)      memory for a node of this size
+//       must_destroy(t)     run t's destructor on release (for nodes
+//                           that own memory of their own, the lists)
+//       adopt(a)            take over the nodes of arena a, which is
+//                           left empty; several threads may adopt into
+//                           one arena at once
+//       release()           destroy every node and free the blocks;
+//                           the arena can then be used again
+//       bytes()             the size of the blocks held
+//       find_leaf(k, v)     a leaf of kind k and value v made on the
+//                           current line (node_lineno) and kept with
+//                           keep_leaf, or NULL
+//       keep_leaf(k, v, t)  keep leaf t to be found by find_leaf
+//
+//   Threads that build nodes for a compilation use an arena each and
+//   hand their nodes over to the compilation's arena with adopt().
+//   Leaves are only found in the arena they were kept in.
+//
+/////////////////////////////////////////////////////////////////////
+
+class NodeArena {
+private:
+    enum { block_size = 64 * 1024,
+	   align = alignof(max_align_t) };
+    std::vector<char *> blocks;
+    std::vector<tree_node *> destroy;
+    char *next;                 // free space in the last ordinary block
+    size_t left;
+    size_t held;                // bytes in blocks
+    std::mutex adopting;
+    static thread_local NodeArena *in_use;
+
+    struct Leaf {
+	int kind, value, line;
+	bool operator==(const Leaf& l) const
+	    { return kind == l.kind && value == l.value && line == l.line; }
+    };
+    struct LeafHash {
+	size_t operator()(const Leaf& l) const
+	    { return ((size_t) l.line * 31 + l.value) * 31 + l.kind; }
+    };
+    std::unordered_map<Leaf, tree_node *, LeafHash> leaves;
+
+    void *allocate_block(size_t size);
+    static NodeArena *thread_arena();
+public:
+    NodeArena() : next(NULL), left(0), held(0) { }
+    ~NodeArena() { release(); }
+
+    void *allocate(size_t size) {
+	size = (size + align - 1) & ~(size_t) (align - 1);
+	if (size > left)
+	    return allocate_block(size);
+	void *p = next;
+	next += size;
+	left -= size;
+	return p;
+    }
+    void must_destroy(tree_node *t) { destroy.push_back(t); }
+    void adopt(NodeArena& a);
+    void release();
+    size_t bytes() { return held; }
+    tree_node *find_leaf(int kind, int value);
+    void keep_leaf(int kind, int value, tree_node *t);
+
+    static NodeArena *current() { return in_use ? in_use : thread_arena(); }
+
+    class Use {
+	NodeArena *outer;
+    public:
+	Use(NodeArena *a) : outer(in_use) { in_use = a; }
+	~Use() { in_use = outer; }
+    };
+};
+
+
+/////////////////////////////////////////////////////////////////////
+//
+//  NodeKind
+//
+//   Every node is tagged with what kind of node it is, so a pass can
+//   dispatch on the kind with a switch rather than through a virtual
+//   function of its own in every node class (see treewalk.h).  The
+//   constructors of cool-tree.h set it; NODE_list is every list.
+//
+/////////////////////////////////////////////////////////////////////
+
+enum NodeKind : unsigned char {
+    NODE_program, NODE_class_, NODE_method, NODE_attr, NODE_formal,
+    NODE_branch,
+    // the expressions
+    NODE_assign, NODE_static_dispatch, NODE_dispatch, NODE_cond, NODE_loop,
+    NODE_typcase, NODE_block, NODE_let, NODE_plus, NODE_sub, NODE_mul,
+    NODE_divide, NODE_neg, NODE_lt, NODE_eq, NODE_leq, NODE_comp,
+    NODE_int_const, NODE_bool_const, NODE_string_const, NODE_new_,
+    NODE_isvoid, NODE_no_expr, NODE_object,
+    NODE_list,
+    NODE_KIND_COUNT
+};
+
+inline bool is_expression_kind(int k)
+{
+    return k >= NODE_assign && k <= NODE_object;
+}
+
+
+/////////////////////////////////////////////////////////////////////
+//
+//  tree_node
+//
+//   All APS nodes are derived from tree_node.  There are
+//   protected fields:
+//       int line_number     line in the source file from which this node came;
+//                           this is usually set by the parser
+//       NodeKind kind       what the node is
+//       shares              how many more than one node hold this one;
+//                           once it reaches SHARES_MAX it stays there
+//   and methods:
+//       tree_node()         constructor.  tree nodes are made in the parser
+//                           and line_number is set to the current line
+//       copy()              a virtual function that copies a tree_node;
+//                           copying is done by each subclass of tree_node
+//       dump()              print a description of the node on the output;
+//       get_line_number()   returns the line number of the tree node
+//       set(tree_node*)     sets the line number from another node
+//       get_kind()          returns the kind of the node
+//       share()             counts one more holder of the node
+//       unshare()           counts one less
+//       is_shared()         true if more than one node holds the node
+//
+//   Tree nodes are allocated from the current NodeArena.
+//
+//   A copy of a node has the node's line number (and type) but shares
+//   its children, which are counted as having one more holder, rather
+//   than copies of them; so a copy of a whole program is a new program
+//   node.  A shared node is not to be changed, as all the trees that
+//   hold it would see the change.  A pass that changes a tree it may
+//   share with another calls own() on each child it goes down to, which
+//   puts a copy of the child in its place if it is shared; so the path
+//   down to a change is all that is copied, and only once.  Setting the
+//   type of a shared expression likewise sets it on a copy, which is
+//   returned, unless the expression has that type already (see
+//   cool-tree.handcode.h).  A count too big for its 24
+//   bits sticks at SHARES_MAX, so a node held that many times is taken
+//   to be shared for good and is copied, never changed.
+//
+/////////////////////////////////////////////////////////////////////
+
+class tree_node {
+protected:
+    int line_number;            // stash the line number when node is made
+    NodeKind kind;
+    unsigned shares : 24;       // fits beside kind
+public:
+    enum { SHARES_MAX = (1 << 24) - 1 };
+    tree_node();
+    virtual tree_node *copy() = 0;
+    virtual ~tree_node() { }
+    virtual void dump(ostream& stream, int n) = 0;
+    int get_line_number();
+    tree_node *set(tree_node *);
+    NodeKind get_kind() const   { return kind; }
+    void share()                { if (shares != SHARES_MAX) shares++; }
+    void unshare()              { if (shares != SHARES_MAX) shares--; }
+    bool is_shared() const      { return shares != 0; }
+
+    static void *operator new(size_t size)
+	{ return NodeArena::current()->allocate(size); }
+    static void operator delete(void *) { }
+};
+
+
+//
+// own(slot) makes the child of a node in slot, a field or list element
+// of a node that is not shared, its own to change, and returns it.
+//
+template <class T> T own(T& slot)
+{
+    if (slot->is_shared()) {
+	slot->unshare();
+	slot = static_cast<T>(slot->copy());
+    }
+    return slot;
+}
+
+
+///////////////////////////////////////////////////////////////////
+//
+//  Lists of APS objects are implemented by the "list_node"
+//  template.  Each list element has type Elem.  The interface is:
+//
+//    tree_node *copy()
+//    list_node<Elem> *copy_list()
+//                             return a copy of the list, which shares
+//                             its elements
+//
+//    Elem nth(int n)          returns the nth element of a list.  If the
+//                             list has fewer than n elements, an error
+//                             is generated.
+//    Elem own_nth(int n)      own() the nth element of a list
+//    int first()              returns the index of the first element
+//    int next(int n)          returns the next index after n
+//    int more(int n)          true if n is a legal index
+//    int len()                return the length of the list
+//
+//    nil() construct an empty list
+//    single(Elem x) construct a list of one element x
+//    append(list_node<Elem> *l1,list_node<Elem> *l2)
+//                             concatenates two lists l1 and l2 by
+//                             adding the elements of l2 to the end of
+//                             l1, which is returned; l2 is unchanged.
+//                             If l1 is shared, a copy of it is used.
+//                             The elements added are share()d, as l2
+//                             still holds them.
+//                             l1 itself is changed, not copied: use
+//                             the list returned in its place, as in
+//                             l = append(l, single(x)), and do not
+//                             hold on to l1 to see it as it was.
+//    make(Shape s, elems)     construct a list of the given elements
+//                             that dumps as a list of shape s would;
+//                             each element is share()d, as whatever
+//                             it was taken from still holds it
+//
+//  A list keeps its elements in one array, so nth() is constant time
+//  and append() is in the length of l2 only (amortized).  Since the
+//  parser builds every list by appending one element at a time to
+//  the list so far, which it then drops, this is what it wants.
+//  Before, append() made a new list and left l1 as it was.  Every
+//  caller of append() and the append_X() interfaces (cool-tree.h)
+//  keeps only the list it gets back: cool.y, ast-parse.cc, pratt.cc
+//  and parser-phase.cc put it where l1 was, and semant's basic
+//  classes append to lists made on the spot.  A caller that needs l1
+//  as it was appends to l1->copy_list() instead.
+//
+//  nil_node, single_list_node and append_node are kept as the ways
+//  of making a list; an append_node is a new list with copies of the
+//  elements of both of its arguments, which it shares with them.  How a list was made (its
+//  shape) is remembered only so that dump() prints it as it always
+//  has: "(nil)", the element alone, or "list" ... "(end_of_list)".
+//
+///////////////////////////////////////////////////////////////////
+
+template <class Elem>
+class list_node : public tree_node {
+public:
+    enum Shape { Nil, Single, Append };
+protected:
+    std::vector<Elem> elems;
+    Shape shape;
+    list_node(Shape s) : shape(s) {
+	this->kind = NODE_list;
+	NodeArena::current()->must_destroy(this);
+    }
+public:
+    tree_node *copy()            { return copy_list(); }
+    list_node<Elem> *copy_list();
+    Elem nth(int n);
+    Elem own_nth(int n)          { nth(n); return own(elems[n]); }
+    int len()                    { return (int) elems.size(); }
+    Shape get_shape()            { return shape; }
+    void dump(ostream& stream, int n);
+
+    static list_node<Elem> *nil();
+    static list_node<Elem> *single(Elem);
+    static list_node<Elem> *append(list_node<Elem> *l1,list_node<Elem> *l2);
+    static list_node<Elem> *make(Shape s, const std::vector<Elem>& elems);
+
+    int first()      { return 0; }
+    int next(int n)  { return n + 1; }
+    int more(int n)  { return (n < len()); }
+};
+
+extern int info_size;
+
+template <class Elem>
+class nil_node : public list_node<Elem> {
+public:
+    nil_node() : list_node<Elem>(list_node<Elem>::Nil) { }
+};
+
+template <class Elem>
+class single_list_node : public list_node<Elem> {
+public:
+    single_list_node(Elem t) : list_node<Elem>(list_node<Elem>::Single) {
+	this->elems.push_back(t);
+    }
+};
+
+template <class Elem>
+class append_node : public list_node<Elem> {
+public:
+    append_node(list_node<Elem> *l1, list_node<Elem> *l2)
+	: list_node<Elem>(list_node<Elem>::Append) {
+	this->elems.reserve(l1->len() + l2->len());
+	for (int i = 0; i < l1->len(); i++)
+	    this->elems.push_back(l1->nth(i));
+	for (int i = 0; i < l2->len(); i++)
+	    this->elems.push_back(l2->nth(i));
+	for (int i = 0; i < this->len(); i++)
+	    this->elems[i]->share();
+    }
+};
+
+template <class Elem> single_list_node<Elem> *list(Elem x);
+template <class Elem> append_node<Elem> *cons(Elem x, list_node<Elem> *l);
+template <class Elem> append_node<Elem> *xcons(list_node<Elem> *l, Elem x);
+
+///////////////////////////////////////////////////////////////////////////
+//
+// list_node::nil
+//
+// Create an empty list.
+//
+///////////////////////////////////////////////////////////////////////////
+template <class Elem> list_node<Elem> *list_node<Elem>::nil()
+{
+    return new nil_node<Elem>();
+}
+
+template <class Elem> list_node<Elem> *list_node<Elem>::single(Elem e)
+{
+    return new single_list_node<Elem>(e);
+}
+
+template <class Elem> list_node<Elem> *list_node<Elem>::append(list_node<Elem> *l1, list_node<Elem> *l2)
+{
+    if (l1->is_shared())
+	l1 = l1->copy_list();
+    int n = l1->len();
+    if (l1 == l2) {
+	std::vector<Elem> tail(l2->elems);
+	l1->elems.insert(l1->elems.end(), tail.begin(), tail.end());
+    } else
+	l1->elems.insert(l1->elems.end(), l2->elems.begin(), l2->elems.end());
+    for (int i = n; i < l1->len(); i++)
+	l1->elems[i]->share();
+    l1->shape = Append;
+    return l1;
+}
+
+template <class Elem> list_node<Elem> *list_node<Elem>::make(Shape s, const std::vector<Elem>& elems)
+{
+    list_node<Elem> *l = new list_node<Elem>(s);
+    l->elems = elems;
+    for (int i = 0; i < l->len(); i++)
+	l->elems[i]->share();
+    return l;
+}
+
+template <class Elem> Elem list_node<Elem>::nth(int n)
+{
+    if (n >= 0 && n < len())
+	return elems[n];
+    else {
+	cerr << "error: outside the range of the list\n";
+	exit(1);
+    }
+}
+
+template <class Elem> list_node<Elem> *list_node<Elem>::copy_list()
+{
+    list_node<Elem> *l = new list_node<Elem>(shape);
+    l->set(this);
+    l->elems = elems;
+    for (int i = 0; i < len(); i++)
+	elems[i]->share();
+    return l;
+}
+
+template <class Elem> void list_node<Elem>::dump(ostream& stream, int n)
+{
+    int i, size;
+
+    switch (shape) {
+    case Nil:
+	stream << pad(n) << "(nil)\n";
+	break;
+    case Single:
+	elems[0]->dump(stream, n);
+	break;
+    case Append:
+	size = len();
+	stream << pad(n) << "list\n";
+	for (i = 0; i < size; i++)
+	    elems[i]->dump(stream, n+2);
+	stream << pad(n) << "(end_of_list)\n";
+	break;
+    }
+}
+
+template <class Elem> single_list_node<Elem> *list(Elem x)
+{
+    return new single_list_node<Elem>(x);
+}
+
+template <class Elem> append_node<Elem> *cons(Elem x, list_node<Elem> *l)
+{
+    return new append_node<Elem>(list(x), l);
+}
+
+template <class Elem> append_node<Elem> *xcons(list_node<Elem> *l, Elem x)
+{
+    return new append_node<Elem>(l, list(x));
+}
+
+#endif /* TREE_H */